@@ -8,22 +8,48 @@
 //  Usage:
 //
 //  coder::array<T, N>: T base type of data, N number of dimensions
+//  coder::basic_array<T, N, Alloc, InlineCap>
+//               : Alloc allocator of the data, InlineCap number of elements
+//               : stored in the array object itself (no allocation needed.)
+//               : The defaults are CODER_ARRAY_ALLOCATOR<T> and
+//               : CODER_ARRAY_INLINE_CAPACITY, which coder::array also uses.
+//               : coder::array keeps its two template parameters so that
+//               : its mangled name does not depend on these settings.
+//
+//  An allocator is a class with the static member functions
+//    T* allocate(SizeType n)
+//               : Return memory for n constructed elements.
+//    void deallocate(T *p, SizeType n)
+//               : Release memory returned by allocate(n).
+//    SizeType grow(SizeType capacity, SizeType n)
+//               : Capacity to allocate when an array of the given capacity
+//               : is resized to n > capacity elements.
+//  Allocators are stateless; per-thread arenas are reached from the static
+//  functions, for example through a thread-local pointer set by the thread.
 //
 //  coder::array()
 //               : default constructor
 //  coder::array(const coder::array &)
 //               : copy constructor (always make a deep copy of other array)
+//  coder::array(coder::array &&)
+//               : move constructor (C++11; take over the data of other array
+//               : and leave it empty)
 //  coder::array(const T *data, const SizeType *sz)
 //               : Set data with sizes of this array.
 //               : (Data is not copied, data is not deleted)
 //  coder::array::operator = (coder coder::array &)
 //               : Assign into this array;
+//               : reuse its memory if large enough, otherwise
 //               : delete its previous contents (if owning the data.)
+//  coder::array::operator = (coder::array &&)
+//               : Move assign into this array (C++11); the data of an
+//               : owning array is taken over, other data is copied.
 //  set(const T *data, SizeType sz1, SizeType sz2, ...)
 //               : Set data with dimensions.
 //               : (Data is not copied, data is not deleted)
 //  set_size(SizeType sz1, SizeType sz2, ...)
 //               : Set sizes of array. Reallocate memory of data if needed.
+//               : Memory is never released when the array shrinks.
 //  bool is_owner() : Return true if the data is owned by the class.
 //  void set_owner(b) : Set if the data is owned by the class.
 //  SizeType capacity() : How many entries are reserved by memory allocation.
@@ -40,12 +66,28 @@
 //               : Compute the linear index from ND index (i1,i2,...)
 //  at(SizeType i1, SizeType i2, ...) : The element at index (i1,i2,...)
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <iterator>
 #include <string>
 #include <vector>
 
+// Move semantics are available when the compiler supports C++11.  Define
+// CODER_ARRAY_ENABLE_MOVE to 0 or 1 to override the detection.
+#ifndef CODER_ARRAY_ENABLE_MOVE
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#define CODER_ARRAY_ENABLE_MOVE 1
+#else
+#define CODER_ARRAY_ENABLE_MOVE 0
+#endif
+#endif
+
+#if CODER_ARRAY_ENABLE_MOVE
+#include <type_traits>
+#include <utility>
+#endif
+
 #ifndef INT32_T
 #include "rtwtypes.h"
 #endif
@@ -60,11 +102,120 @@ namespace coder {
 
 typedef int32_T SizeType;
 
+// Default allocator of coder::array.  Memory comes from CODER_NEW and
+// CODER_DELETE; a growing array gets at least 16 elements and doubles its
+// capacity.
+template <typename T>
+struct heap_allocator {
+    static T* allocate(SizeType _n) {
+        return CODER_NEW(T, _n);
+    }
+    static void deallocate(T* _p, SizeType) {
+        CODER_DELETE(_p);
+    }
+    static SizeType grow(SizeType _capacity, SizeType _n) {
+        SizeType i = _capacity < 16 ? 16 : _capacity;
+        while (i < _n) {
+            if (i > 1073741823) {
+                i = MAX_int32_T;
+            } else {
+                i <<= 1;
+            }
+        }
+        return i;
+    }
+};
+
+// Allocator and inline capacity of coder::array, and of coder::basic_array
+// when they are not given as template arguments.  CODER_ARRAY_ALLOCATOR names
+// a class template that takes the element type.
+#ifndef CODER_ARRAY_ALLOCATOR
+#define CODER_ARRAY_ALLOCATOR ::coder::heap_allocator
+#endif
+
+#ifndef CODER_ARRAY_INLINE_CAPACITY
+#define CODER_ARRAY_INLINE_CAPACITY 0
+#endif
+
 namespace detail {
 
 #ifndef CODER_ARRAY_DATA_PTR_DEFINED
-template <typename T, typename SZ>
-class data_ptr {
+// detail::is_trivial<T>: True if elements of type T can be copied with memcpy
+// and need no construction, so new T[n] leaves them uninitialized.
+template <typename T>
+struct is_trivial {
+#if CODER_ARRAY_ENABLE_MOVE
+    static const bool value = std::is_trivial<T>::value;
+#else
+    static const bool value = false;
+#endif
+};
+
+// detail::elements<Trivial>: Copy element ranges between buffers.  copy may
+// be used with overlapping ranges if _dst is before _src.  relocate moves the
+// elements to a new buffer; the source elements are destroyed afterwards.
+template <bool Trivial>
+struct elements {
+    template <typename T, typename SZ>
+    static void copy(const T* _src, SZ _n, T* _dst) {
+        std::copy(_src, _src + _n, _dst);
+    }
+    template <typename T, typename SZ>
+    static void relocate(T* _src, SZ _n, T* _dst) {
+#if CODER_ARRAY_ENABLE_MOVE
+        std::move(_src, _src + _n, _dst);
+#else
+        std::copy(_src, _src + _n, _dst);
+#endif
+    }
+};
+
+template <>
+struct elements<true> {
+    template <typename T, typename SZ>
+    static void copy(const T* _src, SZ _n, T* _dst) {
+        if (_n > 0) {
+            std::memmove(_dst, _src, sizeof(T) * static_cast<size_t>(_n));
+        }
+    }
+    template <typename T, typename SZ>
+    static void relocate(T* _src, SZ _n, T* _dst) {
+        if (_n > 0) {
+            std::memcpy(_dst, _src, sizeof(T) * static_cast<size_t>(_n));
+        }
+    }
+};
+
+// detail::inline_buffer<T, Cap>: Storage for the first Cap elements of an
+// array, so that short arrays need no allocation.  The elements are not
+// copied with the array; data_ptr copies the used part itself.
+template <typename T, int Cap>
+class inline_buffer {
+  protected:
+    inline_buffer() {
+    }
+    inline_buffer(const inline_buffer&) {
+    }
+    T* inline_data() {
+        return buffer_;
+    }
+
+  private:
+    void operator=(const inline_buffer&);
+
+    T buffer_[Cap];
+};
+
+template <typename T>
+class inline_buffer<T, 0> {
+  protected:
+    T* inline_data() {
+        return NULL;
+    }
+};
+
+template <typename T, typename SZ, typename Alloc = heap_allocator<T>, int InlineCap = 0>
+class data_ptr : private inline_buffer<T, InlineCap> {
   public:
     typedef T value_type;
     typedef SZ size_type;
@@ -83,33 +234,63 @@ class data_ptr {
     }
 
     data_ptr(const data_ptr& _other)
-        : data_(_other.owner_ ? NULL : _other.data_)
+        : inline_buffer<T, InlineCap>()
+        , data_(_other.owner_ ? NULL : _other.data_)
         , size_(_other.owner_ ? 0 : _other.size_)
         , capacity_(_other.owner_ ? 0 : _other.capacity_)
         , owner_(_other.owner_) {
         if (owner_) {
             resize(_other.size_);
-            std::copy(_other.data_, _other.data_ + size_, data_);
+            copier::copy(_other.data_, size_, data_);
         }
     }
 
-    ~data_ptr() {
-        if (owner_) {
-            CODER_DELETE(data_);
+#if CODER_ARRAY_ENABLE_MOVE
+    data_ptr(data_ptr&& _other) noexcept
+        : inline_buffer<T, InlineCap>()
+        , data_(_other.data_)
+        , size_(_other.size_)
+        , capacity_(_other.capacity_)
+        , owner_(_other.owner_) {
+        if (_other.is_inline()) {
+            data_ = this->inline_data();
+            copier::relocate(_other.data_, size_, data_);
+        }
+        _other.release();
+    }
+
+    // Take over owned data; inline or not owned data is copied, as in copy().
+    data_ptr& operator=(data_ptr&& _other) {
+        if (this != &_other) {
+            if (_other.owner_ && !_other.is_inline()) {
+                free_data();
+                data_ = _other.data_;
+                size_ = _other.size_;
+                capacity_ = _other.capacity_;
+                owner_ = true;
+            } else {
+                copy(_other.data_, _other.size_);
+            }
+            _other.release();
         }
+        return *this;
+    }
+#endif
+
+    ~data_ptr() {
+        free_data();
     }
     SZ capacity() const {
         return capacity_;
     }
     void reserve(SZ _n) {
         if (_n > capacity_) {
-            T* new_data = CODER_NEW(T, _n);
-            std::copy(data_, data_ + size_, new_data);
-            if (owner_) {
-                CODER_DELETE(data_);
-            }
+            SZ new_capacity = _n;
+            T* new_data = allocate(new_capacity);
+            copier::relocate(data_, size_, new_data);
+            free_data();
             data_ = new_data;
-            capacity_ = _n;
+            capacity_ = new_capacity;
             owner_ = true;
         }
     }
@@ -120,35 +301,42 @@ class data_ptr {
 
   private:
     // Prohibit use of assignment operator to prevent subtle bugs
-    void operator=(const data_ptr<T, SZ>& _other);
+    void operator=(const data_ptr& _other);
 
   public:
     void set(T* _data, const SZ _sz) {
-        if (owner_) {
-            CODER_DELETE(data_);
-        }
+        free_data();
         data_ = _data;
         size_ = _sz;
         owner_ = false;
         capacity_ = size_;
     }
 
+    // Copy _size elements into owned memory.  The current buffer is reused
+    // unless it is too small or more than 4 times larger than needed, so that
+    // repeated assignments of similar sizes do not allocate.
     void copy(const T* _data, SZ _size) {
         if (data_ == _data) {
             size_ = _size;
             return;
         }
-        if (owner_) {
-            CODER_DELETE(data_);
+        if (owner_ && _size <= capacity_ &&
+            (is_inline() || capacity_ <= KEEP_CAPACITY || _size >= capacity_ / 4)) {
+            copier::copy(_data, _size, data_);
+            size_ = _size;
+            return;
         }
-        data_ = CODER_NEW(T, _size);
+        SZ new_capacity = _size;
+        T* new_data = allocate(new_capacity);
+        copier::copy(_data, _size, new_data);
+        free_data();
+        data_ = new_data;
         owner_ = true;
         size_ = _size;
-        capacity_ = size_;
-        std::copy(_data, _data + _size, data_);
+        capacity_ = new_capacity;
     }
 
-    void copy(const data_ptr<T, SZ>& _other) {
+    void copy(const data_ptr& _other) {
         copy(_other.data_, _other.size_);
     }
 
@@ -180,9 +368,7 @@ class data_ptr {
     }
 
     void clear() {
-        if (owner_) {
-            CODER_DELETE(data_);
-        }
+        free_data();
         data_ = NULL;
         size_ = 0;
         capacity_ = 0;
@@ -193,11 +379,47 @@ class data_ptr {
         return owner_;
     }
 
+    // Data handed over with set_owner(true) must come from Alloc::allocate.
     void set_owner(bool _b) {
         owner_ = _b;
     }
 
   private:
+    typedef elements<is_trivial<T>::value> copier;
+
+    // Buffers of up to this many elements are kept when the data shrinks.
+    static const SZ KEEP_CAPACITY = 16;
+
+    bool is_inline() const {
+        return InlineCap > 0 &&
+               data_ == const_cast<data_ptr*>(this)->inline_data();
+    }
+
+    // Get a buffer for at least _n elements: the inline buffer if it is
+    // large enough and not in use, otherwise memory from the allocator.
+    // _n is updated to the capacity of the buffer.
+    T* allocate(SZ& _n) {
+        if (_n <= InlineCap && !is_inline()) {
+            _n = InlineCap;
+            return this->inline_data();
+        }
+        return Alloc::allocate(_n);
+    }
+
+    void free_data() {
+        if (owner_ && !is_inline()) {
+            Alloc::deallocate(data_, capacity_);
+        }
+    }
+
+    // Forget the data without deleting it.
+    void release() {
+        data_ = NULL;
+        size_ = 0;
+        capacity_ = 0;
+        owner_ = false;
+    }
+
     T* data_;
     SZ size_;
     SZ capacity_;
@@ -458,7 +680,11 @@ struct match_dimensions<true> {
 // Base class for code::array. SZ is the type used for sizes (currently int32_t.)
 // Overloading up to 10 dimensions (not using variadic templates to
 // stay compatible with C++98.)
-template <typename T, typename SZ, int N>
+template <typename T,
+          typename SZ,
+          int N,
+          typename Alloc = heap_allocator<T>,
+          int InlineCap = 0>
 class array_base {
   public:
     typedef T value_type;
@@ -479,6 +705,28 @@ class array_base {
         return *this;
     }
 
+#if CODER_ARRAY_ENABLE_MOVE
+    array_base(const array_base& _other)
+        : data_(_other.data_) {
+        std::copy(_other.size_, _other.size_ + N, size_);
+    }
+
+    array_base(array_base&& _other) noexcept
+        : data_(std::move(_other.data_)) {
+        std::copy(_other.size_, _other.size_ + N, size_);
+        std::memset(_other.size_, 0, sizeof(SZ) * N);
+    }
+
+    array_base& operator=(array_base&& _other) {
+        if (this != &_other) {
+            data_ = std::move(_other.data_);
+            std::copy(_other.size_, _other.size_ + N, size_);
+            std::memset(_other.size_, 0, sizeof(SZ) * N);
+        }
+        return *this;
+    }
+#endif
+
     void set(T* _data, SZ _n1) {
         ::coder::detail::match_dimensions<N == 1>::check();
         data_.set(_data, _n1);
@@ -703,59 +951,59 @@ class array_base {
     }
 
     template <SizeType N1>
-    array_base<T, SZ, N1> reshape_n(const SZ (&_ns)[N1]) const {
-        array_base<T, SZ, N1> reshaped(const_cast<T*>(&data_[0]), _ns);
+    array_base<T, SZ, N1, Alloc, InlineCap> reshape_n(const SZ (&_ns)[N1]) const {
+        array_base<T, SZ, N1, Alloc, InlineCap> reshaped(const_cast<T*>(&data_[0]), _ns);
         return reshaped;
     }
 
-    array_base<T, SZ, 1> reshape(SZ _n1) const {
+    array_base<T, SZ, 1, Alloc, InlineCap> reshape(SZ _n1) const {
         const SZ ns[] = {_n1};
         return reshape_n(ns);
     }
 
-    array_base<T, SZ, 2> reshape(SZ _n1, SZ _n2) const {
+    array_base<T, SZ, 2, Alloc, InlineCap> reshape(SZ _n1, SZ _n2) const {
         const SZ ns[] = {_n1, _n2};
         return reshape_n(ns);
     }
 
-    array_base<T, SZ, 3> reshape(SZ _n1, SZ _n2, SZ _n3) const {
+    array_base<T, SZ, 3, Alloc, InlineCap> reshape(SZ _n1, SZ _n2, SZ _n3) const {
         const SZ ns[] = {_n1, _n2, _n3};
         return reshape_n(ns);
     }
 
-    array_base<T, SZ, 4> reshape(SZ _n1, SZ _n2, SZ _n3, SZ _n4) const {
+    array_base<T, SZ, 4, Alloc, InlineCap> reshape(SZ _n1, SZ _n2, SZ _n3, SZ _n4) const {
         const SZ ns[] = {_n1, _n2, _n3, _n4};
         return reshape_n(ns);
     }
 
-    array_base<T, SZ, 5> reshape(SZ _n1, SZ _n2, SZ _n3, SZ _n4, SZ _n5) const {
+    array_base<T, SZ, 5, Alloc, InlineCap> reshape(SZ _n1, SZ _n2, SZ _n3, SZ _n4, SZ _n5) const {
         const SZ ns[] = {_n1, _n2, _n3, _n4, _n5};
         return reshape_n(ns);
     }
 
-    array_base<T, SZ, 6> reshape(SZ _n1, SZ _n2, SZ _n3, SZ _n4, SZ _n5, SZ _n6) const {
+    array_base<T, SZ, 6, Alloc, InlineCap> reshape(SZ _n1, SZ _n2, SZ _n3, SZ _n4, SZ _n5, SZ _n6) const {
         const SZ ns[] = {_n1, _n2, _n3, _n4, _n5, _n6};
         return reshape_n(ns);
     }
 
-    array_base<T, SZ, 7> reshape(SZ _n1, SZ _n2, SZ _n3, SZ _n4, SZ _n5, SZ _n6, SZ _n7) const {
+    array_base<T, SZ, 7, Alloc, InlineCap> reshape(SZ _n1, SZ _n2, SZ _n3, SZ _n4, SZ _n5, SZ _n6, SZ _n7) const {
         const SZ ns[] = {_n1, _n2, _n3, _n4, _n5, _n6, _n7};
         return reshape_n(ns);
     }
 
-    array_base<T, SZ, 8> reshape(SZ _n1, SZ _n2, SZ _n3, SZ _n4, SZ _n5, SZ _n6, SZ _n7, SZ _n8)
+    array_base<T, SZ, 8, Alloc, InlineCap> reshape(SZ _n1, SZ _n2, SZ _n3, SZ _n4, SZ _n5, SZ _n6, SZ _n7, SZ _n8)
         const {
         const SZ ns[] = {_n1, _n2, _n3, _n4, _n5, _n6, _n7, _n8};
         return reshape_n(ns);
     }
 
-    array_base<T, SZ, 9>
+    array_base<T, SZ, 9, Alloc, InlineCap>
     reshape(SZ _n1, SZ _n2, SZ _n3, SZ _n4, SZ _n5, SZ _n6, SZ _n7, SZ _n8, SZ _n9) const {
         const SZ ns[] = {_n1, _n2, _n3, _n4, _n5, _n6, _n7, _n8, _n9};
         return reshape_n(ns);
     }
 
-    array_base<T, SZ, 10>
+    array_base<T, SZ, 10, Alloc, InlineCap>
     reshape(SZ _n1, SZ _n2, SZ _n3, SZ _n4, SZ _n5, SZ _n6, SZ _n7, SZ _n8, SZ _n9, SZ _n10) const {
         const SZ ns[] = {_n1, _n2, _n3, _n4, _n5, _n6, _n7, _n8, _n9, _n10};
         return reshape_n(ns);
@@ -928,137 +1176,177 @@ class array_base {
         return data_[index(_i1, _i2, _i3, _i4, _i5, _i6, _i7, _i8, _i9, _i10)];
     }
 
-    array_iterator<array_base<T, SZ, N> > begin() {
-        return array_iterator<array_base<T, SZ, N> >(this, 0);
+    array_iterator<array_base<T, SZ, N, Alloc, InlineCap> > begin() {
+        return array_iterator<array_base<T, SZ, N, Alloc, InlineCap> >(this, 0);
     }
-    array_iterator<array_base<T, SZ, N> > end() {
-        return array_iterator<array_base<T, SZ, N> >(this, this->numel());
+    array_iterator<array_base<T, SZ, N, Alloc, InlineCap> > end() {
+        return array_iterator<array_base<T, SZ, N, Alloc, InlineCap> >(this, this->numel());
     }
-    const_array_iterator<array_base<T, SZ, N> > begin() const {
-        return const_array_iterator<array_base<T, SZ, N> >(this, 0);
+    const_array_iterator<array_base<T, SZ, N, Alloc, InlineCap> > begin() const {
+        return const_array_iterator<array_base<T, SZ, N, Alloc, InlineCap> >(this, 0);
     }
-    const_array_iterator<array_base<T, SZ, N> > end() const {
-        return const_array_iterator<array_base<T, SZ, N> >(this, this->numel());
+    const_array_iterator<array_base<T, SZ, N, Alloc, InlineCap> > end() const {
+        return const_array_iterator<array_base<T, SZ, N, Alloc, InlineCap> >(this, this->numel());
     }
 
   protected:
+#ifndef CODER_ARRAY_DATA_PTR_DEFINED
+    ::coder::detail::data_ptr<T, SZ, Alloc, InlineCap> data_;
+#else
     ::coder::detail::data_ptr<T, SZ> data_;
+#endif
     SZ size_[N];
 
   private:
     void ensureCapacity(SZ _newNumel) {
         if (_newNumel > data_.capacity()) {
-            SZ i = data_.capacity();
-            if (i < 16) {
-                i = 16;
-            }
-
-            while (i < _newNumel) {
-                if (i > 1073741823) {
-                    i = MAX_int32_T;
-                } else {
-                    i <<= 1;
-                }
+            if (_newNumel <= InlineCap) {
+                data_.reserve(_newNumel);
+            } else {
+                data_.reserve(static_cast<SZ>(Alloc::grow(data_.capacity(), _newNumel)));
             }
-            data_.reserve(i);
         }
         data_.resize(_newNumel);
     }
 };
 
-// The standard coder::array class with base type and number of dimensions.
-template <typename T, int N>
-class array : public array_base<T, SizeType, N> {
+// coder::array with a configurable allocator and inline capacity.
+template <typename T,
+          int N,
+          typename Alloc = CODER_ARRAY_ALLOCATOR<T>,
+          int InlineCap = CODER_ARRAY_INLINE_CAPACITY>
+class basic_array : public array_base<T, SizeType, N, Alloc, InlineCap> {
   private:
-    typedef array_base<T, SizeType, N> Base;
+    typedef array_base<T, SizeType, N, Alloc, InlineCap> Base;
 
   public:
-    array()
+    basic_array()
         : Base() {
     }
-    array(const array<T, N>& _other)
+    basic_array(const basic_array& _other)
         : Base(_other) {
     }
-    array(const Base& _other)
+    basic_array(const Base& _other)
         : Base(_other) {
     }
-    array(T* _data, const SizeType* _sz)
+#if CODER_ARRAY_ENABLE_MOVE
+    basic_array(basic_array&& _other) noexcept
+        : Base(std::move(_other)) {
+    }
+    basic_array& operator=(const basic_array& _other) {
+        Base::operator=(_other);
+        return *this;
+    }
+    basic_array& operator=(basic_array&& _other) {
+        Base::operator=(std::move(_other));
+        return *this;
+    }
+#endif
+    basic_array(T* _data, const SizeType* _sz)
         : Base(_data, _sz) {
     }
 };
 
 // Specialize on char_T (row vector) for better support on strings.
-template <>
-class array<char_T, 2> : public array_base<char_T, SizeType, 2> {
+template <typename Alloc, int InlineCap>
+class basic_array<char_T, 2, Alloc, InlineCap>
+    : public array_base<char_T, SizeType, 2, Alloc, InlineCap> {
   private:
-    typedef array_base<char_T, SizeType, 2> Base;
+    typedef array_base<char_T, SizeType, 2, Alloc, InlineCap> Base;
 
   public:
-    array()
-        : array_base() {
+    basic_array()
+        : Base() {
     }
-    array(const array<char_T, 2>& _other)
+    basic_array(const basic_array& _other)
         : Base(_other) {
     }
-    array(const Base& _other)
+    basic_array(const Base& _other)
         : Base(_other) {
     }
+#if CODER_ARRAY_ENABLE_MOVE
+    basic_array(basic_array&& _other) noexcept
+        : Base(std::move(_other)) {
+    }
+    basic_array& operator=(const basic_array& _other) {
+        Base::operator=(_other);
+        return *this;
+    }
+    basic_array& operator=(basic_array&& _other) {
+        Base::operator=(std::move(_other));
+        return *this;
+    }
+#endif
 
-    array(const std::string& _str) {
+    basic_array(const std::string& _str) {
         operator=(_str);
     }
 
-    array(const char_T* _str) {
+    basic_array(const char_T* _str) {
         operator=(_str);
     }
 
-    array(const std::vector<char_T>& _vec) {
+    basic_array(const std::vector<char_T>& _vec) {
         SizeType n = static_cast<SizeType>(_vec.size());
-        set_size(1, n);
-        data_.copy(&_vec[0], n);
+        Base::set_size(1, n);
+        Base::data_.copy(&_vec[0], n);
     }
 
-    array& operator=(const std::string& _str) {
+    basic_array& operator=(const std::string& _str) {
         SizeType n = static_cast<SizeType>(_str.size());
-        set_size(1, n);
-        data_.copy(_str.c_str(), n);
+        Base::set_size(1, n);
+        Base::data_.copy(_str.c_str(), n);
         return *this;
     }
 
-    array& operator=(const char_T* _str) {
+    basic_array& operator=(const char_T* _str) {
         SizeType n = static_cast<SizeType>(strlen(_str));
-        set_size(1, n);
-        data_.copy(_str, n);
+        Base::set_size(1, n);
+        Base::data_.copy(_str, n);
         return *this;
     }
 
     operator std::string() const {
-        return std::string(static_cast<const char*>(&(*this)[0]), static_cast<int>(size(1)));
+        return std::string(static_cast<const char*>(&(*this)[0]),
+                           static_cast<int>(Base::size(1)));
     }
 };
 
 // Specialize on 2 dimensions for better support interactions with
 // std::vector and row vectors.
-template <typename T>
-class array<T, 2> : public array_base<T, SizeType, 2> {
+template <typename T, typename Alloc, int InlineCap>
+class basic_array<T, 2, Alloc, InlineCap> : public array_base<T, SizeType, 2, Alloc, InlineCap> {
   private:
-    typedef array_base<T, SizeType, 2> Base;
+    typedef array_base<T, SizeType, 2, Alloc, InlineCap> Base;
 
   public:
-    array()
+    basic_array()
         : Base() {
     }
-    array(const array<T, 2>& _other)
+    basic_array(const basic_array& _other)
         : Base(_other) {
     }
-    array(const Base& _other)
+    basic_array(const Base& _other)
         : Base(_other) {
     }
-    array(const std::vector<T>& _vec) {
+#if CODER_ARRAY_ENABLE_MOVE
+    basic_array(basic_array&& _other) noexcept
+        : Base(std::move(_other)) {
+    }
+    basic_array& operator=(const basic_array& _other) {
+        Base::operator=(_other);
+        return *this;
+    }
+    basic_array& operator=(basic_array&& _other) {
+        Base::operator=(std::move(_other));
+        return *this;
+    }
+#endif
+    basic_array(const std::vector<T>& _vec) {
         operator=(_vec);
     }
 
-    array& operator=(const std::vector<T>& _vec) {
+    basic_array& operator=(const std::vector<T>& _vec) {
         SizeType n = static_cast<SizeType>(_vec.size());
         Base::set_size(1, n);
         Base::data_.copy(&_vec[0], n);
@@ -1073,26 +1361,39 @@ class array<T, 2> : public array_base<T, SizeType, 2> {
 
 // Specialize on 1 dimension for better support with std::vector and
 // column vectors.
-template <typename T>
-class array<T, 1> : public array_base<T, SizeType, 1> {
+template <typename T, typename Alloc, int InlineCap>
+class basic_array<T, 1, Alloc, InlineCap> : public array_base<T, SizeType, 1, Alloc, InlineCap> {
   private:
-    typedef array_base<T, SizeType, 1> Base;
+    typedef array_base<T, SizeType, 1, Alloc, InlineCap> Base;
 
   public:
-    array()
+    basic_array()
         : Base() {
     }
-    array(const array<T, 1>& _other)
+    basic_array(const basic_array& _other)
         : Base(_other) {
     }
-    array(const Base& _other)
+    basic_array(const Base& _other)
         : Base(_other) {
     }
-    array(const std::vector<T>& _vec) {
+#if CODER_ARRAY_ENABLE_MOVE
+    basic_array(basic_array&& _other) noexcept
+        : Base(std::move(_other)) {
+    }
+    basic_array& operator=(const basic_array& _other) {
+        Base::operator=(_other);
+        return *this;
+    }
+    basic_array& operator=(basic_array&& _other) {
+        Base::operator=(std::move(_other));
+        return *this;
+    }
+#endif
+    basic_array(const std::vector<T>& _vec) {
         operator=(_vec);
     }
 
-    array& operator=(const std::vector<T>& _vec) {
+    basic_array& operator=(const std::vector<T>& _vec) {
         SizeType n = static_cast<SizeType>(_vec.size());
         Base::set_size(n);
         Base::data_.copy(&_vec[0], n);
@@ -1105,6 +1406,193 @@ class array<T, 1> : public array_base<T, SizeType, 1> {
     }
 };
 
+// The standard coder::array class with base type and number of dimensions.
+// It is a basic_array with the allocator and inline capacity given by
+// CODER_ARRAY_ALLOCATOR and CODER_ARRAY_INLINE_CAPACITY, declared with
+// two template parameters so that its mangled name does not depend on them.
+template <typename T, int N>
+class array : public basic_array<T, N> {
+  private:
+    typedef basic_array<T, N> Base;
+    typedef array_base<T,
+                       SizeType,
+                       N,
+                       CODER_ARRAY_ALLOCATOR<T>,
+                       CODER_ARRAY_INLINE_CAPACITY>
+        BaseBase;
+
+  public:
+    array()
+        : Base() {
+    }
+    array(const array& _other)
+        : Base(_other) {
+    }
+    array(const Base& _other)
+        : Base(_other) {
+    }
+    array(const BaseBase& _other)
+        : Base(_other) {
+    }
+#if CODER_ARRAY_ENABLE_MOVE
+    array(array&& _other) noexcept
+        : Base(std::move(_other)) {
+    }
+    array& operator=(const array& _other) {
+        Base::operator=(_other);
+        return *this;
+    }
+    array& operator=(array&& _other) {
+        Base::operator=(std::move(_other));
+        return *this;
+    }
+#endif
+    array(T* _data, const SizeType* _sz)
+        : Base(_data, _sz) {
+    }
+    using Base::operator=;
+};
+
+// Specialize on char_T (row vector) for better support on strings.
+template <>
+class array<char_T, 2> : public basic_array<char_T, 2> {
+  private:
+    typedef basic_array<char_T, 2> Base;
+    typedef array_base<char_T,
+                       SizeType,
+                       2,
+                       CODER_ARRAY_ALLOCATOR<char_T>,
+                       CODER_ARRAY_INLINE_CAPACITY>
+        BaseBase;
+
+  public:
+    array()
+        : Base() {
+    }
+    array(const array& _other)
+        : Base(_other) {
+    }
+    array(const Base& _other)
+        : Base(_other) {
+    }
+    array(const BaseBase& _other)
+        : Base(_other) {
+    }
+#if CODER_ARRAY_ENABLE_MOVE
+    array(array&& _other) noexcept
+        : Base(std::move(_other)) {
+    }
+    array& operator=(const array& _other) {
+        Base::operator=(_other);
+        return *this;
+    }
+    array& operator=(array&& _other) {
+        Base::operator=(std::move(_other));
+        return *this;
+    }
+#endif
+    array(const std::string& _str)
+        : Base(_str) {
+    }
+    array(const char_T* _str)
+        : Base(_str) {
+    }
+    array(const std::vector<char_T>& _vec)
+        : Base(_vec) {
+    }
+    using Base::operator=;
+};
+
+// Specialize on 2 dimensions for better support interactions with
+// std::vector and row vectors.
+template <typename T>
+class array<T, 2> : public basic_array<T, 2> {
+  private:
+    typedef basic_array<T, 2> Base;
+    typedef array_base<T,
+                       SizeType,
+                       2,
+                       CODER_ARRAY_ALLOCATOR<T>,
+                       CODER_ARRAY_INLINE_CAPACITY>
+        BaseBase;
+
+  public:
+    array()
+        : Base() {
+    }
+    array(const array& _other)
+        : Base(_other) {
+    }
+    array(const Base& _other)
+        : Base(_other) {
+    }
+    array(const BaseBase& _other)
+        : Base(_other) {
+    }
+#if CODER_ARRAY_ENABLE_MOVE
+    array(array&& _other) noexcept
+        : Base(std::move(_other)) {
+    }
+    array& operator=(const array& _other) {
+        Base::operator=(_other);
+        return *this;
+    }
+    array& operator=(array&& _other) {
+        Base::operator=(std::move(_other));
+        return *this;
+    }
+#endif
+    array(const std::vector<T>& _vec)
+        : Base(_vec) {
+    }
+    using Base::operator=;
+};
+
+// Specialize on 1 dimension for better support with std::vector and
+// column vectors.
+template <typename T>
+class array<T, 1> : public basic_array<T, 1> {
+  private:
+    typedef basic_array<T, 1> Base;
+    typedef array_base<T,
+                       SizeType,
+                       1,
+                       CODER_ARRAY_ALLOCATOR<T>,
+                       CODER_ARRAY_INLINE_CAPACITY>
+        BaseBase;
+
+  public:
+    array()
+        : Base() {
+    }
+    array(const array& _other)
+        : Base(_other) {
+    }
+    array(const Base& _other)
+        : Base(_other) {
+    }
+    array(const BaseBase& _other)
+        : Base(_other) {
+    }
+#if CODER_ARRAY_ENABLE_MOVE
+    array(array&& _other) noexcept
+        : Base(std::move(_other)) {
+    }
+    array& operator=(const array& _other) {
+        Base::operator=(_other);
+        return *this;
+    }
+    array& operator=(array&& _other) {
+        Base::operator=(std::move(_other));
+        return *this;
+    }
+#endif
+    array(const std::vector<T>& _vec)
+        : Base(_vec) {
+    }
+    using Base::operator=;
+};
+
 // Bounded array
 
 template<typename T, SizeType UpperBoundSize, SizeType NumDims> struct bounded_array {
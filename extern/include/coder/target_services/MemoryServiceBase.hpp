@@ -6,6 +6,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include "coder_target_services_spec.h"
+#include "Atomic.hpp"
 #include "SList.hpp"
 #include "StatusFlags.hpp"
 
@@ -52,6 +53,9 @@ public:
     explicit MemoryServiceBase(const uint16_t *poolSizes, uint8_t poolCnt) :
     poolSizes_(poolSizes), poolCount_(poolCnt)
     {
+        allocCount_ = 0;
+        chunkAllocCount_ = 0;
+        failureCount_ = 0;
        
         for (uint8_t i=0; i<poolCount(); ++i) {
             assert(poolSize(i) % sizeof(void*) == 0);
@@ -79,18 +83,40 @@ public:
             if (c == NULL) {
                
                 c = static_cast<Derived*>(this)->allocChunk(poolIdx);
+                if (c != NULL) ++chunkAllocCount_;
             }
         }
 
         if (c != NULL) {
             c->poolIndex(poolIdx);
             c->allocated(true);
+            ++allocCount_;
         } else {
+            ++failureCount_;
             StatusFlags::instance().set(StatusFlags::MEMORY_ALLOCATION_FAILED);
         }
         return c;
     }
 
+    // Allocate up to count chunks for requests of the given size and put
+    // them on the free list, so that later allocations of that size do not
+    // need allocChunk.  Returns the number of chunks added.
+    uint16_t reserve(size_t request, uint16_t count) {
+        uint8_t poolIdx = whichPool(request);
+        uint16_t n = 0;
+        if (poolIdx < poolCount()) {
+            while (n < count) {
+                detail::Chunk *c = static_cast<Derived*>(this)->allocChunk(poolIdx);
+                if (c == NULL) break;
+                c->poolIndex(poolIdx);
+                c->allocated(false);
+                static_cast<Derived*>(this)->pushChunk(c);
+                ++n;
+            }
+        }
+        return n;
+    }
+
     void free(void *p) {
         detail::Chunk *c = reinterpret_cast<detail::Chunk*>(p);
         assert(c != NULL && c->allocated() && c->poolIndex() < poolCount());
@@ -107,9 +133,18 @@ public:
 
     uint16_t maxCapacity() const { return poolSize(poolCount()-1); }
 
+    // Successful allocations, allocations that needed a new chunk because
+    // the free list was empty, and allocations that failed.
+    uint32_t allocCount() const { return allocCount_; }
+    uint32_t chunkAllocCount() const { return chunkAllocCount_; }
+    uint32_t failureCount() const { return failureCount_; }
+
 private:
     const uint16_t *poolSizes_;
     uint8_t poolCount_;
+    typename Atomic<uint32_t>::type allocCount_;
+    typename Atomic<uint32_t>::type chunkAllocCount_;
+    typename Atomic<uint32_t>::type failureCount_;
 
     uint8_t whichPool(size_t requestSize) {
         uint8_t r = 0;
@@ -3,6 +3,8 @@
 #ifndef coder_tgtsvc_MessageAssembler_hpp
 #define coder_tgtsvc_MessageAssembler_hpp
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
 
 namespace coder { namespace tgtsvc {
@@ -15,35 +17,40 @@ struct MessageAssembler
         NO_RESOURCES
     };
 
-    MessageAssembler() : pos_(0) {}
+    MessageAssembler() : pos_(0), noResourcesCount_(0) {}
 
+    // Messages are allocated with Message::alloc, i.e. from the pools of the
+    // memory service.  Whoever takes a message from message() deletes it,
+    // usually the application it is dispatched to, which returns it to the
+    // pool's free list for the next message of that size.
     template <typename Iterator>
     Return assemble(Iterator &it, Iterator end) {
-        while (it != end) {
-
-            while (it != end && pos_ < sizeof(MessageHeader)) {
-                headerAddr()[pos_++] = *it++;
-            }
-            if (pos_ < sizeof(MessageHeader)) break;
+        if (pos_ < sizeof(MessageHeader)) {
+            pos_ += copyIn(it, end, headerAddr() + pos_, sizeof(MessageHeader) - pos_);
+            if (pos_ < sizeof(MessageHeader)) return INCOMPLETE;
+        }
 
+        if (!msg_) {
+            msg_.reset(Message::alloc(hdr_.payloadSize()));
             if (!msg_) {
-                msg_.reset(Message::alloc(hdr_.payloadSize()));
-                if (!msg_) return NO_RESOURCES;
-                msg_->header(hdr_);
+                ++noResourcesCount_;
+                return NO_RESOURCES;
             }
+            msg_->header(hdr_);
+        }
 
-            while (it != end && pos_ < msg_->transmitSize()) {
-                msg_->transmitStart()[pos_++] = *it++;
-            }
+        pos_ += copyIn(it, end, msg_->transmitStart() + pos_, msg_->transmitSize() - pos_);
 
-            if (pos_ == msg_->transmitSize()) {
-                pos_ = 0;
-                return SUCCESS;
-            }
+        if (pos_ == msg_->transmitSize()) {
+            pos_ = 0;
+            return SUCCESS;
         }
         return INCOMPLETE;
     }
 
+    // Number of times assemble returned NO_RESOURCES.
+    uint32_t noResourcesCount() const { return noResourcesCount_; }
+
     std::unique_ptr<Message> message() { return std::move(msg_); }
 
     void reset() {
@@ -55,8 +62,38 @@ private:
     std::unique_ptr<Message> msg_;
     size_t pos_;                  
     MessageHeader hdr_;           
+    uint32_t noResourcesCount_;
 
     uint8_t *headerAddr() { return reinterpret_cast<uint8_t*>(&hdr_); }
+
+    // Copy up to count bytes from [it, end) to dst and advance it.  Returns
+    // the number of bytes copied.
+    template <typename Iterator>
+    static size_t copyIn(Iterator &it, Iterator end, uint8_t *dst, size_t count) {
+        return copyIn(it, end, dst, count,
+                      typename std::iterator_traits<Iterator>::iterator_category());
+    }
+
+    // Random access input is copied as one span, with memmove for pointers.
+    template <typename Iterator>
+    static size_t copyIn(Iterator &it, Iterator end, uint8_t *dst, size_t count,
+                         std::random_access_iterator_tag) {
+        size_t n = static_cast<size_t>(end - it);
+        if (n > count) n = count;
+        std::copy(it, it + n, dst);
+        it += n;
+        return n;
+    }
+
+    template <typename Iterator, typename Category>
+    static size_t copyIn(Iterator &it, Iterator end, uint8_t *dst, size_t count,
+                         Category) {
+        size_t n = 0;
+        while (it != end && n < count) {
+            dst[n++] = *it++;
+        }
+        return n;
+    }
 };
 
 }}
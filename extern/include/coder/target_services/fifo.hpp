@@ -3,6 +3,28 @@
 #ifndef coder_tgtsvc_detail_fifo_hpp
 #define coder_tgtsvc_detail_fifo_hpp
 
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+
+// The fifo indices are std::atomic when the compiler supports C++11, which
+// is required when producer and consumer run on different cores.  Define
+// CODER_TGTSVC_FIFO_ATOMIC to 0 or 1 to override the detection.
+#ifndef CODER_TGTSVC_FIFO_ATOMIC
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#define CODER_TGTSVC_FIFO_ATOMIC 1
+#else
+#define CODER_TGTSVC_FIFO_ATOMIC 0
+#endif
+#endif
+
+#if CODER_TGTSVC_FIFO_ATOMIC
+#include <atomic>
+#ifndef CODER_TGTSVC_CACHE_LINE_SIZE
+#define CODER_TGTSVC_CACHE_LINE_SIZE 64
+#endif
+#endif
+
 namespace coder { namespace tgtsvc { namespace detail {
 
 template <typename valueType>
@@ -84,75 +106,117 @@ public:
         size_t size_;
     };
 
-    fifo() : contents_(buff_), space_(buff_) {}
+    fifo() { clear(); }
 
-    bool empty() const { return space_ == contents_; }
+    bool empty() const { return load(space_) == load(contents_); }
     bool full() const { return contents_size() == N - 1; }
-    void clear() { contents_ = buff_; space_ = buff_; }
+    void clear() { store(contents_, buff_); store(space_, buff_); }
 
-    T front() const { return *contents_; }
+    T front() const { return *load(contents_); }
     void pop() { contents_remove(1); }
     void push(const T &val) {
-        *space_ = val;
+        *load(space_) = val;
         contents_add(1);
     }
 
+    // Copy up to count elements from src into the fifo and make them
+    // available to the consumer at once.  Returns the number of elements copied.
+    size_t push_n(const T *src, size_t count) {
+        T *c = load(contents_);
+        T *s = load(space_);
+        size_t done = 0;
+        while (done < count) {
+            carray r = space_span(c, s);
+            if (r.size_ == 0) break;
+            size_t n = std::min(r.size_, count - done);
+            std::copy(src + done, src + done + n, r.addr_);
+            done += n;
+            s = increment(s, n);
+        }
+        if (done != 0) store(space_, s);
+        return done;
+    }
+
+    // Copy up to count elements from the fifo to dst and release their space
+    // to the producer at once.  Returns the number of elements copied.
+    size_t pop_n(T *dst, size_t count) {
+        T *c = load(contents_);
+        T *s = load(space_);
+        size_t done = 0;
+        while (done < count) {
+            carray r = contents_span(c, s);
+            if (r.size_ == 0) break;
+            size_t n = std::min(r.size_, count - done);
+            std::copy(r.addr_, r.addr_ + n, dst + done);
+            done += n;
+            c = increment(c, n);
+        }
+        if (done != 0) store(contents_, c);
+        return done;
+    }
+
     T &operator[](ptrdiff_t idx) { return contents_at(idx); }
 
     size_t contents_size() const {
-        return contents_wrapped() ?  N + space_ - contents_ : space_ - contents_;
+        const T *c = load(contents_);
+        const T *s = load(space_);
+        return s < c ? N + s - c : s - c;
     }
 
     T &contents_at(size_t idx) {
-        T *p = increment(const_cast<T*>(contents_), idx);
+        T *p = increment(load(contents_), idx);
         return *p;
     }
 
-    carray contents_carray() {
-        carray r;
-        r.addr_ = const_cast<T*>(contents_);
-        r.size_ = contents_wrapped() ? buff_end() - contents_ : space_ - contents_;
-        return r;
-    }
+    carray contents_carray() { return contents_span(load(contents_), load(space_)); }
 
     void contents_remove(size_t count) {
-        contents_ = increment(const_cast<T*>(contents_), count);
+        store(contents_, increment(load(contents_), count));
     }
 
     void contents_add(size_t count) {
-        space_ = increment(const_cast<T*>(space_), count);
+        store(space_, increment(load(space_), count));
     }
 
     size_t space_size() const { return N - contents_size() - 1; }
 
     T &space_at(size_t idx) {
-        T *p = increment(const_cast<T*>(space_), idx);
+        T *p = increment(load(space_), idx);
         return *p;
     }
 
-    carray space_carray() {
-        carray r;
-        r.addr_ = const_cast<T*>(space_);
-        if (contents_wrapped()) {
-            r.size_ = contents_ - space_ - 1;
-        }
-        else {
-            r.size_ = buff_end() - space_;
+    carray space_carray() { return space_span(load(contents_), load(space_)); }
 
-            if (contents_ == buff_) --r.size_;
-        }
-        return r;
-    }
+    circular_iterator<valueType> contents_begin() { return circular_iterator<valueType>(load(contents_), buff_, buff_ + N);	}
+    circular_iterator<valueType> contents_end()   { return circular_iterator<valueType>(load(space_), buff_, buff_ + N); }
 
-    circular_iterator<valueType> contents_begin() { return circular_iterator<valueType>(const_cast<T*>(contents_), buff_, buff_ + N);	}
-    circular_iterator<valueType> contents_end()   { return circular_iterator<valueType>(const_cast<T*>(space_), buff_, buff_ + N); }
-
-    circular_iterator<valueType> space_begin() { return circular_iterator<valueType>(const_cast<T*>(space_), buff_, buff_ + N); }
+    circular_iterator<valueType> space_begin() { return circular_iterator<valueType>(load(space_), buff_, buff_ + N); }
     circular_iterator<valueType> space_end()   { return --contents_begin(); }
 
 private:
-    volatile T *contents_;
-    volatile T *space_;
+    // contents_ is advanced by the consumer and space_ by the producer.  With
+    // atomics, a store releases the elements read or written before it and a
+    // load acquires the elements released by the other side; each index gets
+    // its own cache line.
+#if CODER_TGTSVC_FIFO_ATOMIC
+    typedef std::atomic<T *> index_type;
+
+    static T *load(const index_type &idx) { return idx.load(std::memory_order_acquire); }
+    static void store(index_type &idx, T *p) { idx.store(p, std::memory_order_release); }
+
+    index_type contents_;
+    char contents_pad_[CODER_TGTSVC_CACHE_LINE_SIZE - sizeof(index_type)];
+    index_type space_;
+    char space_pad_[CODER_TGTSVC_CACHE_LINE_SIZE - sizeof(index_type)];
+#else
+    typedef T *volatile index_type;
+
+    static T *load(const index_type &idx) { return idx; }
+    static void store(index_type &idx, T *p) { idx = p; }
+
+    index_type contents_;
+    index_type space_;
+#endif
     T buff_[N];
 
     T *increment(T *p, size_t i=1) {
@@ -162,7 +226,27 @@ private:
     }
 
     T *buff_end() { return buff_ + N; }
-    bool contents_wrapped() const { return space_ < contents_; }
+
+    carray contents_span(T *c, T *s) {
+        carray r;
+        r.addr_ = c;
+        r.size_ = s < c ? buff_end() - c : s - c;
+        return r;
+    }
+
+    carray space_span(T *c, T *s) {
+        carray r;
+        r.addr_ = s;
+        if (s < c) {
+            r.size_ = c - s - 1;
+        }
+        else {
+            r.size_ = buff_end() - s;
+
+            if (c == buff_) --r.size_;
+        }
+        return r;
+    }
 
 };
 
@@ -194,6 +194,8 @@ static void rt_OneStep(MODEL_CLASSNAME & mdl)
 
     rtExtModeCheckEndTrigger();
 
+    rtExtModeSetParamApply();
+
     /* Disable interrupts here */
     /* Restore FPU context here (if necessary) */
     /* Re-enable interrupts here */
@@ -299,6 +301,8 @@ static void rt_OneStep(MODEL_CLASSNAME & mdl)
     }
 
     rtExtModeCheckEndTrigger();
+
+    rtExtModeSetParamApply();
     /* Disable interrupts here */
     /* Restore FPU context here (if necessary) */
     /* Enable interrupts here */
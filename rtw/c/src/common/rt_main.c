@@ -22,6 +22,45 @@
  *   MODEL - Model name
  *   NUMST - Number of sample times
  *
+ * Optional Defines:
+ *
+ *   MT_PTHREADS=1           - With MULTITASKING, step each subrate in its own
+ *                             POSIX thread (Linux only, link rtw_linux.c).
+ *                             Sample time tid runs with SCHED_FIFO priority
+ *                             max-tid, so faster rates preempt slower ones.
+ *                             Requires REALTIME_PACING=1, otherwise the base
+ *                             rate would never leave the CPU to the subrates.
+ *                             Startup fails if the priorities or the CPU
+ *                             affinity cannot be set, e.g. without the
+ *                             CAP_SYS_NICE capability.  Subrates log from
+ *                             their own threads: compile rt_logging.c with
+ *                             the same MT define, so that log variables do
+ *                             not share the logging arena or spill file, and
+ *                             without LOGGING_ASYNC_BUFFER_SIZE, whose ring
+ *                             buffer has a single producer.
+ *   MT_PTHREADS_FIRST_CPU   - With MT_PTHREADS, pin the base rate to this CPU
+ *                             and each subrate to the next one, wrapping
+ *                             after MT_PTHREADS_NUM_CPUS CPUs.  Default 0.
+ *                             -1 leaves the threads unpinned, so that the
+ *                             scheduler may run rates in parallel on any
+ *                             CPU.
+ *   MT_PTHREADS_NUM_CPUS    - Number of CPUs to spread the pinned tasks
+ *                             over.  Default 1, which keeps the single
+ *                             processor preemption semantics the rate
+ *                             transition blocks are generated for.  Larger
+ *                             values run rates in parallel and are only safe
+ *                             for models whose rate transitions do not rely
+ *                             on preemption.  Ignored when
+ *                             MT_PTHREADS_FIRST_CPU is -1.
+ *   REALTIME_PACING=1       - Release each base rate step at the next
+ *                             multiple of BASE_RATE_PERIOD seconds of
+ *                             CLOCK_MONOTONIC using clock_nanosleep (POSIX
+ *                             only), and print wake-up latency and step time
+ *                             histograms and per sample time overrun counts
+ *                             when the model terminates.
+ *   BASE_RATE_PERIOD        - Base sample time in seconds, defaults to
+ *                             rtmGetStepSize(MODEL_M) when that is available.
+ *
  */
 
 /*==================*
@@ -131,6 +170,55 @@ extern "C" {
 #endif
 #endif
 
+/*
+ * MT_PTHREADS runs the subrates of a multitasking model in their own threads
+ */
+#if !defined(MULTITASKING) || !defined(MT_PTHREADS)
+# undef MT_PTHREADS
+# define MT_PTHREADS 0
+#endif
+
+#if MT_PTHREADS == 1
+# ifndef MT_PTHREADS_FIRST_CPU
+#  define MT_PTHREADS_FIRST_CPU 0
+# endif
+# ifndef MT_PTHREADS_NUM_CPUS
+#  define MT_PTHREADS_NUM_CPUS 1
+# endif
+# if MT_PTHREADS_NUM_CPUS < 1
+#  error MT_PTHREADS_NUM_CPUS must be at least 1.
+# endif
+# if !defined(REALTIME_PACING) || REALTIME_PACING != 1
+#  error MT_PTHREADS requires REALTIME_PACING=1.
+# endif
+# include <sched.h>
+# include "rtw_linux.h"
+#endif
+
+/*
+ * REALTIME_PACING runs the model steps in real time
+ */
+#ifndef REALTIME_PACING
+# define REALTIME_PACING 0
+#endif
+
+#if REALTIME_PACING == 1
+# if defined(INTEGER_CODE) && INTEGER_CODE == 1
+#  error REALTIME_PACING requires floating point code.
+# endif
+# ifndef BASE_RATE_PERIOD
+#  ifdef rtmGetStepSize
+#   define BASE_RATE_PERIOD rtmGetStepSize(RT_MDL)
+#  else
+#   error Define BASE_RATE_PERIOD=<base sample time in seconds> for REALTIME_PACING.
+#  endif
+# endif
+# include <time.h>
+# include <errno.h>
+# include <math.h>
+# define PACING_HIST_BINS 24   /* bin k: [2^(k-1),2^k) microseconds */
+#endif
+
 
 /*==================================*
  * Global data local to this module *
@@ -143,6 +231,167 @@ static boolean_T OverrunFlags[NUMST];
 static boolean_T eventFlags[NUMST]; 
 #endif
 
+#if MT_PTHREADS == 1
+static void     *SubrateTasks[NUMST];   /* rtw_linux.c task per subrate */
+#endif
+
+#if MT_PTHREADS == 1 || REALTIME_PACING == 1
+static uint32_T TaskOverruns[NUMST];    /* overrun counts per sample time */
+#endif
+
+#if REALTIME_PACING == 1
+typedef struct {
+    uint32_T count[PACING_HIST_BINS];
+    uint32_T n;
+    real_T   min;
+    real_T   max;
+    real_T   sum;
+} PacingHist;
+
+static struct timespec PacingEpoch;      /* CLOCK_MONOTONIC at the start */
+static real_T          PacingOffset;     /* seconds lost to pauses */
+static uint32_T        PacingSteps;      /* base rate steps released */
+static real_T          ReleaseTime;      /* of the current step, seconds */
+static real_T          StartTime;        /* of the current step, seconds */
+static PacingHist      WakeLatencyHist;  /* StartTime - ReleaseTime */
+static PacingHist      StepTimeHist;     /* execution time of rt_OneStep */
+
+/* Function: rt_PacingTime ====================================================
+ *
+ * Abstract:
+ *   Seconds of CLOCK_MONOTONIC since the pacing started.
+ */
+static real_T rt_PacingTime(void)
+{
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return((real_T)(now.tv_sec - PacingEpoch.tv_sec) +
+           1.0e-9*(real_T)(now.tv_nsec - PacingEpoch.tv_nsec));
+}
+
+/* Function: rt_UpdatePacingHist ==============================================
+ *
+ * Abstract:
+ *   Add a duration in seconds to a histogram.
+ */
+static void rt_UpdatePacingHist(PacingHist *hist, real_T duration)
+{
+    real_T usec = duration*1.0e6;
+    int_T  bin  = 0;
+
+    while (bin < PACING_HIST_BINS-1 && usec >= 1.0) {
+        usec *= 0.5;
+        bin++;
+    }
+    hist->count[bin]++;
+
+    if (hist->n == 0 || duration < hist->min) hist->min = duration;
+    if (hist->n == 0 || duration > hist->max) hist->max = duration;
+    hist->sum += duration;
+    hist->n++;
+}
+
+/* Function: rt_StartPacing ===================================================
+ *
+ * Abstract:
+ *   Release the first step now.
+ */
+static void rt_StartPacing(void)
+{
+    (void)clock_gettime(CLOCK_MONOTONIC, &PacingEpoch);
+    PacingOffset = 0.0;
+    PacingSteps  = 0;
+}
+
+/* Function: rt_WaitForNextStep ===============================================
+ *
+ * Abstract:
+ *   Sleep until the release time of the next base rate step.  If the step
+ *   is released more than a period late, e.g. after external mode paused
+ *   the model, the schedule is shifted rather than running the missed steps
+ *   back to back.
+ */
+static void rt_WaitForNextStep(void)
+{
+    real_T          period = BASE_RATE_PERIOD;
+    real_T          when;
+    struct timespec wakeTime;
+
+    ReleaseTime = PacingOffset + PacingSteps*period;
+
+    when = floor(ReleaseTime);
+    wakeTime.tv_sec  = PacingEpoch.tv_sec + (time_t)when;
+    wakeTime.tv_nsec = PacingEpoch.tv_nsec + (long)((ReleaseTime-when)*1.0e9);
+    if (wakeTime.tv_nsec >= 1000000000L) {
+        wakeTime.tv_sec++;
+        wakeTime.tv_nsec -= 1000000000L;
+    }
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+                           &wakeTime, NULL) == EINTR) {
+        /* interrupted by a signal, keep sleeping */
+    }
+
+    StartTime = rt_PacingTime();
+    if (StartTime - ReleaseTime > period) {
+        PacingOffset += StartTime - ReleaseTime;
+        ReleaseTime   = StartTime;
+    }
+    rt_UpdatePacingHist(&WakeLatencyHist, StartTime - ReleaseTime);
+}
+
+/* Function: rt_StepDone ======================================================
+ *
+ * Abstract:
+ *   Record the execution time of the step and check that the base rate
+ *   completed before the release of the next step.
+ */
+static void rt_StepDone(void)
+{
+    real_T period = BASE_RATE_PERIOD;
+    real_T now    = rt_PacingTime();
+
+    rt_UpdatePacingHist(&StepTimeHist, now - StartTime);
+    PacingSteps++;
+
+    if (now > ReleaseTime + period) {
+#if defined(MULTITASKING)
+        TaskOverruns[FIRST_TID]++;
+#else
+        TaskOverruns[0]++;
+#endif
+    }
+}
+
+/* Function: rt_PrintPacingHist ===============================================
+ *
+ * Abstract:
+ *   Print the non-empty bins of two histograms side by side.
+ */
+static void rt_PrintPacingHist(const PacingHist *h1, const PacingHist *h2)
+{
+    unsigned long lo = 0;
+    unsigned long hi = 1;
+    int_T         bin;
+
+    for (bin = 0; bin < PACING_HIST_BINS; bin++) {
+        if (h1->count[bin] || h2->count[bin]) {
+            if (bin < PACING_HIST_BINS-1) {
+                (void)printf("  %8lu - %-8lu us %10lu %10lu\n", lo, hi,
+                             (unsigned long)h1->count[bin],
+                             (unsigned long)h2->count[bin]);
+            } else {
+                (void)printf("  %8lu -          us %10lu %10lu\n", lo,
+                             (unsigned long)h1->count[bin],
+                             (unsigned long)h2->count[bin]);
+            }
+        }
+        lo  = hi;
+        hi *= 2;
+    }
+}
+#endif
+
 /*===================*
  * Visible functions *
  *===================*/
@@ -192,6 +441,7 @@ static void rt_OneStep(void)
     OverrunFlags[0]--;
 
     rtExtModeCheckEndTrigger();
+    rtExtModeSetParamApply();
 
     /* Disable interrupts here */
     /* Restore FPU context here (if necessary) */
@@ -199,6 +449,197 @@ static void rt_OneStep(void)
 
 } /* end rtOneStep */
 
+#elif MT_PTHREADS == 1 /* multitask, one thread per sample time */
+
+/* Function: rt_TaskCpu =======================================================
+ *
+ * Abstract:
+ *   CPU to run sample time "tid" on, -1 if it is not pinned.
+ */
+static int_T rt_TaskCpu(int_T tid)
+{
+    if (MT_PTHREADS_FIRST_CPU < 0) return(-1);
+    return(MT_PTHREADS_FIRST_CPU + (tid - FIRST_TID) % MT_PTHREADS_NUM_CPUS);
+}
+
+/* Function: rt_SubrateStep ===================================================
+ *
+ * Abstract:
+ *   Body of the thread that steps the model for sample time "tid".
+ */
+static void rt_SubrateStep(void *tid)
+{
+    /* Set model inputs associated with subrate here */
+
+    MODEL_STEP((int_T)(size_t)tid);
+
+    /* Get model outputs associated with subrate here */
+}
+
+/* Function: rt_StopSubrateTasks ==============================================
+ *
+ * Abstract:
+ *   Wait for the running subrates to complete and destroy their threads.
+ */
+static void rt_StopSubrateTasks(void)
+{
+    int_T i;
+
+    for (i = FIRST_TID+1; i < NUMST; i++) {
+        if (eventFlags[i]) {
+            rtw_waitfor_task(SubrateTasks[i]);
+            eventFlags[i] = 0;
+        }
+        rtw_deregister_task(SubrateTasks[i]);
+        SubrateTasks[i] = NULL;
+    }
+}
+
+/* Function: rt_SetTaskSched =================================================
+ *
+ * Abstract:
+ *   Run "task" (the calling thread if NULL) for sample time "tid" with the
+ *   given SCHED_FIFO priority on its CPU.  Returns 0 on success.
+ */
+static int_T rt_SetTaskSched(void *task, int_T tid, int_T priority)
+{
+    int_T status = rtw_set_task_sched(task, SCHED_FIFO, priority,
+                                      rt_TaskCpu(tid));
+
+    if (status != 0) {
+        (void)printf("error: could not run sample time index %d with "
+                     "SCHED_FIFO priority %d on CPU %d: %s; check the "
+                     "real-time privileges and MT_PTHREADS_FIRST_CPU\n",
+                     tid, priority, rt_TaskCpu(tid), strerror(status));
+    }
+    return(status);
+}
+
+/* Function: rt_StartSubrateTasks =============================================
+ *
+ * Abstract:
+ *   Create a thread for each subrate.  The base rate runs in the calling
+ *   thread at the highest SCHED_FIFO priority, each subrate one priority
+ *   level lower than the next faster rate.  Returns 0 on success; if a
+ *   priority or CPU affinity cannot be set the threads are destroyed again
+ *   and 1 is returned, since the rates would not preempt each other.
+ */
+static int_T rt_StartSubrateTasks(void)
+{
+    int_T maxPriority = sched_get_priority_max(SCHED_FIFO);
+    int_T minPriority = sched_get_priority_min(SCHED_FIFO);
+    int_T status;
+    int_T i;
+
+    status = rt_SetTaskSched(NULL, FIRST_TID, maxPriority);
+
+    for (i = FIRST_TID+1; i < NUMST; i++) {
+        int_T priority = maxPriority - (i - FIRST_TID);
+
+        if (priority < minPriority) priority = minPriority;
+
+        SubrateTasks[i] = rtw_register_task_with_arg(rt_SubrateStep,
+                                                     (void *)(size_t)i);
+        if (status == 0) {
+            status = rt_SetTaskSched(SubrateTasks[i], i, priority);
+        }
+    }
+
+    if (status != 0) {
+        rt_StopSubrateTasks();
+        return(1);
+    }
+    return(0);
+}
+
+/* Function: rtOneStep ========================================================
+ *
+ * Abstract:
+ *   Perform one step of the model.  The base rate is stepped in the calling
+ *   thread.  The subrates that hit are then triggered in their own threads,
+ *   so a slow subrate does not delay the next base rate step.
+ *
+ *   eventFlags[i] is set while the thread of subrate "i" is running.  The
+ *   subrate overruns if it is still running when its next sample hit comes.
+ *   The overrun is counted and the base rate then waits for the subrate,
+ *   since the steps of a rate must not overlap.
+ */
+static void rt_OneStep(void)
+{
+    boolean_T stepTask[NUMST];
+    int_T     i;
+
+    /***********************************************
+     * Check and see if base step time is too fast *
+     ***********************************************/
+    if (OverrunFlags[0]++) {
+        rtmSetErrorStatus(RT_MDL, "Overrun");
+    }
+
+    /*************************************************
+     * Check and see if an error status has been set *
+     * by an overrun or by the generated code.       *
+     *************************************************/
+    if (rtmGetErrorStatus(RT_MDL) != NULL) {
+        return;
+    }
+
+    /*************************************************
+     * Update EventFlags and check subrate overrun   *
+     *************************************************/
+    for (i = FIRST_TID+1; i < NUMST; i++) {
+        if (eventFlags[i] && rtw_poll_task(SubrateTasks[i])) {
+            /* task "i" completed */
+            eventFlags[i]--;
+        }
+        stepTask[i] = rtmStepTask(RT_MDL,i);
+        if (stepTask[i] && eventFlags[i]) {
+            /* Sampling too fast */
+            TaskOverruns[i]++;
+            rtw_waitfor_task(SubrateTasks[i]);
+            eventFlags[i]--;
+        }
+        if (++rtmTaskCounter(RT_MDL,i) == rtmCounterLimit(RT_MDL,i))
+            rtmTaskCounter(RT_MDL, i) = 0;
+    }
+
+    /* Set model inputs associated with base rate here */
+
+    /*******************************************
+     * Step the model for the base sample time *
+     *******************************************/
+    MODEL_STEP(0);
+
+    /* Get model outputs associated with base rate here */
+
+    OverrunFlags[0]--;
+
+    /*
+     * Install downloaded parameters only while no subrate thread is running,
+     * otherwise a subrate step could see a partially updated set.  They are
+     * installed at a later base rate step instead.
+     */
+    for (i = FIRST_TID+1; i < NUMST; i++) {
+        if (eventFlags[i]) break;
+    }
+    if (i == NUMST) {
+        rtExtModeSetParamApply();
+    }
+
+    /*********************************************************
+     * Trigger the model for any other sample times (subrates) *
+     *********************************************************/
+    for (i = FIRST_TID+1; i < NUMST; i++) {
+        if (stepTask[i]) {
+            eventFlags[i]++;
+            rtw_trigger_task(SubrateTasks[i]);
+        }
+    }
+
+    rtExtModeCheckEndTrigger();
+
+} /* end rtOneStep */
+
 #else /* multitask */
 
 /* Function: rtOneStep ========================================================
@@ -288,6 +729,14 @@ static void rt_OneStep(void)
             MODEL_STEP(i);
 
             /* Get model outputs associated with subrate here */
+
+#if REALTIME_PACING == 1
+            /* the subrate must complete before its next release */
+            if (rt_PacingTime() > ReleaseTime +
+                rtmCounterLimit(RT_MDL,i)*BASE_RATE_PERIOD) {
+                TaskOverruns[i]++;
+            }
+#endif
             
             /**********************************************
              * Indicate task complete for sample time "i" *
@@ -298,6 +747,7 @@ static void rt_OneStep(void)
     }
 
     rtExtModeCheckEndTrigger();
+    rtExtModeSetParamApply();
     /* Disable interrupts here */
     /* Restore FPU context here (if necessary) */
     /* Enable interrupts here */
@@ -312,7 +762,7 @@ static void rt_OneStep(void)
  *   Initialized the model and the overrun flags
  *
  */
-static void rt_InitModel(void)
+static int_T rt_InitModel(void)
 {
 #if defined(MULTITASKING)
     int i;
@@ -329,6 +779,11 @@ static void rt_InitModel(void)
      * Initialize the model *
      ************************/
     MODEL_INITIALIZE();
+
+#if MT_PTHREADS == 1
+    if (rt_StartSubrateTasks() != 0) return(1);
+#endif
+    return(0);
 }
 
 /* Function: rt_TermModel ====================================================
@@ -340,6 +795,39 @@ static void rt_InitModel(void)
 static int_T rt_TermModel(void)
 {
     MODEL_TERMINATE();
+
+#if REALTIME_PACING == 1
+    if (StepTimeHist.n > 0) {
+        (void)printf("\n** real-time pacing: %lu steps of %g s **\n",
+                     (unsigned long)StepTimeHist.n, (double)BASE_RATE_PERIOD);
+        (void)printf("                   %10s %10s %10s (us)\n",
+                     "min", "mean", "max");
+        (void)printf("  wake-up latency  %10.1f %10.1f %10.1f\n",
+                     1.0e6*WakeLatencyHist.min,
+                     1.0e6*WakeLatencyHist.sum/WakeLatencyHist.n,
+                     1.0e6*WakeLatencyHist.max);
+        (void)printf("  step time        %10.1f %10.1f %10.1f\n",
+                     1.0e6*StepTimeHist.min,
+                     1.0e6*StepTimeHist.sum/StepTimeHist.n,
+                     1.0e6*StepTimeHist.max);
+        (void)printf("                          %10s %10s\n",
+                     "latency", "step");
+        rt_PrintPacingHist(&WakeLatencyHist, &StepTimeHist);
+    }
+#endif
+
+#if MT_PTHREADS == 1 || REALTIME_PACING == 1
+    {
+        int_T i;
+
+        for (i = 0; i < NUMST; i++) {
+            if (TaskOverruns[i]) {
+                (void)printf("%lu overruns of sample time index %d.\n",
+                             (unsigned long)TaskOverruns[i], i);
+            }
+        }
+    }
+#endif
     
     {
         const char_T *errStatus = (const char_T *) (rtmGetErrorStatus(RT_MDL));
@@ -394,7 +882,10 @@ int_T main(int_T argc, const char *argv[])
     /************************
      * Initialize the model *
      ************************/
-    rt_InitModel();
+    if (rt_InitModel() != 0) {
+        MODEL_TERMINATE();
+        return(1);
+    }
 
     /* External mode */
     rtSetTFinalForExtMode(&rtmGetTFinal(RT_MDL));
@@ -405,6 +896,10 @@ int_T main(int_T argc, const char *argv[])
 
     (void)printf("\n** starting the model **\n");
 
+#if REALTIME_PACING == 1
+    rt_StartPacing();
+#endif
+
     /***********************************************************************
      * Execute (step) the model.  You may also attach rtOneStep to an ISR, *
      * in which case you replace the call to rtOneStep with a call to a    *
@@ -424,14 +919,24 @@ int_T main(int_T argc, const char *argv[])
         rtExtModeOneStep(rtmGetRTWExtModeInfo(RT_MDL),
                          NUMST,
                          (boolean_T *)&rtmGetStopRequested(RT_MDL));
-        
+
+#if REALTIME_PACING == 1
+        rt_WaitForNextStep();
+        rt_OneStep();
+        rt_StepDone();
+#else
         rt_OneStep();
+#endif
     }
 
     /*******************************
      * Cleanup and exit (optional) *
      *******************************/
 
+#if MT_PTHREADS == 1
+    rt_StopSubrateTasks();
+#endif
+
 #ifdef UseMMIDataLogging
     rt_CleanUpForStateLogWithMMI(rtmGetRTWLogInfo(RT_MDL));
 #endif
@@ -193,6 +193,8 @@ static void rt_OneStep(void)
 
     rtExtModeCheckEndTrigger();
 
+    rtExtModeSetParamApply();
+
     /* Disable interrupts here */
     /* Restore FPU context here (if necessary) */
     /* Reenable interrupts here */
@@ -298,6 +300,8 @@ static void rt_OneStep(void)
     }
 
     rtExtModeCheckEndTrigger();
+
+    rtExtModeSetParamApply();
     /* Disable interrupts here */
     /* Restore FPU context here (if necessary) */
     /* Enable interrupts here */
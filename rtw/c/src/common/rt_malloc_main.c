@@ -196,6 +196,8 @@ static void rt_OneStep(RT_MDL_TYPE *S)
 
     rtExtModeCheckEndTrigger();
 
+    rtExtModeSetParamApply();
+
     /* Disable interrupts here */
     /* Restore FPU context here (if necessary) */
     /* Reenable interrupts here */
@@ -304,6 +306,8 @@ static void rt_OneStep(RT_MDL_TYPE *S)
     }
 
     rtExtModeCheckEndTrigger();
+
+    rtExtModeSetParamApply();
     /* Disable interrupts here */
     /* Restore FPU context here (if necessary) */
     /* Enable interrupts here */
@@ -85,6 +85,13 @@ typedef enum {
      */
     EXT_DAEMON_ACK,
 
+    /*
+     * Block of time point packets produced by the negotiated upload
+     * encoding (see EXT_UPLOAD_ENC_DELTA).  Only sent to a host that asked
+     * for it at connect time.
+     */
+    EXT_UPLOAD_LOGGING_DATA_ENCODED,
+
     EXTENDED = 255          /* reserved for extending beyond 254 ID's */
 } ExtModeAction;
 
@@ -123,6 +130,41 @@ typedef struct PktHeader_tag {
 } PktHeader;
 #define NUM_HDR_ELS (2)
 
+/*
+ * The host opens a connection by sending the 8 characters "ext-mode" in
+ * place of a packet header.  A host that can decode encoded uploads sends
+ * EXT_CONNECT_ENC_MAGIC followed by one byte holding the EXT_UPLOAD_ENC_*
+ * flags it supports.  The target then appends the flags it has selected
+ * (uint32_T) to the 2nd EXT_CONNECT_RESPONSE packet.
+ *
+ * An EXT_UPLOAD_LOGGING_DATA_ENCODED packet contains:
+ *
+ *   flags     - EXT_UPLOAD_ENC_* flags applied to this block (uint32_T)
+ *   rawNBytes - number of bytes of the decoded block          (uint32_T)
+ *   data      - the encoded block
+ *
+ * The decoded block is a sequence of complete EXT_UPLOAD_LOGGING_DATA
+ * packets, as they would have been sent without encoding.  The encodings
+ * are undone in the order LZ4, RLE, DELTA:
+ *
+ *   LZ4   - the block is in LZ4 block format.
+ *   RLE   - a control byte c < 128 is followed by c+1 literal bytes, a
+ *           control byte c >= 128 is followed by one byte that is repeated
+ *           c-125 times.
+ *   DELTA - for each packet, the bytes after the first 5 int32 values
+ *           [pktType nBytes nSys tid upInfoIdx] are XORed with those of the
+ *           previous decoded packet with the same upInfoIdx and tid, if that
+ *           packet had the same nBytes.  The previous packets are those of
+ *           earlier encoded blocks of the connection as well; plain
+ *           EXT_UPLOAD_LOGGING_DATA packets do not take part.
+ */
+#define EXT_CONNECT_ENC_MAGIC     "ext-enc"
+#define EXT_CONNECT_ENC_MAGIC_LEN (7)
+
+#define EXT_UPLOAD_ENC_DELTA      (0x1U)
+#define EXT_UPLOAD_ENC_RLE        (0x2U)
+#define EXT_UPLOAD_ENC_LZ4        (0x4U)
+
 #ifndef FALSE
 enum {FALSE, TRUE};
 #endif
@@ -103,6 +103,57 @@ PRIVATE ExtUserData *extUD          = NULL;
 PRIVATE int_T pktBufSize = 0;
 PRIVATE char  *pktBuf    = NULL;
 
+#if defined(EXTMODE_UPLOAD_ENCODING) && !defined(EXTMODE_DISABLESIGNALMONITORING)
+/*
+ * Upload encoding (see EXT_UPLOAD_LOGGING_DATA_ENCODED in ext_share.h).
+ * EXTMODE_UPLOAD_ENC_SUPPORTED limits the EXT_UPLOAD_ENC_* flags the target
+ * agrees to and EXTMODE_UPLOAD_ENC_BLOCK_SIZE sets the number of raw bytes
+ * encoded as one block.
+ */
+#ifndef EXTMODE_UPLOAD_ENC_SUPPORTED
+#define EXTMODE_UPLOAD_ENC_SUPPORTED \
+    (EXT_UPLOAD_ENC_DELTA | EXT_UPLOAD_ENC_RLE | EXT_UPLOAD_ENC_LZ4)
+#endif
+
+#ifndef EXTMODE_UPLOAD_ENC_BLOCK_SIZE
+#define EXTMODE_UPLOAD_ENC_BLOCK_SIZE (2048)
+#endif
+
+#if (EXTMODE_UPLOAD_ENC_BLOCK_SIZE > 65000)
+#error "EXTMODE_UPLOAD_ENC_BLOCK_SIZE must not exceed 65000 bytes"
+#endif
+
+/* [PktHeader flags rawNBytes] in front of each encoded block */
+#define UPLOAD_ENC_PREFIX_SIZE   ((int_T)(sizeof(PktHeader) + 2*sizeof(uint32_T)))
+
+/* [pktType nBytes nSys tid upInfoIdx] at the start of a time point packet */
+#define UPLOAD_ENC_DELTA_OFFSET  ((int_T)(5*sizeof(int32_T)))
+
+#define UPLOAD_ENC_RLE_MIN_RUN   (3)
+#define UPLOAD_ENC_RLE_MAX_RUN   (130)
+#define UPLOAD_ENC_RLE_MAX_LIT   (128)
+
+#define UPLOAD_ENC_LZ4_HASH_LOG  (10)
+#define UPLOAD_ENC_LZ4_MIN_MATCH (4)
+#define UPLOAD_ENC_LZ4_LAST_LIT  (5)  /* block must end with 5 literals  */
+#define UPLOAD_ENC_LZ4_MF_LIMIT  (12) /* no match starts in last 12 bytes */
+
+/*
+ * Payload of the last time point packet sent for an upInfoIdx and tid.
+ */
+typedef struct UploadEncRef_tag {
+    int_T   nBytes;
+    uint8_T *data;
+} UploadEncRef;
+
+PRIVATE uint32_T     uploadEncFlags   = 0;    /* negotiated EXT_UPLOAD_ENC_* */
+PRIVATE int_T        uploadEncNumTids = 0;
+PRIVATE UploadEncRef *uploadEncRefs   = NULL; /* NUM_UPINFOS x numTids       */
+PRIVATE char         *uploadEncStage  = NULL; /* prefix + raw block          */
+PRIVATE char         *uploadEncWork   = NULL; /* prefix + encoded block      */
+PRIVATE uint16_T     *uploadEncHash   = NULL; /* LZ4 match finder            */
+#endif
+
 
 #ifndef EXTMODE_DISABLESIGNALMONITORING
 #ifndef EXTMODE_DISABLEPRINTF 
@@ -141,6 +192,11 @@ const int_T daemonChunkSize = 32;
 PRIVATE boolean_T SendPktHdrToHost(const ExtModeAction action,
                                          const int size);
 
+#if defined(EXTMODE_UPLOAD_ENCODING) && !defined(EXTMODE_DISABLESIGNALMONITORING)
+PRIVATE uint32_T UploadEncInit(uint32_T flags, int_T numSampTimes);
+PRIVATE void UploadEncTerm(void);
+#endif
+
 /*******************
  * Local Functions *
  *******************/
@@ -459,6 +515,10 @@ PRIVATE void DisconnectFromHost(int_T numSampTimes)
 
         UploadLogInfoTerm(i, numSampTimes);
     }
+
+#if defined(EXTMODE_UPLOAD_ENCODING) && !defined(EXTMODE_DISABLESIGNALMONITORING)
+    UploadEncTerm();
+#endif
     
     connected       = false;
     commInitialized = false;
@@ -484,21 +544,31 @@ PRIVATE void ForceDisconnectFromHost(int_T numSampTimes)
         UploadEndLoggingSession(i, numSampTimes);
     }
 
+#if defined(EXTMODE_UPLOAD_ENCODING) && !defined(EXTMODE_DISABLESIGNALMONITORING)
+    UploadEncTerm();
+#endif
+
     ExtForceDisconnect(extUD);
 } /* end ForceDisconnectFromHost */
 
 
 /* Function: ProcessConnectPkt =================================================
  * Abstract:
- *  Process the EXT_CONNECT packet and send response to host.
+ *  Process the EXT_CONNECT packet and send response to host.  helloPkt holds
+ *  the bytes the host opened the connection with, which may request an
+ *  upload encoding.
  */
-PRIVATE boolean_T ProcessConnectPkt(RTWExtModeInfo *ei)
+PRIVATE boolean_T ProcessConnectPkt(RTWExtModeInfo  *ei,
+                                    const PktHeader *helloPkt,
+                                    int_T           numSampTimes)
 {
     int_T                   nSet;
     PktHeader               pktHdr;
     int_T                   tmpBufSize;
     uint32_T                *tmpBuf = NULL;
     boolean_T               error   = EXT_NO_ERROR;
+    uint32_T                encFlags = 0;
+    boolean_T               encRequested;
     
     const DataTypeTransInfo *dtInfo    = (const DataTypeTransInfo *) rteiGetModelMappingInfo(ei);
     uint_T                  *dtSizes   = dtGetDataTypeSizes(dtInfo);
@@ -507,6 +577,23 @@ PRIVATE boolean_T ProcessConnectPkt(RTWExtModeInfo *ei)
     assert(connected);
     assert(!comminitialized);
 
+    /*
+     * A host that can decode encoded uploads says so in its hello.  Agree to
+     * the encodings that are supported by both sides.
+     */
+    encRequested = (boolean_T)(memcmp(helloPkt, EXT_CONNECT_ENC_MAGIC,
+                                      EXT_CONNECT_ENC_MAGIC_LEN) == 0);
+    if (encRequested) {
+        uint32_T hostFlags = (uint32_T)
+            ((const unsigned char *)helloPkt)[EXT_CONNECT_ENC_MAGIC_LEN];
+#if defined(EXTMODE_UPLOAD_ENCODING) && !defined(EXTMODE_DISABLESIGNALMONITORING)
+        encFlags = UploadEncInit(hostFlags, numSampTimes);
+#else
+        (void)hostFlags;
+        (void)numSampTimes;
+#endif
+    }
+
     /*
      * Send the 1st of two EXT_CONNECT_RESPONSE packets to the host. 
      * The packet consists purely of the pktHeader.  In this special
@@ -541,6 +628,8 @@ PRIVATE boolean_T ProcessConnectPkt(RTWExtModeInfo *ei)
      *
      * nDataTypes    - # of data types        (uint32_T)
      * dataTypeSizes - 1 per nDataTypes       (uint32_T[])
+     *
+     * encFlags      - upload encoding, only if requested (uint32_T)
      */
 
     {
@@ -549,7 +638,8 @@ PRIVATE boolean_T ProcessConnectPkt(RTWExtModeInfo *ei)
                          1 +                        /* MW chunk size   */
                          1 +                        /* targetStatus    */
                          1 +                        /* nDataTypes      */
-                         dtGetNumDataTypes(dtInfo); /* data type sizes */
+                         dtGetNumDataTypes(dtInfo) + /* data type sizes */
+                         (encRequested ? 1 : 0);    /* encFlags        */
 
         tmpBufSize = nPktEls * sizeof(uint32_T);
         tmpBuf     = (uint32_T *)malloc(tmpBufSize);
@@ -595,6 +685,10 @@ PRIVATE boolean_T ProcessConnectPkt(RTWExtModeInfo *ei)
             tmpBuf[8+i] = (uint32_T)dtSizes[i];
         }
     }
+
+    if (encRequested) {
+        tmpBuf[8+nDataTypes] = encFlags;
+    }
     
     /* Send the packet. */
     error = ExtSetHostPkt(extUD,tmpBufSize,(char_T *)tmpBuf,&nSet);
@@ -667,6 +761,476 @@ EXIT_POINT:
 } /* end SendPktDataToHost */
 
 
+/* Function: SendPktSpansToHost ================================================
+ * Abstract:
+ *  Send a list of data spans to host.  As with SendPktDataToHost, any packet
+ *  headers must be part of the spans or have been sent already.
+ *
+ *  The spans are sent one at a time unless EXTMODE_GATHER_SEND is defined,
+ *  in which case the whole list is handed to the transport with a single
+ *  ExtSetHostPktV call.  Only define it for transports that provide
+ *  ExtSetHostPktV.
+ */
+#ifndef EXTMODE_DISABLESIGNALMONITORING
+PRIVATE boolean_T SendPktSpansToHost(const ExtHostPktSpan *spans,
+                                     const int            nSpans)
+{
+    boolean_T error = EXT_NO_ERROR;
+#ifdef EXTMODE_GATHER_SEND
+    int_T     i;
+    int_T     nSet;
+    int_T     nBytes = 0;
+
+    for (i=0; i<nSpans; i++) {
+        nBytes += spans[i].nBytes;
+    }
+
+    error = ExtSetHostPktV(extUD,nSpans,spans,&nSet);
+    if (error || (nSet != nBytes)) {
+        error = EXT_ERROR;
+#ifndef EXTMODE_DISABLEPRINTF            
+        fprintf(stderr,"ExtSetHostPktV() failed.\n");
+#endif
+        goto EXIT_POINT;
+    }
+#else
+    int_T     i;
+
+    for (i=0; i<nSpans; i++) {
+        error = SendPktDataToHost(spans[i].data, spans[i].nBytes);
+        if (error != EXT_NO_ERROR) goto EXIT_POINT;
+    }
+#endif
+
+EXIT_POINT:
+    return(error);
+} /* end SendPktSpansToHost */
+#endif /* ifndef EXTMODE_DISABLESIGNALMONITORING */
+
+
+#if defined(EXTMODE_UPLOAD_ENCODING) && !defined(EXTMODE_DISABLESIGNALMONITORING)
+/* Function: UploadEncTerm =====================================================
+ * Abstract:
+ *  Free the upload encoder and return to sending plain upload packets.
+ */
+PRIVATE void UploadEncTerm(void)
+{
+    int_T i;
+
+    if (uploadEncRefs != NULL) {
+        for (i=0; i<NUM_UPINFOS*uploadEncNumTids; i++) {
+            free(uploadEncRefs[i].data);
+        }
+        free(uploadEncRefs);
+        uploadEncRefs = NULL;
+    }
+
+    free(uploadEncStage);
+    uploadEncStage = NULL;
+
+    free(uploadEncWork);
+    uploadEncWork = NULL;
+
+    free(uploadEncHash);
+    uploadEncHash = NULL;
+
+    uploadEncNumTids = 0;
+    uploadEncFlags   = 0;
+} /* end UploadEncTerm */
+
+
+/* Function: UploadEncInit =====================================================
+ * Abstract:
+ *  Set up the upload encoder for the EXT_UPLOAD_ENC_* flags requested by the
+ *  host.  Returns the flags that will be used: those supported by the target,
+ *  or none if there is not enough memory.
+ */
+PRIVATE uint32_T UploadEncInit(uint32_T flags, int_T numSampTimes)
+{
+    const int_T bufSize = UPLOAD_ENC_PREFIX_SIZE + EXTMODE_UPLOAD_ENC_BLOCK_SIZE;
+
+    UploadEncTerm();
+
+    flags &= (uint32_T)(EXTMODE_UPLOAD_ENC_SUPPORTED);
+    if (flags == 0) goto EXIT_POINT;
+
+    uploadEncRefs = (UploadEncRef *)calloc(NUM_UPINFOS*numSampTimes,
+                                           sizeof(UploadEncRef));
+    uploadEncStage = (char *)malloc(bufSize);
+    uploadEncWork  = (char *)malloc(bufSize);
+    if (flags & EXT_UPLOAD_ENC_LZ4) {
+        uploadEncHash = (uint16_T *)malloc(
+            sizeof(uint16_T) << UPLOAD_ENC_LZ4_HASH_LOG);
+    }
+
+    if ((uploadEncRefs == NULL) || (uploadEncStage == NULL) ||
+        (uploadEncWork == NULL) ||
+        ((flags & EXT_UPLOAD_ENC_LZ4) && (uploadEncHash == NULL))) {
+        UploadEncTerm();
+        flags = 0;
+        goto EXIT_POINT;
+    }
+
+    uploadEncNumTids = numSampTimes;
+    uploadEncFlags   = flags;
+
+EXIT_POINT:
+    return(flags);
+} /* end UploadEncInit */
+
+
+/* Function: UploadEncCopy =====================================================
+ * Abstract:
+ *  Copy nBytes starting at offset out of the (possibly wrapped) buffer
+ *  sections described by bufMem.
+ */
+PRIVATE void UploadEncCopy(char         *dst,
+                           const BufMem *bufMem,
+                           int_T        offset,
+                           int_T        nBytes)
+{
+    if (offset < bufMem->nBytes1) {
+        int_T n1 = bufMem->nBytes1 - offset;
+
+        if (n1 > nBytes) n1 = nBytes;
+        (void)memcpy(dst, bufMem->section1 + offset, n1);
+        dst    += n1;
+        offset += n1;
+        nBytes -= n1;
+    }
+    if (nBytes > 0) {
+        (void)memcpy(dst, bufMem->section2 + (offset - bufMem->nBytes1), nBytes);
+    }
+} /* end UploadEncCopy */
+
+
+/* Function: UploadEncDelta ====================================================
+ * Abstract:
+ *  XOR the data of a staged time point packet with that of the previous
+ *  packet of the same upInfoIdx and tid, and keep the data for the next one.
+ *  A packet whose size differs from the previous one is left as is.
+ *
+ *  Returns false if there is no memory to keep the data.  The packet must
+ *  then be sent unencoded, which leaves the host's copy unchanged as well.
+ */
+PRIVATE boolean_T UploadEncDelta(char *pkt, int_T pktSize)
+{
+    int32_T      intHdr[5]; /* [pktType nBytes nSys tid upInfoIdx] */
+    UploadEncRef *ref;
+    uint8_T      *data  = (uint8_T *)pkt + UPLOAD_ENC_DELTA_OFFSET;
+    int_T        nBytes = pktSize - UPLOAD_ENC_DELTA_OFFSET;
+    int_T        i;
+
+    (void)memcpy(intHdr, pkt, sizeof(intHdr));
+    assert((intHdr[3] >= 0) && (intHdr[3] < uploadEncNumTids));
+    assert((intHdr[4] >= 0) && (intHdr[4] < NUM_UPINFOS));
+    assert(nBytes >= 0);
+
+    ref = &uploadEncRefs[intHdr[4]*uploadEncNumTids + intHdr[3]];
+
+    if (ref->nBytes != nBytes) {
+        uint8_T *refData = (uint8_T *)malloc(nBytes);
+        if (refData == NULL) return(false);
+
+        free(ref->data);
+        ref->data   = refData;
+        ref->nBytes = nBytes;
+        (void)memcpy(ref->data, data, nBytes);
+    } else {
+        for (i=0; i<nBytes; i++) {
+            uint8_T value = data[i];
+
+            data[i]      ^= ref->data[i];
+            ref->data[i]  = value;
+        }
+    }
+    return(true);
+} /* end UploadEncDelta */
+
+
+/* Function: UploadEncRle ======================================================
+ * Abstract:
+ *  Run-length encode src.  Returns the encoded size or -1 if it would exceed
+ *  dstCap bytes.
+ */
+PRIVATE int_T UploadEncRle(const uint8_T *src,
+                           int_T         nBytes,
+                           uint8_T       *dst,
+                           int_T         dstCap)
+{
+    int_T i    = 0;
+    int_T nLit = 0; /* literals pending in front of src[i] */
+    int_T nOut = 0;
+
+    for (;;) {
+        int_T run = 0;
+
+        if (i < nBytes) {
+            run = 1;
+            while ((i+run < nBytes) && (run < UPLOAD_ENC_RLE_MAX_RUN) &&
+                   (src[i+run] == src[i])) {
+                run++;
+            }
+        }
+
+        if ((i == nBytes) || (run >= UPLOAD_ENC_RLE_MIN_RUN) ||
+            (nLit == UPLOAD_ENC_RLE_MAX_LIT)) {
+            if (nLit > 0) {
+                if (nOut + 1 + nLit > dstCap) return(-1);
+                dst[nOut++] = (uint8_T)(nLit - 1);
+                (void)memcpy(&dst[nOut], &src[i-nLit], nLit);
+                nOut += nLit;
+                nLit  = 0;
+            }
+            if (i == nBytes) break;
+
+            if (run >= UPLOAD_ENC_RLE_MIN_RUN) {
+                if (nOut + 2 > dstCap) return(-1);
+                dst[nOut++] = (uint8_T)(run + 125);
+                dst[nOut++] = src[i];
+                i += run;
+                continue;
+            }
+        }
+        nLit++;
+        i++;
+    }
+    return(nOut);
+} /* end UploadEncRle */
+
+
+/* Function: UploadEncLz4Sequence ==============================================
+ * Abstract:
+ *  Append an LZ4 sequence (literals followed by a match, or just literals if
+ *  matchLen is 0) to dst.  Returns the new size of dst or -1 if it would
+ *  exceed dstCap bytes.
+ */
+PRIVATE int_T UploadEncLz4Sequence(uint8_T       *dst,
+                                   int_T         nOut,
+                                   int_T         dstCap,
+                                   const uint8_T *lit,
+                                   int_T         nLit,
+                                   int_T         offset,
+                                   int_T         matchLen)
+{
+    uint8_T *token;
+    int_T   len;
+
+    if (nOut + 1 + nLit/255 + 1 + nLit + 2 + matchLen/255 + 1 > dstCap) {
+        return(-1);
+    }
+
+    token  = &dst[nOut++];
+    *token = (uint8_T)(((nLit < 15) ? nLit : 15) << 4);
+    if (nLit >= 15) {
+        for (len = nLit - 15; len >= 255; len -= 255) dst[nOut++] = 255;
+        dst[nOut++] = (uint8_T)len;
+    }
+    (void)memcpy(&dst[nOut], lit, nLit);
+    nOut += nLit;
+
+    if (matchLen > 0) {
+        dst[nOut++] = (uint8_T)(offset & 0xFF);
+        dst[nOut++] = (uint8_T)(offset >> 8);
+
+        len     = matchLen - UPLOAD_ENC_LZ4_MIN_MATCH;
+        *token |= (uint8_T)((len < 15) ? len : 15);
+        if (len >= 15) {
+            for (len -= 15; len >= 255; len -= 255) dst[nOut++] = 255;
+            dst[nOut++] = (uint8_T)len;
+        }
+    }
+    return(nOut);
+} /* end UploadEncLz4Sequence */
+
+
+/* Function: UploadEncLz4 ======================================================
+ * Abstract:
+ *  Compress src into the LZ4 block format using a single-probe hash of the
+ *  last 4 byte sequences seen.  Returns the compressed size or -1 if it would
+ *  exceed dstCap bytes.
+ */
+PRIVATE int_T UploadEncLz4(const uint8_T *src,
+                           int_T         nBytes,
+                           uint8_T       *dst,
+                           int_T         dstCap)
+{
+    int_T ip         = 0;
+    int_T anchor     = 0;
+    int_T nOut       = 0;
+    int_T matchLimit = nBytes - UPLOAD_ENC_LZ4_LAST_LIT;
+
+    /* Hash entries hold position+1, 0 means empty. */
+    (void)memset(uploadEncHash, 0, sizeof(uint16_T) << UPLOAD_ENC_LZ4_HASH_LOG);
+
+    while (ip < nBytes - UPLOAD_ENC_LZ4_MF_LIMIT) {
+        uint32_T seq;
+        uint32_T refSeq;
+        uint32_T hash;
+        int_T    ref;
+
+        (void)memcpy(&seq, &src[ip], sizeof(seq));
+        hash = ((seq * 2654435761U) & 0xFFFFFFFFU) >>
+            (32 - UPLOAD_ENC_LZ4_HASH_LOG);
+        ref  = (int_T)uploadEncHash[hash] - 1;
+        uploadEncHash[hash] = (uint16_T)(ip + 1);
+
+        if (ref >= 0) {
+            (void)memcpy(&refSeq, &src[ref], sizeof(refSeq));
+        }
+        if ((ref >= 0) && (refSeq == seq)) {
+            int_T matchLen = UPLOAD_ENC_LZ4_MIN_MATCH;
+
+            while ((ip + matchLen < matchLimit) &&
+                   (src[ref+matchLen] == src[ip+matchLen])) {
+                matchLen++;
+            }
+            nOut = UploadEncLz4Sequence(dst, nOut, dstCap, &src[anchor],
+                                        ip - anchor, ip - ref, matchLen);
+            if (nOut < 0) return(-1);
+
+            ip    += matchLen;
+            anchor = ip;
+        } else {
+            ip++;
+        }
+    }
+
+    return(UploadEncLz4Sequence(dst, nOut, dstCap, &src[anchor],
+                                nBytes - anchor, 0, 0));
+} /* end UploadEncLz4 */
+
+
+/* Function: UploadEncSendBlock ================================================
+ * Abstract:
+ *  Compress the nBytes staged in uploadEncStage and send them to the host as
+ *  one EXT_UPLOAD_LOGGING_DATA_ENCODED packet.  RLE and LZ4 are each skipped
+ *  when they do not make the block smaller.
+ */
+PRIVATE boolean_T UploadEncSendBlock(int_T nBytes)
+{
+    PktHeader pktHdr;
+    uint32_T  blockInfo[2]; /* [flags rawNBytes] */
+    int_T     nEnc;
+    char      *src   = uploadEncStage;
+    char      *dst   = uploadEncWork;
+    int_T     n      = nBytes;
+    uint32_T  flags  = uploadEncFlags & EXT_UPLOAD_ENC_DELTA;
+
+    if (nBytes == 0) return(EXT_NO_ERROR);
+
+    if (uploadEncFlags & EXT_UPLOAD_ENC_RLE) {
+        nEnc = UploadEncRle((const uint8_T *)src + UPLOAD_ENC_PREFIX_SIZE, n,
+                            (uint8_T *)dst + UPLOAD_ENC_PREFIX_SIZE, n - 1);
+        if (nEnc > 0) {
+            char *tmp = src; src = dst; dst = tmp;
+            n      = nEnc;
+            flags |= EXT_UPLOAD_ENC_RLE;
+        }
+    }
+
+    if (uploadEncFlags & EXT_UPLOAD_ENC_LZ4) {
+        nEnc = UploadEncLz4((const uint8_T *)src + UPLOAD_ENC_PREFIX_SIZE, n,
+                            (uint8_T *)dst + UPLOAD_ENC_PREFIX_SIZE, n - 1);
+        if (nEnc > 0) {
+            char *tmp = src; src = dst; dst = tmp;
+            n      = nEnc;
+            flags |= EXT_UPLOAD_ENC_LZ4;
+        }
+    }
+
+    pktHdr.type  = (uint32_T)EXT_UPLOAD_LOGGING_DATA_ENCODED;
+    pktHdr.size  = (uint32_T)(sizeof(blockInfo) + n);
+    blockInfo[0] = flags;
+    blockInfo[1] = (uint32_T)nBytes;
+
+    (void)memcpy(src, &pktHdr, sizeof(pktHdr));
+    (void)memcpy(src + sizeof(pktHdr), blockInfo, sizeof(blockInfo));
+
+    return(SendPktDataToHost(src, UPLOAD_ENC_PREFIX_SIZE + n));
+} /* end UploadEncSendBlock */
+
+
+/* Function: SendEncodedUploadBufs =============================================
+ * Abstract:
+ *  Send the buffers of an upload list to the host as encoded blocks.  Time
+ *  point packets are staged in order and delta encoded as they are added; a
+ *  block is compressed and sent when the next packet does not fit.  Packets
+ *  larger than a block are sent unencoded.
+ */
+PRIVATE boolean_T SendEncodedUploadBufs(const ExtBufMemList *upList)
+{
+    int_T     i;
+    int_T     nStaged = 0;
+    boolean_T error   = EXT_NO_ERROR;
+    char      *stage  = uploadEncStage + UPLOAD_ENC_PREFIX_SIZE;
+
+    for (i=0; i<upList->nActiveBufs; i++) {
+        const BufMem *bufMem = &upList->bufs[i];
+        int_T        nBytes  = bufMem->nBytes1 + bufMem->nBytes2;
+        int_T        offset  = 0;
+
+        while (offset < nBytes) {
+            PktHeader pktHdr;
+            int_T     pktSize;
+            boolean_T encoded = false;
+
+            UploadEncCopy((char *)&pktHdr, bufMem, offset, sizeof(pktHdr));
+            pktSize = (int_T)(sizeof(pktHdr) + pktHdr.size);
+            assert(offset + pktSize <= nBytes);
+
+            if (pktSize <= EXTMODE_UPLOAD_ENC_BLOCK_SIZE) {
+                if (nStaged + pktSize > EXTMODE_UPLOAD_ENC_BLOCK_SIZE) {
+                    error = UploadEncSendBlock(nStaged);
+                    if (error != EXT_NO_ERROR) goto EXIT_POINT;
+                    nStaged = 0;
+                }
+
+                UploadEncCopy(stage + nStaged, bufMem, offset, pktSize);
+                encoded = (boolean_T)
+                    (!(uploadEncFlags & EXT_UPLOAD_ENC_DELTA) ||
+                     UploadEncDelta(stage + nStaged, pktSize));
+                if (encoded) nStaged += pktSize;
+            }
+
+            if (!encoded) {
+                /* Keep the packet order: send what is staged first. */
+                ExtHostPktSpan spans[2];
+                int_T          nSpans = 0;
+                int_T          n1     = bufMem->nBytes1 - offset;
+
+                error = UploadEncSendBlock(nStaged);
+                if (error != EXT_NO_ERROR) goto EXIT_POINT;
+                nStaged = 0;
+
+                if (n1 > 0) {
+                    spans[nSpans].data   = bufMem->section1 + offset;
+                    spans[nSpans].nBytes = (n1 < pktSize) ? n1 : pktSize;
+                    nSpans++;
+                } else {
+                    n1 = 0;
+                }
+                if (n1 < pktSize) {
+                    spans[nSpans].data   = bufMem->section2 + (offset + n1 -
+                                                               bufMem->nBytes1);
+                    spans[nSpans].nBytes = pktSize - n1;
+                    nSpans++;
+                }
+                error = SendPktSpansToHost(spans, nSpans);
+                if (error != EXT_NO_ERROR) goto EXIT_POINT;
+            }
+            offset += pktSize;
+        }
+    }
+
+    error = UploadEncSendBlock(nStaged);
+
+EXIT_POINT:
+    return(error);
+} /* end SendEncodedUploadBufs */
+#endif /* EXTMODE_UPLOAD_ENCODING && !EXTMODE_DISABLESIGNALMONITORING */
+
+
 /* Function: SendPktToHost =====================================================
  * Abstract:
  *  Send a packet to the host.  Packets can be of two forms:
@@ -726,6 +1290,10 @@ PRIVATE boolean_T SendResponseStatus(const ExtModeAction  response,
 #ifndef EXTMODE_DISABLEPARAMETERTUNING
 /* Function: ProcessSetParamPkt ================================================
  * Receive and process the EXT_SETPARAM packet.
+ *
+ * With EXTMODE_STAGED_SETPARAM the parameters are decoded into a batch here
+ * and installed by the model between two steps (see rtExtModeSetParamApply),
+ * so that all parameters of a packet change at the same step boundary.
  */
 PRIVATE boolean_T ProcessSetParamPkt(RTWExtModeInfo *ei,
                                      const int pktSize)
@@ -750,7 +1318,30 @@ PRIVATE boolean_T ProcessSetParamPkt(RTWExtModeInfo *ei,
         error = EXT_ERROR; 
         goto EXIT_POINT;
     }
+#ifdef EXTMODE_STAGED_SETPARAM
+    if (SetParamStage(ei, pkt) != EXT_NO_ERROR) {
+        msg = (int32_T)NOT_ENOUGH_MEMORY;
+        SendPktToHost(EXT_SETPARAM_RESPONSE,sizeof(int32_T),(char_T *)&msg);
+        error = EXT_ERROR; 
+        goto EXIT_POINT;
+    }
+
+    /*
+     * Hand the batch to the model.  If it has not applied the previous batch
+     * yet, the packet stays staged and rt_PktServerWork commits it later.
+     * While the model is not running it does not step, so apply the batches
+     * here instead.
+     */
+    if (modelStatus != TARGET_STATUS_RUNNING) {
+        SetParamApplyPending();
+        (void)SetParamCommit();
+        SetParamApplyPending();
+    } else {
+        (void)SetParamCommit();
+    }
+#else
     SetParam(ei, pkt);
+#endif
 
     msg = (int32_T)STATUS_OK;
     error = SendPktToHost(EXT_SETPARAM_RESPONSE,sizeof(int32_T),(char_T *)&msg);
@@ -1059,38 +1650,29 @@ taskSafe();
     
     UploadBufGetData(&upList, upInfoIdx, numSampTimes);
     while(upList.nActiveBufs > 0) {
-        for (i=0; i<upList.nActiveBufs; i++) {
-            const BufMem *bufMem = &upList.bufs[i];
-
-            /*
-             * We call SendPktDataToHost() instead of SendPktToHost() because
-             * the packet header is combined with packet payload.  We do this
-             * to avoid the overhead of making two calls for each upload
-             * packet - one for the head and one for the payload.
-             */
-            error = SendPktDataToHost(
-                bufMem->section1,
-                bufMem->nBytes1);
-            if (error != EXT_NO_ERROR) {
+        /*
+         * The packet headers are stored in the circular buffers together
+         * with the payload, so the buffer sections of all tids are complete
+         * packets.  Hand them to the transport in place as one scatter list
+         * and release them only after they have been sent.
+         */
+#ifdef EXTMODE_UPLOAD_ENCODING
+        if (uploadEncFlags != 0) {
+            error = SendEncodedUploadBufs(&upList);
+        } else
+#endif
+        {
+            error = SendPktSpansToHost(upList.spans, upList.nSpans);
+        }
+        if (error != EXT_NO_ERROR) {
 #ifndef EXTMODE_DISABLEPRINTF                    
-                fprintf(stderr,"SendPktDataToHost() failed on data upload.\n");
+            fprintf(stderr,"Sending packets failed on data upload.\n");
 #endif
-                goto EXIT_POINT;
-            }
-            
-            if (bufMem->nBytes2 > 0) {
+            goto EXIT_POINT;
+        }
 
-                error = SendPktDataToHost(
-                    bufMem->section2,
-                    bufMem->nBytes2);
-                if (error != EXT_NO_ERROR) {
-#ifndef EXTMODE_DISABLEPRINTF                        
-                    fprintf(stderr,"SendPktDataToHost() failed on data upload.\n");
-#endif
-                    goto EXIT_POINT;
-                }
-            }
-            /* confirm that the data was sent */
+        /* confirm that the data was sent */
+        for (i=0; i<upList.nActiveBufs; i++) {
             UploadBufDataSent(upList.tids[i], upInfoIdx);
         }
         UploadBufGetData(&upList, upInfoIdx, numSampTimes);
@@ -1184,9 +1766,15 @@ PUBLIC void rt_PktServerWork(RTWExtModeInfo *ei,
                              boolean_T      *stopReq)
 {
     PktHeader  pktHdr;
+    PktHeader  helloPkt;
     boolean_T  hdrAvail;
     boolean_T  error             = EXT_NO_ERROR;
     boolean_T  disconnectOnError = false;
+
+#if defined(EXTMODE_STAGED_SETPARAM) && !defined(EXTMODE_DISABLEPARAMETERTUNING)
+    /* Commit parameters staged while the model held the previous batch. */
+    (void)SetParamCommit();
+#endif
     
     /*
      * If not connected, attempt to make connection to host.
@@ -1223,9 +1811,11 @@ PUBLIC void rt_PktServerWork(RTWExtModeInfo *ei,
 
     /*
      * This is the first packet.  Should contain the string:
-     * 'ext-mode'.  Its contents are not important to us.
-     * It is used as a flag to start the handshaking process.
+     * 'ext-mode'.  Its contents are not important to us, except
+     * that a host asking for encoded uploads sends EXT_CONNECT_ENC_MAGIC
+     * instead.  It is used as a flag to start the handshaking process.
      */
+    helloPkt = pktHdr;
     if (!commInitialized) {
         pktHdr.type = EXT_CONNECT;
     }
@@ -1290,7 +1880,7 @@ PUBLIC void rt_PktServerWork(RTWExtModeInfo *ei,
     case EXT_CONNECT:
     {
         PRINT_VERBOSE(("got EXT_CONNECT packet.\n"));
-        error = ProcessConnectPkt(ei);
+        error = ProcessConnectPkt(ei, &helloPkt, numSampTimes);
         if (error != EXT_NO_ERROR) goto EXIT_POINT;
         break;
     }
@@ -1555,6 +2145,19 @@ PUBLIC boolean_T rt_ExtModeShutdown(int_T numSampTimes)
 
     ExtShutDown(extUD);
     ExtUserDataDestroy(extUD);
+
+#if defined(EXTMODE_UPLOAD_ENCODING) && !defined(EXTMODE_DISABLESIGNALMONITORING)
+    UploadEncTerm();
+#endif
+
+#if defined(EXTMODE_STAGED_SETPARAM) && !defined(EXTMODE_DISABLEPARAMETERTUNING)
+    SetParamTerm();
+#endif
+
+#if defined(EXTMODE_STATIC) && !defined(XCP_MEM_DAQ_RESERVED_POOLS_NUMBER)
+    /* Report the peak usage of the static external mode memory. */
+    ExtModeMemReport();
+#endif
     
     rtExtModeTestingRemoveBatMarker();
     
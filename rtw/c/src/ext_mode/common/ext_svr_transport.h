@@ -65,6 +65,12 @@ extern boolean_T ExtSetHostPkt(
     const char        *src,
     int               *nBytesSet);
 
+extern boolean_T ExtSetHostPktV(
+    const ExtUserData    *UD,
+    const int            nSpans,
+    const ExtHostPktSpan *spans,
+    int                  *nBytesSet);
+
 extern void ExtModeSleep(
     const ExtUserData *UD,
     const long        sec,  
@@ -17,6 +17,18 @@
 # define action_T real_T
 #endif
 
+/****************************************
+ * Scatter-gather send                  *
+ ****************************************/
+/*
+ * One contiguous piece of an outgoing packet.  With EXTMODE_GATHER_SEND a
+ * list of spans is sent with a single call to ExtSetHostPktV.
+ */
+typedef struct ExtHostPktSpan_tag {
+    const char *data;
+    int        nBytes;
+} ExtHostPktSpan;
+
 /****************************************
  * Dynamic vs. Static memory allocation *
  ****************************************/
@@ -197,6 +197,18 @@ void rtExtModeCheckEndTrigger(void)
 #endif
 }
 
+/*
+ * Install the parameters downloaded with EXTMODE_STAGED_SETPARAM.  The caller
+ * must make sure that no task of the model is executing, e.g. a multitasking
+ * main calls this only when all subrates have completed their steps.
+ */
+void rtExtModeSetParamApply(void)
+{
+#if defined(EXTMODE_STAGED_SETPARAM) && !defined(EXTMODE_DISABLEPARAMETERTUNING)
+    SetParamApplyPending();
+#endif
+}
+
 void rtExtModeUploadCheckTrigger(int_T numSampTimes)
 {
 #ifndef EXTMODE_DISABLESIGNALMONITORING
@@ -65,6 +65,8 @@ extern void rtExtModeOneStep(RTWExtModeInfo *ei,
 
 extern void rtExtModeCheckEndTrigger(void);
 
+extern void rtExtModeSetParamApply(void);
+
 extern void rtExtModeUploadCheckTrigger(int_T numSampTimes);
 
 extern void rtExtModeUpload(int_T tid,
@@ -107,6 +109,7 @@ extern void rtERTExtModeStartMsg(void);
 
 #define rtExtModeOneStep(ei,st,sr) /* do nothing */
 #define rtExtModeCheckEndTrigger() /* do nothing */
+#define rtExtModeSetParamApply() /* do nothing */
 #define rtExtModeUploadCheckTrigger(numSampTimes) /* do nothing */
 #define rtExtModeUpload(t,ttime) /* do nothing */
 #define rtExtModeCheckInit(numSampTimes) /* do nothing */
@@ -10,7 +10,7 @@
 #include <stdlib.h>
 #include <string.h>
 
-#ifdef VERBOSE
+#if defined(VERBOSE) || !defined(EXTMODE_DISABLEPRINTF)
 #include <stdio.h>
 #endif
 
@@ -32,319 +32,241 @@
 #  endif
 #endif
 
+/*
+ * The static memory buffer is managed with a two-level segregated fit
+ * allocator.  Free blocks are kept in one list per size class.  The first
+ * level splits sizes by power of two and the second level splits each power
+ * of two into MEM_SL_COUNT equal ranges.  One bitmap per level records which
+ * lists are non-empty, so finding a free block that fits, splitting it and
+ * merging a freed block with its free neighbors all take constant time.
+ *
+ * Blocks are laid out back to back.  Each block header holds the block size
+ * and a pointer to the block before it, which is all that is needed to find
+ * both neighbors on ExtModeFree.  A zero-sized, allocated sentinel block
+ * ends the buffer.
+ */
+#define MEM_ALIGN        8U
+#define MEM_ALIGN_UP(n)  (((n) + (MEM_ALIGN-1U)) & ~(MEM_ALIGN-1U))
+#define MEM_FREE_BIT     1U
+#define MEM_SIZE_MASK    (~(MEM_ALIGN-1U))
+
+#define MEM_SL_LOG2      3
+#define MEM_SL_COUNT     (1 << MEM_SL_LOG2)
+#define MEM_FL_SHIFT     (MEM_SL_LOG2 + 3)                 /* log2(MEM_ALIGN) */
+#define MEM_FL_COUNT     (32 - MEM_FL_SHIFT + 1)
+#define MEM_SMALL_SIZE   (1U << MEM_FL_SHIFT)
+
+/* Bytes in front of the data of an allocated block. */
+#define MEM_HDR_SIZE     MEM_ALIGN_UP((uint32_T)offsetof(MemBufHdr, memBufNext))
+/* Smallest block: must hold the free list links. */
+#define MEM_MIN_BLOCK    MEM_ALIGN_UP((uint32_T)sizeof(MemBufHdr))
+
+#define MEM_BLOCK_SIZE(b)  ((b)->size & MEM_SIZE_MASK)
+#define MEM_IS_FREE(b)     (((b)->size & MEM_FREE_BIT) != 0U)
+#define MEM_NEXT_PHYS(b)   ((MemBufHdr *)((char *)(b) + MEM_BLOCK_SIZE(b)))
+
 PRIVATE char MemoryBuffer[EXTMODE_STATIC_SIZE];
 
-PRIVATE MemBufHdr *FreeQueue = NULL;
-PRIVATE MemBufHdr InUseQueue = {NULL, NULL, NULL, 0};
+PRIVATE boolean_T MemInitialized = false;
+PRIVATE uint32_T  FlBitmap;
+PRIVATE uint32_T  SlBitmap[MEM_FL_COUNT];
+PRIVATE MemBufHdr *FreeLists[MEM_FL_COUNT][MEM_SL_COUNT];
 
-#ifdef VERBOSE
-uint32_T numBytesAllocated = 0;
-#endif
+PRIVATE ExtModeMemStats MemStats;
 
-PRIVATE void insertMemBufRight(MemBufHdr *buf, MemBufHdr *queue)
+/* Index of the most significant set bit of x (x != 0). */
+PRIVATE int memFls(uint32_T x)
 {
-    assert(queue != NULL);
-    assert(buf != NULL);
-
-    buf->memBufPrev = queue;
-    buf->memBufNext = queue->memBufNext;
-
-    if (buf->memBufNext != NULL) {
-	buf->memBufNext->memBufPrev = buf;
-    }
-
-    queue->memBufNext = buf;
+#if defined(__GNUC__)
+    return (int)(8*sizeof(unsigned long) - 1) - __builtin_clzl((unsigned long)x);
+#else
+    int bit = 0;
+
+    if (x & 0xffff0000U) { x >>= 16; bit += 16; }
+    if (x & 0xff00U)     { x >>= 8;  bit += 8;  }
+    if (x & 0xf0U)       { x >>= 4;  bit += 4;  }
+    if (x & 0xcU)        { x >>= 2;  bit += 2;  }
+    if (x & 0x2U)        {           bit += 1;  }
+    return bit;
+#endif
 }
 
-PRIVATE void removeMemBuf(MemBufHdr *buf)
+/* Index of the least significant set bit of x (x != 0). */
+PRIVATE int memFfs(uint32_T x)
 {
-    MemBufHdr *rightMemBuf;
-    MemBufHdr *leftMemBuf;
-
-    assert(buf != NULL);
-
-    rightMemBuf = buf->memBufNext;
-    leftMemBuf  = buf->memBufPrev;
-
-    if (rightMemBuf != NULL) {
-	rightMemBuf->memBufPrev = leftMemBuf;
-    }
-    if (leftMemBuf != NULL) {
-	leftMemBuf->memBufNext = rightMemBuf;
-    }
-
-    buf->memBufNext = NULL;
-    buf->memBufPrev = NULL;
+    return memFls(x & (~x + 1U));
 }
 
-PRIVATE boolean_T moveRight(MemBufHdr *buf)
+/* Size class of a block of the given size. */
+PRIVATE void mappingInsert(uint32_T size, int *fl, int *sl)
 {
-    MemBufHdr *buf2;
-
-    assert(buf != NULL);
-
-    if (buf->memBufNext == NULL) {
-	return false;
+    if (size < MEM_SMALL_SIZE) {
+        *fl = 0;
+        *sl = (int)(size / (MEM_SMALL_SIZE / MEM_SL_COUNT));
     } else {
-	buf2 = buf->memBufNext;
-	removeMemBuf(buf);
-	insertMemBufRight(buf,buf2);
+        int f = memFls(size);
+        *sl = (int)(size >> (f - MEM_SL_LOG2)) ^ MEM_SL_COUNT;
+        *fl = f - (MEM_FL_SHIFT - 1);
     }
-    return true;    
 }
 
-PRIVATE boolean_T sortRight(MemBufHdr *buf)
+/*
+ * Smallest size class whose blocks are all at least 'size' bytes.  Returns
+ * false if there is no such class.
+ */
+PRIVATE boolean_T mappingSearch(uint32_T size, int *fl, int *sl)
 {
-    assert(buf != NULL);
-
-    if ((buf->memBufNext != NULL) && (buf > buf->memBufNext)) {
-	return moveRight(buf);
+    if (size >= MEM_SMALL_SIZE) {
+        uint32_T round = (1U << (memFls(size) - MEM_SL_LOG2)) - 1U;
+        if (size > 0xffffffffU - round) return false;
+        size += round;
     }
-    return false;
+    mappingInsert(size, fl, sl);
+    return (boolean_T)(*fl < MEM_FL_COUNT);
 }
 
-PRIVATE boolean_T sortLeft(MemBufHdr *buf)
+PRIVATE void insertFreeMemBuf(MemBufHdr *buf)
 {
-    assert(buf != NULL);
+    int fl, sl;
+    MemBufHdr *head;
 
-    if ((buf->memBufPrev != NULL) && (buf < buf->memBufPrev)) {
-	return moveRight(buf->memBufPrev);
-    }
-    return false;
-}
+    mappingInsert(MEM_BLOCK_SIZE(buf), &fl, &sl);
+    head = FreeLists[fl][sl];
 
-PRIVATE boolean_T mergeWithMemBufOnRight(MemBufHdr *buf)
-{
-    assert(buf != NULL);
+    buf->size      |= MEM_FREE_BIT;
+    buf->memBufPrev = NULL;
+    buf->memBufNext = head;
+    if (head != NULL) head->memBufPrev = buf;
+    FreeLists[fl][sl] = buf;
 
-    /*
-     * If this memory buffer is adjacent to a free memory buffer to its right,
-     * merge the two memory buffers into one contiguous free memory buffer.
-     */
-    if (buf->memBufNext != NULL) {
-	MemBufHdr *leftMemBuf   = buf;
-	MemBufHdr *rightMemBuf  = buf->memBufNext;
-	
-	/* Assumes data portion of mem buf is contiguous with mem buf header. */
-	char *pointer1 = ((char *)leftMemBuf + sizeof(MemBufHdr) + leftMemBuf->size);
-	char *pointer2 = (char *)leftMemBuf->memBufNext;
-
-	if (pointer1 == pointer2)
-        {
-            removeMemBuf(rightMemBuf);
-            leftMemBuf->size += rightMemBuf->size + sizeof(MemBufHdr);
-            return true;
-        }
-    }
-    return false;
+    FlBitmap     |= (1U << fl);
+    SlBitmap[fl] |= (1U << sl);
+
+    MemStats.numFreeBlocks++;
 }
 
-PRIVATE boolean_T mergeMemBuf(MemBufHdr *buf)
+PRIVATE void removeFreeMemBuf(MemBufHdr *buf)
 {
-    boolean_T statusRight = false;
-    boolean_T statusLeft  = false;
+    int fl, sl;
 
-    assert(buf != NULL);
-
-    statusRight = mergeWithMemBufOnRight(buf);
+    assert(MEM_IS_FREE(buf));
+    mappingInsert(MEM_BLOCK_SIZE(buf), &fl, &sl);
 
+    if (buf->memBufNext != NULL) buf->memBufNext->memBufPrev = buf->memBufPrev;
     if (buf->memBufPrev != NULL) {
-        statusLeft = mergeWithMemBufOnRight(buf->memBufPrev);
+        buf->memBufPrev->memBufNext = buf->memBufNext;
+    } else {
+        FreeLists[fl][sl] = buf->memBufNext;
+        if (FreeLists[fl][sl] == NULL) {
+            SlBitmap[fl] &= ~(1U << sl);
+            if (SlBitmap[fl] == 0U) FlBitmap &= ~(1U << fl);
+        }
     }
 
-    return (statusRight | statusLeft);
-}
-
-PRIVATE MemBufHdr *inUseQueueFindMemBufHdr(void *mem)
-{
-    MemBufHdr *LocalBuf;
-
-    assert(mem != NULL);
-
-    LocalBuf = &InUseQueue;
-
-    if (LocalBuf->MemBuf == mem) return LocalBuf;
-
-    while (LocalBuf->memBufNext != NULL) {
-	LocalBuf = LocalBuf->memBufNext;
-        if (LocalBuf->MemBuf == mem) return LocalBuf;
-    }
+    buf->size      &= ~MEM_FREE_BIT;
+    buf->memBufNext = NULL;
+    buf->memBufPrev = NULL;
 
-    return NULL;
+    MemStats.numFreeBlocks--;
 }
 
-PRIVATE void inUseQueueInsert(MemBufHdr *buf)
+/* First non-empty free list at or above class (fl, sl). */
+PRIVATE MemBufHdr *findFreeMemBuf(int fl, int sl)
 {
-    MemBufHdr *LocalBuf;
+    uint32_T slMap = SlBitmap[fl] & (0xffffffffU << sl);
 
-    assert(buf != NULL);
+    if (slMap == 0U) {
+        uint32_T flMap = FlBitmap & (0xffffffffU << (fl + 1));
+        if (flMap == 0U) return NULL;
 
-    LocalBuf = &InUseQueue;
-    while (LocalBuf->memBufNext != NULL) {
-	LocalBuf = LocalBuf->memBufNext;
-	continue;
+        fl    = memFfs(flMap);
+        slMap = SlBitmap[fl];
     }
-    insertMemBufRight(buf, LocalBuf);
-}
-
-PRIVATE void sortQueue(MemBufHdr *buf)
-{
-    int count = 1;
-
-    assert(buf != NULL);
-
-    /* Bi-directional bubble sort...
-     *
-     * Whatever packet given, move it left until the packet to the
-     * left belongs there, or there is no packet to the left.
-     *
-     * If there is a packet to the left, move it to the left as
-     * above. 
-     *
-     * If there is no packet to the left, reverse direction moving
-     * packets to the right.
-     *
-     * Repeat this until no packets are moved.
-     */
+    sl = memFfs(slMap);
 
-    /* While something moves... */
-    while (count > 0) {
-	count = 0;
-
-	/* Bubble left. */
-	while (1) {
-	    /* Move the current packet as far left as it will go. */
-	    if (sortLeft(buf)) {
-		count++;
-		continue;
-	    } else {
-		/* Try to merge the packet with its neighbor to the right. */
-		mergeMemBuf(buf);
-
-		/* Move the MemBufHdr to the left, if possible, and
-		 * continue bubbling left.
-		 */ 
-		if (buf->memBufPrev != NULL) {
-		    buf = buf->memBufPrev;
-		    continue;
-		} else {
-		    break;
-		}
-	    }
-	}
-
-	/* All done bubbling to the left. Now bubble to the right. */
-
-	/* Bubble right. */
-	while (1) {
-	    /* Move the current packet as far right as it will go. */
-	    if (sortRight(buf)) {
-		count++;
-		continue;
-	    } else {
-		/* Try to merge the packet with its neighbor to the right. */
-		mergeMemBuf(buf);
-
-		/* Move the MemBufHdr to the right, if possible, and
-		 * continue bubbling right.
-		 */ 
-		if (buf->memBufNext != NULL) {
-		    buf = buf->memBufNext;
-		    continue;
-		} else {
-		    break;
-		}
-	    }
-	}
-    }
+    return FreeLists[fl][sl];
 }
 
 PRIVATE void initFreeQueue(void)
 {
-    MemBufHdr *initialFreeMemBuf = NULL;
-
-#ifdef VERBOSE
-    /* There is always at least one header allocated from the buffer. */
-    numBytesAllocated = sizeof(MemBufHdr);
-#endif
-
-    /* The FreeQueue is a pointer to a "free" buffer. */
-    FreeQueue = (MemBufHdr *)MemoryBuffer;
-
-    /*
-     * The first free packet describes blocks of free space in the free queue
-     * buffer (initially the whole buffer) and, as space becomes fragmented, is
-     * linked to other "free" buffers.
-     */
-    initialFreeMemBuf = FreeQueue;
-
-    /*
-     * The location and size of the initial free buffer describes the whole
-     * memory buffer.
-     */
-    initialFreeMemBuf->MemBuf = (char *)initialFreeMemBuf + sizeof(MemBufHdr);
-    initialFreeMemBuf->size   = sizeof(MemoryBuffer) - sizeof(MemBufHdr);
-
-    /*
-     * When there is only one, contiguous memory buffer, the initial free
-     * buffer is linked to no other free buffers. When there are more than
-     * one, or discontiguous free buffers, these links tie together all free
-     * buffers.
-     */
-    initialFreeMemBuf->memBufPrev = NULL;
-    initialFreeMemBuf->memBufNext = NULL;
-}
-
-PRIVATE MemBufHdr *findFirstFreeMemBuf(const int bufSize)
-{
-    /* Get the first free packet. */
-    MemBufHdr *buf = FreeQueue;
-
-    /*
-     * Loop until we find a free packet big enough for our request or we
-     * run out of free packets.
-     */
-    while (buf != NULL) {
-        /* Take the first free packet that fits. */
-        if (buf->size >= bufSize) {
-            /* Got it. Break out to continue. */
-            break;
-        }
-        /* Get the next free packet. */
-        buf = buf->memBufNext;
-    }
-
-    return buf;
+    char      *start = (char *)MemoryBuffer;
+    char      *end   = (char *)MemoryBuffer + sizeof(MemoryBuffer);
+    MemBufHdr *initialFreeMemBuf;
+    MemBufHdr *sentinel;
+    uint32_T  size;
+
+    memset(SlBitmap, 0, sizeof(SlBitmap));
+    memset(FreeLists, 0, sizeof(FreeLists));
+    memset(&MemStats, 0, sizeof(MemStats));
+    FlBitmap = 0U;
+
+    /* Align the start of the first block and leave room for the sentinel. */
+    start += (MEM_ALIGN - (uint32_T)((size_t)start % MEM_ALIGN)) % MEM_ALIGN;
+    size   = (uint32_T)(end - start);
+    size   = (size & MEM_SIZE_MASK) - MEM_HDR_SIZE;
+
+    initialFreeMemBuf           = (MemBufHdr *)start;
+    initialFreeMemBuf->prevPhys = NULL;
+    initialFreeMemBuf->size     = size;
+
+    sentinel           = MEM_NEXT_PHYS(initialFreeMemBuf);
+    sentinel->prevPhys = initialFreeMemBuf;
+    sentinel->size     = 0U;
+
+    insertFreeMemBuf(initialFreeMemBuf);
+
+    MemStats.poolSize = size;
+    MemInitialized    = true;
 }
 
 PUBLIC void ExtModeFree(void *mem)
 {
-    MemBufHdr *buf = NULL;
+    MemBufHdr *buf;
+    MemBufHdr *next;
+    MemBufHdr *prev;
 
     if (mem == NULL) return;
 
-    /* Find the header associated with the memory pointer. */
-    buf = inUseQueueFindMemBufHdr(mem);
-    assert(buf != NULL);
+    buf = (MemBufHdr *)((char *)mem - MEM_HDR_SIZE);
+    assert(!MEM_IS_FREE(buf));
+
+    MemStats.bytesInUse -= MEM_BLOCK_SIZE(buf);
+    MemStats.numBlocksInUse--;
+    MemStats.numFrees++;
 
 #ifdef VERBOSE
-    numBytesAllocated -= (buf->size + sizeof(MemBufHdr));
-    printf("\nBytes allocated: %d out of %d.\n", numBytesAllocated, EXTMODE_STATIC_SIZE);
+    printf("\nBytes allocated: %d out of %d.\n",
+           (int)MemStats.bytesInUse, EXTMODE_STATIC_SIZE);
 #endif
 
-    /* Remove the buffer from the linked list. */
-    removeMemBuf(buf);
+    /* Merge with the free block on the right. */
+    next = MEM_NEXT_PHYS(buf);
+    if (MEM_IS_FREE(next)) {
+        removeFreeMemBuf(next);
+        buf->size += MEM_BLOCK_SIZE(next);
+        MEM_NEXT_PHYS(buf)->prevPhys = buf;
+    }
+
+    /* Merge with the free block on the left. */
+    prev = buf->prevPhys;
+    if ((prev != NULL) && MEM_IS_FREE(prev)) {
+        removeFreeMemBuf(prev);
+        prev->size += MEM_BLOCK_SIZE(buf);
+        MEM_NEXT_PHYS(prev)->prevPhys = prev;
+        buf = prev;
+    }
 
-    /* Put the buffer back in the free queue. */
-    insertMemBufRight(buf, FreeQueue);
-    mergeMemBuf(buf);
+    insertFreeMemBuf(buf);
 }
 
 PUBLIC void *ExtModeCalloc(uint32_T number, uint32_T size)
 {
     uint32_T numBytes = number*size;
-    void     *mem     = ExtModeMalloc(numBytes);
+    void     *mem     = NULL;
+
+    if ((size != 0U) && (numBytes/size != number)) goto EXIT_POINT;
 
+    mem = ExtModeMalloc(numBytes);
     if (mem == NULL) goto EXIT_POINT;
 
     memset(mem, 0, numBytes);
@@ -355,85 +277,123 @@ PUBLIC void *ExtModeCalloc(uint32_T number, uint32_T size)
 
 PUBLIC void *ExtModeMalloc(uint32_T size)
 {
-    boolean_T keepTrying = false;
-
     MemBufHdr *LocalMemBuf = NULL; /* Requested buffer (NULL if none available). */
-    MemBufHdr *FreeMemBuf = NULL;  /* First free buffer big enough for request. */
+    uint32_T  sizeToAlloc;
+    int       fl, sl;
+
+    /* Initialize the free lists. */
+    if (!MemInitialized) initFreeQueue();
 
     /*
      * Must allocate enough space for the requested number of bytes plus the
      * size of the memory buffer header.
      */
-    int sizeToAlloc = size + sizeof(MemBufHdr);
-
-    while (!keepTrying) {
-        keepTrying = true;
+    if (size > MemStats.poolSize) goto EXIT_POINT;
+    sizeToAlloc = MEM_ALIGN_UP(size + MEM_HDR_SIZE);
+    if (sizeToAlloc < MEM_MIN_BLOCK) sizeToAlloc = MEM_MIN_BLOCK;
 
-        LocalMemBuf = NULL;
-        FreeMemBuf  = NULL;
+    /* Find a free block from the first size class that is big enough. */
+    if (!mappingSearch(sizeToAlloc, &fl, &sl)) goto EXIT_POINT;
+    LocalMemBuf = findFreeMemBuf(fl, sl);
+    if (LocalMemBuf == NULL) goto EXIT_POINT;
 
-        /* Initialize the free queue. */
-        if (FreeQueue == NULL) initFreeQueue();
+    removeFreeMemBuf(LocalMemBuf);
+    assert(MEM_BLOCK_SIZE(LocalMemBuf) >= sizeToAlloc);
 
-        /* Find first free packet big enough for our request. */
-        FreeMemBuf = findFirstFreeMemBuf(sizeToAlloc);
+    /* Give the unused end of the block back to the free lists. */
+    if (MEM_BLOCK_SIZE(LocalMemBuf) - sizeToAlloc >= MEM_MIN_BLOCK) {
+        MemBufHdr *rest = (MemBufHdr *)((char *)LocalMemBuf + sizeToAlloc);
 
-        if (FreeMemBuf == NULL) {
-            /* We couldn't find a free buffer.  Run garbage collection to merge
-               free buffers together and try again. */
-            sortQueue(FreeQueue);
-
-            FreeMemBuf = findFirstFreeMemBuf(sizeToAlloc);
-        }
+        rest->prevPhys = LocalMemBuf;
+        rest->size     = MEM_BLOCK_SIZE(LocalMemBuf) - sizeToAlloc;
+        MEM_NEXT_PHYS(rest)->prevPhys = rest;
 
-        /* No free buffers are available which satisfy the request. */
-        if (FreeMemBuf == NULL) goto EXIT_POINT;
-
-        /*
-         * Found a free buffer with enough space.  Carve out the exact buffer size
-         * needed from the end of the free buffer.
-         */
-        LocalMemBuf = (MemBufHdr *)(FreeMemBuf->MemBuf +
-                                    FreeMemBuf->size -
-                                    sizeToAlloc);
-
-        /*
-         * The pointer to the free memory must be longword aligned.  If it
-         * is not, adjust the size to allocate and try again.
-         */
-        {
-            int alignBytes = (int)((ptrdiff_t)LocalMemBuf % 4);
-            if (alignBytes) {
-                sizeToAlloc += (4-alignBytes);
-                keepTrying = false;
-            }
-        }
+        LocalMemBuf->size = sizeToAlloc;
+        insertFreeMemBuf(rest);
     }
 
-    /* Set up the new packet's info. */
-    LocalMemBuf->memBufPrev = NULL;
-    LocalMemBuf->memBufNext = NULL;
-    LocalMemBuf->MemBuf     = (char *)LocalMemBuf + sizeof(MemBufHdr);
-    LocalMemBuf->size       = size;
-
-    /* Insert the newly created buffer into the InUseQueue. */
-    inUseQueueInsert(LocalMemBuf);
-
-    /* Update the free packet's size to reflect giving up a piece. */
-    FreeMemBuf->size -= sizeToAlloc;
+    MemStats.bytesInUse += MEM_BLOCK_SIZE(LocalMemBuf);
+    MemStats.numBlocksInUse++;
+    MemStats.numAllocs++;
+    if (MemStats.bytesInUse > MemStats.highWaterMark) {
+        MemStats.highWaterMark = MemStats.bytesInUse;
+    }
 
   EXIT_POINT:
     if (LocalMemBuf) {
 #ifdef VERBOSE
-        numBytesAllocated += sizeToAlloc;
-        printf("\nBytes allocated: %d out of %d.\n", numBytesAllocated, EXTMODE_STATIC_SIZE);
+        printf("\nBytes allocated: %d out of %d.\n",
+               (int)MemStats.bytesInUse, EXTMODE_STATIC_SIZE);
 #endif
-        return LocalMemBuf->MemBuf;
+        return (char *)LocalMemBuf + MEM_HDR_SIZE;
     }
 
+    MemStats.numFailures++;
 #ifdef VERBOSE
-    printf("\nBytes allocated: %d out of %d.", numBytesAllocated+sizeToAlloc, EXTMODE_STATIC_SIZE);
+    printf("\nBytes allocated: %d out of %d.",
+           (int)(MemStats.bytesInUse + size), EXTMODE_STATIC_SIZE);
     printf("\nMust increase size of static allocation!\n");
 #endif
     return NULL;
 }
+
+/*
+ * Copy the usage statistics of the static memory buffer.  largestFreeBlock
+ * is found by walking the highest non-empty free list.
+ */
+PUBLIC void ExtModeMemGetStats(ExtModeMemStats *stats)
+{
+    if (!MemInitialized) initFreeQueue();
+
+    *stats = MemStats;
+    stats->largestFreeBlock = 0U;
+
+    if (FlBitmap != 0U) {
+        int       fl  = memFls(FlBitmap);
+        int       sl  = memFls(SlBitmap[fl]);
+        MemBufHdr *buf = FreeLists[fl][sl];
+
+        for (; buf != NULL; buf = buf->memBufNext) {
+            if (MEM_BLOCK_SIZE(buf) > stats->largestFreeBlock) {
+                stats->largestFreeBlock = MEM_BLOCK_SIZE(buf);
+            }
+        }
+    }
+}
+
+/*
+ * Print the usage statistics of the static memory buffer.  Fragmentation
+ * is the share of the free bytes that are not in the largest free block.
+ */
+PUBLIC void ExtModeMemReport(void)
+{
+#ifndef EXTMODE_DISABLEPRINTF
+    ExtModeMemStats stats;
+    uint32_T        bytesFree;
+    uint32_T        bytesFrag;
+    uint32_T        fragPercent = 0U;
+
+    ExtModeMemGetStats(&stats);
+    bytesFree = stats.poolSize - stats.bytesInUse;
+    bytesFrag = bytesFree - stats.largestFreeBlock;
+
+    /* Integer arithmetic: real_T may be an integer type (INTEGER_CODE). */
+    while (bytesFrag > 0xffffffffU/100U) {
+        bytesFrag >>= 1;
+        bytesFree >>= 1;
+    }
+    if (bytesFree > 0U) fragPercent = (100U*bytesFrag)/bytesFree;
+
+    printf("\nExternal mode static memory: %lu of %lu bytes in use, "
+           "high-water mark %lu bytes.\n",
+           (unsigned long)stats.bytesInUse, (unsigned long)stats.poolSize,
+           (unsigned long)stats.highWaterMark);
+    printf("  %lu allocations, %lu frees, %lu failed allocations.\n",
+           (unsigned long)stats.numAllocs, (unsigned long)stats.numFrees,
+           (unsigned long)stats.numFailures);
+    printf("  %lu free blocks, largest %lu bytes, fragmentation %lu%%.\n",
+           (unsigned long)stats.numFreeBlocks,
+           (unsigned long)stats.largestFreeBlock,
+           (unsigned long)fragPercent);
+#endif
+}
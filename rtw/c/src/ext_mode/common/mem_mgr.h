@@ -1,7 +1,7 @@
 /*
  * Copyright 1994-2002 The MathWorks, Inc.
  *
- * File: mem_mgr.h     
+ * File: mem_mgr.h
  *
  * Abstract:
  */
@@ -9,21 +9,46 @@
 #ifndef __MEM_MGR__
 #define __MEM_MGR__
 
+/*
+ * Every block of the static memory buffer, allocated or free, starts with
+ * this header.  memBufNext and memBufPrev link the free blocks of one size
+ * class and overlay the data of allocated blocks.
+ */
 struct MemBufHdr {
-    struct MemBufHdr *memBufNext;
-    struct MemBufHdr *memBufPrev;
-    char   *MemBuf;
-    int    size;
+    struct MemBufHdr *prevPhys;   /* block just before this one in memory  */
+    uint32_T         size;        /* block bytes incl. header, bit 0: free */
+    struct MemBufHdr *memBufNext; /* free blocks only                      */
+    struct MemBufHdr *memBufPrev; /* free blocks only                      */
 };
 
 typedef struct MemBufHdr MemBufHdr;
 
+/*
+ * Usage statistics of the static memory buffer.  Byte counts include the
+ * block headers.
+ */
+typedef struct ExtModeMemStats_tag {
+    uint32_T poolSize;         /* bytes managed by the allocator           */
+    uint32_T bytesInUse;       /* bytes in allocated blocks                */
+    uint32_T highWaterMark;    /* largest value bytesInUse has reached     */
+    uint32_T numBlocksInUse;   /* number of allocated blocks               */
+    uint32_T numFreeBlocks;    /* number of free blocks                    */
+    uint32_T largestFreeBlock; /* bytes in the largest free block          */
+    uint32_T numAllocs;        /* successful ExtModeMalloc calls           */
+    uint32_T numFrees;         /* ExtModeFree calls                        */
+    uint32_T numFailures;      /* ExtModeMalloc calls that returned NULL   */
+} ExtModeMemStats;
+
 extern void ExtModeFree(void *mem);
 
 extern void *ExtModeMalloc(uint32_T size);
 
 extern void *ExtModeCalloc(uint32_T number, uint32_T size);
 
+extern void ExtModeMemGetStats(ExtModeMemStats *stats);
+
+extern void ExtModeMemReport(void);
+
 #endif /* __MEM_MGR__ */
 
 /* [EOF] mem_mgr.h */
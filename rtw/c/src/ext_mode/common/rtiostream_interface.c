@@ -237,6 +237,55 @@ PUBLIC boolean_T ExtSetHostPkt(
 
 } /* end ExtSetHostPkt */
 
+/* Function: ExtSetHostPktV ====================================================
+ * Abstract:
+ *  Sets (sends) a list of data spans on the comm line, in order, as one
+ *  contiguous stream of bytes.  The spans are sent in place, so the caller
+ *  must not modify them until this function returns.  The total number of
+ *  bytes set is returned via the 'nBytesSet' parameter.  EXT_NO_ERROR is
+ *  returned on success, EXT_ERROR is returned on failure.
+ *
+ * NOTES:
+ *  o it is always o.k. for this function to block if no room is available
+ */
+PUBLIC boolean_T ExtSetHostPktV(
+    const ExtUserData    *UD,
+    const int            nSpans,
+    const ExtHostPktSpan *spans,
+    int                  *nBytesSet)
+{
+    boolean_T errorCode = EXT_NO_ERROR;
+    int_T rtIOStreamErrorStatus;
+    int_T i;
+    *nBytesSet = 0; /* assume */
+
+    #ifdef VXWORKS
+        semTake(commSem, WAIT_FOREVER);
+    #endif
+
+    for (i = 0; i < nSpans; i++) {
+        if (spans[i].nBytes == 0) continue;
+
+        /* Blocks until all requested outgoing data is sent */
+        rtIOStreamErrorStatus = rtIOStreamBlockingSend(UD->streamID,
+                                                       (const void *) spans[i].data,
+                                                       (uint32_T) spans[i].nBytes);
+
+        if (rtIOStreamErrorStatus == RTIOSTREAM_ERROR) {
+            errorCode = EXT_ERROR;
+            break;
+        }
+        *nBytesSet += spans[i].nBytes;
+    }
+
+    #ifdef VXWORKS
+        semGive(commSem);
+    #endif
+
+    return errorCode;
+
+} /* end ExtSetHostPktV */
+
 /* Function: ExtGetHostPkt =====================================================
  * Abstract:
  *  Attempts to get the specified number of bytes from the comm line.  The
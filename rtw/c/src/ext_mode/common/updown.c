@@ -75,6 +75,22 @@
     #include EXTMODE_INTERRUPT_INC_HDR
 #endif
 
+/*
+ * The byte counts shared by the model tasks and the upload server (see
+ * CircularBuf) are accessed with the GCC __atomic acquire/release builtins
+ * when these are lock free for an unsigned int.  Otherwise they are plain
+ * volatile accesses, wrapped in the critical region above if
+ * EXTMODE_PROTECT_CRITICAL_REGIONS is defined.
+ */
+#ifndef EXTMODE_CIRCBUF_ATOMICS
+# if defined(__GNUC__) && defined(__GCC_ATOMIC_INT_LOCK_FREE) && \
+     (__GCC_ATOMIC_INT_LOCK_FREE == 2)
+#  define EXTMODE_CIRCBUF_ATOMICS 1
+# else
+#  define EXTMODE_CIRCBUF_ATOMICS 0
+# endif
+#endif
+
 /**********************
  * External Variables *
  **********************/
@@ -148,8 +164,158 @@ PRIVATE double DType2Double(
 #endif
 
 
-/* Function: SetParam ==========================================================
- * Install new parameters.
+#ifndef EXTMODE_DISABLEPARAMETERTUNING
+typedef struct ParamBatch_tag ParamBatch;
+#endif
+
+#if defined(EXTMODE_STAGED_SETPARAM) && !defined(EXTMODE_DISABLEPARAMETERTUNING)
+/*
+ * Staged parameter download.  SetParamStage decodes an EXT_SETPARAM packet
+ * into a batch instead of writing the parameters, and SetParamCommit hands
+ * the batch to the model.  SetParamApplyPending, called by the model between
+ * steps (see rtExtModeSetParamApply), then installs all parameters of the
+ * batch at once, so the model never runs with a partially updated set.  Two
+ * batches are used so that the next packets can be decoded while the
+ * previous batch waits to be applied; packets staged while the model has not
+ * taken the previous batch are collected in the fill batch and committed
+ * together later.
+ */
+typedef struct ParamUpdate_tag {
+    char_T    *dst;       /* parameter memory                     */
+    int_T     nBytes;     /* number of bytes to install           */
+    int_T     dataOffset; /* offset of the new values in the data */
+#ifdef MW_DYNAMIC_STRING_SUPPORT
+    boolean_T isString;
+#endif
+} ParamUpdate;
+
+struct ParamBatch_tag {
+    int_T       nUpdates;
+    int_T       maxUpdates;
+    ParamUpdate *updates;
+
+    int_T       nBytes;
+    int_T       maxBytes;
+    char_T      *data;    /* new values, each 8 byte aligned */
+};
+
+#define PARAM_DATA_ALIGN (8)
+
+PRIVATE ParamBatch      paramBatches[2];
+PRIVATE int_T           paramFillIdx = 0; /* batch SetParamStage writes to */
+PRIVATE volatile uint_T paramPending = 0; /* 1 + idx of batch to apply     */
+
+
+/* Function: ParamPendingLoad ==================================================
+ * Read the index of the batch the model is to apply, 0 if none.  Everything
+ * written to that batch before it was committed is visible once it is read.
+ */
+PRIVATE uint_T ParamPendingLoad(void)
+{
+#if EXTMODE_CIRCBUF_ATOMICS
+    return __atomic_load_n(&paramPending, __ATOMIC_ACQUIRE);
+#else
+    uint_T value;
+
+#ifdef EXTMODE_PROTECT_CRITICAL_REGIONS
+    EXTMODE_DISABLE_INTERRUPTS;
+#endif
+    value = paramPending;
+#ifdef EXTMODE_PROTECT_CRITICAL_REGIONS
+    EXTMODE_ENABLE_INTERRUPTS;
+#endif
+    return value;
+#endif
+} /* end ParamPendingLoad */
+
+
+/* Function: ParamPendingStore =================================================
+ * Commit a batch to the model (1 + idx), or mark the committed batch as
+ * applied (0).  All accesses to the batch made before the call are visible to
+ * the other side once it reads the new value.
+ */
+PRIVATE void ParamPendingStore(uint_T value)
+{
+#if EXTMODE_CIRCBUF_ATOMICS
+    __atomic_store_n(&paramPending, value, __ATOMIC_RELEASE);
+#else
+#ifdef EXTMODE_PROTECT_CRITICAL_REGIONS
+    EXTMODE_DISABLE_INTERRUPTS;
+#endif
+    paramPending = value;
+#ifdef EXTMODE_PROTECT_CRITICAL_REGIONS
+    EXTMODE_ENABLE_INTERRUPTS;
+#endif
+#endif
+} /* end ParamPendingStore */
+
+
+/* Function: ParamBatchAdd =====================================================
+ * Append a parameter update to a batch, growing the batch as needed.  Returns
+ * the staged copy of the values or NULL if out of memory.
+ */
+PRIVATE const char_T *ParamBatchAdd(ParamBatch *batch,
+                                    char_T     *dst,
+                                    const char *src,
+                                    int_T      nBytes,
+                                    boolean_T  isString)
+{
+    ParamUpdate *update;
+    int_T       offset = (batch->nBytes + PARAM_DATA_ALIGN - 1) &
+                         ~(PARAM_DATA_ALIGN - 1);
+
+    if (batch->nUpdates == batch->maxUpdates) {
+        int_T       maxUpdates = (batch->maxUpdates > 0) ?
+                                  2*batch->maxUpdates : 16;
+        ParamUpdate *updates   = (ParamUpdate *)malloc(
+                                  maxUpdates*sizeof(ParamUpdate));
+
+        if (updates == NULL) return(NULL);
+        if (batch->nUpdates > 0) {
+            (void)memcpy(updates, batch->updates,
+                         batch->nUpdates*sizeof(ParamUpdate));
+        }
+        free(batch->updates);
+        batch->updates    = updates;
+        batch->maxUpdates = maxUpdates;
+    }
+
+    if (offset + nBytes > batch->maxBytes) {
+        int_T  maxBytes = 2*batch->maxBytes;
+        char_T *data;
+
+        if (maxBytes < offset + nBytes) maxBytes = offset + nBytes;
+        data = (char_T *)malloc(maxBytes);
+        if (data == NULL) return(NULL);
+        if (batch->nBytes > 0) {
+            (void)memcpy(data, batch->data, batch->nBytes);
+        }
+        free(batch->data);
+        batch->data     = data;
+        batch->maxBytes = maxBytes;
+    }
+
+    update             = &batch->updates[batch->nUpdates++];
+    update->dst        = dst;
+    update->nBytes     = nBytes;
+    update->dataOffset = offset;
+#ifdef MW_DYNAMIC_STRING_SUPPORT
+    update->isString   = isString;
+#else
+    (void)isString;
+#endif
+
+    (void)memcpy(batch->data + offset, src, nBytes);
+    batch->nBytes = offset + nBytes;
+
+    return(batch->data + offset);
+} /* end ParamBatchAdd */
+#endif
+
+
+/* Function: InstallParams =====================================================
+ * Install new parameters, or add them to batch if it is not NULL.  Returns
+ * false if the batch ran out of memory.
  *
  * NOTE: pbuf looks like:
  *  [NPARAMS
@@ -174,7 +340,9 @@ PRIVATE double DType2Double(
  *      All values, excluding DATA, are int32_T.
  */
 #ifndef EXTMODE_DISABLEPARAMETERTUNING
-PUBLIC void SetParam(RTWExtModeInfo  *ei, const char *pbuf)
+PRIVATE boolean_T InstallParams(RTWExtModeInfo *ei,
+                                const char     *pbuf,
+                                ParamBatch     *batch)
 {
     int        i;
     int32_T    nParams;
@@ -194,6 +362,10 @@ PUBLIC void SetParam(RTWExtModeInfo  *ei, const char *pbuf)
     const char_T* *dtNames = dtGetDataTypeNames(dtInfo);
 #endif
 
+#ifndef EXTMODE_STAGED_SETPARAM
+    (void)batch; /* always NULL */
+#endif
+
     /* unpack NPARAMS */
     (void)memcpy(&nParams, bufPtr, sizeof(int32_T));
     bufPtr += sizeof(int32_T);
@@ -209,6 +381,9 @@ PUBLIC void SetParam(RTWExtModeInfo  *ei, const char *pbuf)
         int_T   elSize;
         int_T   nBytes;
         char_T  *start;
+#ifdef EXTMODE_STAGED_SETPARAM
+        const char_T *newVals = NULL;
+#endif
         char_T  *tranAddress;
         int_T   tranIsComplex;
 
@@ -239,6 +414,18 @@ PUBLIC void SetParam(RTWExtModeInfo  *ei, const char *pbuf)
 #endif
         start = tranAddress + (tmpBuf[SI] * elSize);
 
+#ifdef EXTMODE_STAGED_SETPARAM
+        /* Stage the params, they are installed by SetParamApplyPending. */
+        if (batch != NULL) {
+            boolean_T isString = false;
+#ifdef MW_DYNAMIC_STRING_SUPPORT
+            isString = (boolean_T)(strcmp(dtNames[tmpBuf[DI]], "string") == 0);
+#endif
+            newVals = ParamBatchAdd(batch, start, bufPtr, nBytes, isString);
+            if (newVals == NULL) return(false);
+            bufPtr += nBytes;
+        } else
+#endif
         /* Install the params. */
 #ifdef MW_DYNAMIC_STRING_SUPPORT
         if (strcmp(dtNames[tmpBuf[DI]], "string") == 0) {
@@ -254,15 +441,20 @@ PUBLIC void SetParam(RTWExtModeInfo  *ei, const char *pbuf)
 #ifdef VERBOSE
         /*
          * It is safe to assume that once the params are installed into
-         * the param vector that they are properly aligned.  So we
-         * do our verbosity print-out here.
+         * the param vector (or staged) that they are properly aligned.  So
+         * we do our verbosity print-out here.
          */
         {
             double     val;
             const char *dTypeName;
+#ifdef EXTMODE_STAGED_SETPARAM
+            const char *vPtr = (newVals != NULL) ?
+                (const char *)newVals : (const char *)start;
+#else
             const char *vPtr = (const char *)start;
+#endif
 
-            val = DType2Double(start, tmpBuf[DI], dtInfo, &dTypeName);
+            val = DType2Double(vPtr, tmpBuf[DI], dtInfo, &dTypeName);
             printf("\n\tParam| "
                    "DT_Trans: %d, index: %d, nEls: %d, data type: [%s, %d]\n",
                    tmpBuf[B], tmpBuf[SI], tmpBuf[W],
@@ -290,7 +482,108 @@ PUBLIC void SetParam(RTWExtModeInfo  *ei, const char *pbuf)
         }
 #endif
     }
+    return(true);
+} /* end InstallParams */
+
+
+/* Function: SetParam ==========================================================
+ * Install new parameters from an EXT_SETPARAM packet (see InstallParams).
+ */
+PUBLIC void SetParam(RTWExtModeInfo  *ei, const char *pbuf)
+{
+    (void)InstallParams(ei, pbuf, NULL);
 } /* end SetParam */
+
+
+#ifdef EXTMODE_STAGED_SETPARAM
+/* Function: SetParamStage =====================================================
+ * Decode the parameters of an EXT_SETPARAM packet into the fill batch
+ * without installing them.  They are added after any packets staged but not
+ * yet committed, so these are applied in order at the same step boundary.
+ * Returns EXT_ERROR if out of memory, leaving the earlier packets staged.
+ */
+PUBLIC boolean_T SetParamStage(RTWExtModeInfo *ei, const char *pbuf)
+{
+    ParamBatch *batch   = &paramBatches[paramFillIdx];
+    int_T      nUpdates = batch->nUpdates;
+    int_T      nBytes   = batch->nBytes;
+
+    if (!InstallParams(ei, pbuf, batch)) {
+        batch->nUpdates = nUpdates;
+        batch->nBytes   = nBytes;
+        return(EXT_ERROR);
+    }
+    return(EXT_NO_ERROR);
+} /* end SetParamStage */
+
+
+/* Function: SetParamCommit ====================================================
+ * Hand the fill batch to the model.  Returns false if the model has not yet
+ * applied the previous batch; the fill batch then stays staged and the
+ * packet server tries again later, without waiting for the model.
+ */
+PUBLIC boolean_T SetParamCommit(void)
+{
+    if (paramBatches[paramFillIdx].nUpdates == 0) return(true);
+
+    if (ParamPendingLoad() != 0) return(false);
+
+    ParamPendingStore((uint_T)(paramFillIdx + 1));
+    paramFillIdx = 1 - paramFillIdx;
+
+    /* The model has applied this batch, reuse it for the next packets. */
+    paramBatches[paramFillIdx].nUpdates = 0;
+    paramBatches[paramFillIdx].nBytes   = 0;
+    return(true);
+} /* end SetParamCommit */
+
+
+/* Function: SetParamApplyPending ==============================================
+ * Install the parameters of the committed batch, if any.  Called by the model
+ * while none of its tasks is executing, or by the packet server while the
+ * model is not running.
+ */
+PUBLIC void SetParamApplyPending(void)
+{
+    uint_T pending = ParamPendingLoad();
+
+    if (pending != 0) {
+        const ParamBatch *batch = &paramBatches[pending - 1];
+        int_T            i;
+
+        for (i=0; i<batch->nUpdates; i++) {
+            const ParamUpdate *update = &batch->updates[i];
+            const char_T      *src    = batch->data + update->dataOffset;
+
+#ifdef MW_DYNAMIC_STRING_SUPPORT
+            if (update->isString) {
+                suInitializeString(update->dst, src);
+                continue;
+            }
+#endif
+            (void)memcpy(update->dst, src, update->nBytes);
+        }
+        ParamPendingStore(0);
+    }
+} /* end SetParamApplyPending */
+
+
+/* Function: SetParamTerm ======================================================
+ * Free the parameter batches.  A batch that is still pending is dropped.
+ */
+PUBLIC void SetParamTerm(void)
+{
+    int_T i;
+
+    for (i=0; i<2; i++) {
+        free(paramBatches[i].updates);
+        free(paramBatches[i].data);
+        (void)memset(&paramBatches[i], 0, sizeof(ParamBatch));
+    }
+    paramFillIdx = 0;
+    ParamPendingStore(0);
+} /* end SetParamTerm */
+#endif /* ifdef EXTMODE_STAGED_SETPARAM */
 #endif /* ifndef EXTMODE_DISABLEPARAMETERTUNING */
 
 
@@ -312,19 +605,36 @@ typedef struct BufMemList_tag {
     int_T  nActiveBufs; /* num non-empty bufs                  */
     int_T  *tids;       /* tid associated with each active buf */
     BufMem *bufs;       /* sections of each buffer to upload   */
+
+    int_T          nSpans; /* num non-empty sections in bufs    */
+    ExtHostPktSpan *spans; /* 2 spans per buf (wrapped buffers) */
 } BufMemList;
 
 
+/*
+ * Each circular buffer is a single-producer/single-consumer ring.  The model
+ * task for the tid adds time points at head and the upload server removes
+ * them at tail.  headCount and tailCount are the total number of bytes ever
+ * added and removed; they are the only fields read by the other side, so
+ * neither side ever waits for the other.  headCount - tailCount is the
+ * number of bytes in the buffer, which tells an empty buffer from a full one
+ * when head == tail.  The producer publishes new data by storing headCount
+ * with release semantics and the consumer frees space by storing tailCount
+ * with release semantics.  While pre-triggering the upload server is idle
+ * and the producer also moves the tail.
+ */
 typedef struct CircularBuf_tag {
-    volatile int_T    empty;
-
     int_T    bufSize;
     char_T   *buf;
     
-    char_T* volatile head;
-    char_T* volatile tail;
+    char_T   *head;                /* written by the producer only */
+    char_T   *tail;                /* written by the consumer only */
+
+    volatile uint_T headCount;     /* bytes added, producer only   */
+    volatile uint_T tailCount;     /* bytes removed, consumer only */
 
     char_T   *newTail;
+    uint_T   newTailCount;
 
     struct {
         int_T count;
@@ -332,6 +642,51 @@ typedef struct CircularBuf_tag {
 } CircularBuf;
 
 
+/* Function ====================================================================
+ * Read a byte count of a circular buffer written by the other side.
+ */
+#ifndef EXTMODE_DISABLESIGNALMONITORING
+PRIVATE uint_T CircBufLoadCount(const volatile uint_T *count)
+{
+#if EXTMODE_CIRCBUF_ATOMICS
+    return __atomic_load_n(count, __ATOMIC_ACQUIRE);
+#else
+    uint_T value;
+
+#ifdef EXTMODE_PROTECT_CRITICAL_REGIONS
+    EXTMODE_DISABLE_INTERRUPTS;
+#endif
+    value = *count;
+#ifdef EXTMODE_PROTECT_CRITICAL_REGIONS
+    EXTMODE_ENABLE_INTERRUPTS;
+#endif
+    return value;
+#endif
+} /* end CircBufLoadCount */
+
+
+/* Function ====================================================================
+ * Publish a byte count of a circular buffer to the other side.  All buffer
+ * accesses made before the call are visible to the other side once it reads
+ * the new count.
+ */
+PRIVATE void CircBufStoreCount(volatile uint_T *count, uint_T value)
+{
+#if EXTMODE_CIRCBUF_ATOMICS
+    __atomic_store_n(count, value, __ATOMIC_RELEASE);
+#else
+#ifdef EXTMODE_PROTECT_CRITICAL_REGIONS
+    EXTMODE_DISABLE_INTERRUPTS;
+#endif
+    *count = value;
+#ifdef EXTMODE_PROTECT_CRITICAL_REGIONS
+    EXTMODE_ENABLE_INTERRUPTS;
+#endif
+#endif
+} /* end CircBufStoreCount */
+#endif /* ifndef EXTMODE_DISABLESIGNALMONITORING */
+
+
 /*==============================================================================
  * Trigger stuff.
  *============================================================================*/
@@ -885,7 +1240,6 @@ PRIVATE boolean_T UploadBufInit(CircularBuf *circBuf, int32_T size)
         error = EXT_ERROR; goto EXIT_POINT;
     }
 
-    circBuf->empty = true;
     if (size > 0) {
         assert(circBuf->buf == NULL);
         circBuf->buf = (char_T *)malloc(size);
@@ -900,7 +1254,11 @@ PRIVATE boolean_T UploadBufInit(CircularBuf *circBuf, int32_T size)
     circBuf->head = circBuf->buf;
     circBuf->tail = circBuf->buf;
 
-    circBuf->newTail = NULL;
+    circBuf->headCount = 0;
+    circBuf->tailCount = 0;
+
+    circBuf->newTail      = NULL;
+    circBuf->newTailCount = 0;
 
 EXIT_POINT:
     return(error);
@@ -980,8 +1338,9 @@ PUBLIC void UploadLogInfoReset(int32_T upInfoIdx)
 
     uploadInfo->circBufs = NULL;
 
-    uploadInfo->bufMemList.bufs = NULL;
-    uploadInfo->bufMemList.tids = NULL;
+    uploadInfo->bufMemList.bufs  = NULL;
+    uploadInfo->bufMemList.tids  = NULL;
+    uploadInfo->bufMemList.spans = NULL;
 
     /* Reset trigger info */
     UploadDestroyTrigger(upInfoIdx);
@@ -1032,6 +1391,7 @@ PUBLIC void UploadLogInfoTerm(int32_T upInfoIdx, int_T numSampTimes)
 
     free(uploadInfo->bufMemList.bufs);
     free(uploadInfo->bufMemList.tids);
+    free(uploadInfo->bufMemList.spans);
     
     /*
      * Free trigger info.
@@ -1172,6 +1532,13 @@ PUBLIC boolean_T UploadLogInfoInit(RTWExtModeInfo *ei,
         error = EXT_ERROR; goto EXIT_POINT;
     }
 
+    assert(uploadInfo->bufMemList.spans == NULL);
+    uploadInfo->bufMemList.spans =
+        (ExtHostPktSpan *)malloc(2*nActiveTids*sizeof(ExtHostPktSpan));
+    if (uploadInfo->bufMemList.spans == NULL) {
+        error = EXT_ERROR; goto EXIT_POINT;
+    }
+
 EXIT_POINT:
     if (error != EXT_NO_ERROR) {
         UploadLogInfoTerm(upInfoIdx, numSampTimes);
@@ -1318,8 +1685,11 @@ PUBLIC void UploadArmTrigger(int32_T upInfoIdx, int_T numSampTimes)
             circBuf->head = circBuf->buf;
             circBuf->tail = circBuf->buf;
 
-            circBuf->newTail = NULL;
-            circBuf->empty   = true;
+            circBuf->headCount = 0;
+            circBuf->tailCount = 0;
+
+            circBuf->newTail      = NULL;
+            circBuf->newTailCount = 0;
         }
     }
 
@@ -1421,28 +1791,9 @@ PUBLIC void UploadBufDataSent(const int_T tid, int32_T upInfoIdx)
 
     host_upstatus_is_uploading = true;
     
-    /* Move the tail forward. */
+    /* Move the tail forward and hand the space back to the model task. */
     circBuf->tail = circBuf->newTail;
-        
-#ifdef EXTMODE_PROTECT_CRITICAL_REGIONS
-    /* 
-     * disable interrupts around this critical region. We need to 
-     * guarantee that reading the head pointer is an atomic 
-     * operation.
-     */
-    EXTMODE_DISABLE_INTERRUPTS;
-#endif
-    
-    /* 
-     * Since we are moving the tail forward, we know that head == tail
-     * represents an empty buffer and not a full buffer.
-     */
-    circBuf->empty = (circBuf->tail == circBuf->head);
-    
-#ifdef EXTMODE_PROTECT_CRITICAL_REGIONS
-    /* re-enable interrupts */
-    EXTMODE_ENABLE_INTERRUPTS;
-#endif
+    CircBufStoreCount(&circBuf->tailCount, circBuf->newTailCount);
 
 } /* end UploadBufDataSent */
 #endif /* ifndef EXTMODE_DISABLESIGNALMONITORING */
@@ -1466,6 +1817,8 @@ PUBLIC void UploadBufDataSent(const int_T tid, int32_T upInfoIdx)
     if (nBytesPassedEnd >= 0) {                                    \
         (circBuf)->tail = (circBuf)->buf + nBytesPassedEnd;        \
     }                                                              \
+    CircBufStoreCount(&(circBuf)->tailCount,                       \
+                      (circBuf)->tailCount + (uint_T)nBytesInStep);\
 } /* end MOVE_TAIL_ONESTEP */
 
 
@@ -1493,60 +1846,28 @@ PUBLIC void UploadBufDataSent(const int_T tid, int32_T upInfoIdx)
  *       until the entire time point is successfully copied into the buffer.
  *
  *       This function modifies tmpHead to point at the next available 
- *       location.
- *
- *       It is possible for tmpHead to equal the tail upon entry to this
- *       function.  This does not necessarily mean that the buffer is
- *       empty (unwrapped).  It could also mean that the buffer is exactly
- *       full (this is considered as wrapped).
+ *       location and decrements nBytesFree, the number of bytes between
+ *       tmpHead and the tail, by the number of bytes assigned.
  */
 #ifndef EXTMODE_DISABLESIGNALMONITORING
 PRIVATE boolean_T UploadBufAssignMem(
     CircularBuf  *circBuf,
     int_T        nBytesToAdd,
-    char         **tmpHead,   /* in-out */
-    BufMem       *bufMem)     /* out */
+    char         **tmpHead,    /* in-out */
+    int_T        *nBytesFree,  /* in-out */
+    BufMem       *bufMem)      /* out */
 {
-    int_T       nBytesLeft;
     boolean_T   overFlow  = false;
     char        *end      = circBuf->buf + circBuf->bufSize; /* 1 passed end */
 
-    if ((*tmpHead > circBuf->tail) || circBuf->empty) {
-        /* buffer not wrapped */
-        nBytesLeft = (int_T)((end - *tmpHead) + (circBuf->tail - circBuf->buf));
-
-        if (nBytesLeft < nBytesToAdd) {
-            overFlow = true;
-            goto EXIT_POINT;
-        }
-
-        if ((*tmpHead + nBytesToAdd) < end) {
-            /* still not wrapped */
-            bufMem->nBytes1  = nBytesToAdd;
-            bufMem->section1 = *tmpHead;
-
-            bufMem->nBytes2  = 0;
-            bufMem->section2 = NULL;
-
-            *tmpHead += nBytesToAdd;
-        } else {
-            /* now we're wrapped */
-            bufMem->nBytes1  = (int_T)(end - *tmpHead);
-            bufMem->section1 = *tmpHead;
-
-            bufMem->nBytes2  = nBytesToAdd - bufMem->nBytes1;
-            bufMem->section2 = (bufMem->nBytes2 > 0) ? circBuf->buf : NULL;
-
-            *tmpHead = circBuf->buf + bufMem->nBytes2;
-        }  
-    } else {
-        /* wrapped */
-        nBytesLeft = (int_T)(circBuf->tail - *tmpHead);
-        if (nBytesLeft < nBytesToAdd) {
-            overFlow = true;
-            goto EXIT_POINT;
-        }
+    if (*nBytesFree < nBytesToAdd) {
+        overFlow = true;
+        goto EXIT_POINT;
+    }
+    *nBytesFree -= nBytesToAdd;
 
+    if ((*tmpHead + nBytesToAdd) < end) {
+        /* not wrapped */
         bufMem->nBytes1  = nBytesToAdd;
         bufMem->section1 = *tmpHead;
 
@@ -1554,6 +1875,15 @@ PRIVATE boolean_T UploadBufAssignMem(
         bufMem->section2 = NULL;
 
         *tmpHead += nBytesToAdd;
+    } else {
+        /* now we're wrapped */
+        bufMem->nBytes1  = (int_T)(end - *tmpHead);
+        bufMem->section1 = *tmpHead;
+
+        bufMem->nBytes2  = nBytesToAdd - bufMem->nBytes1;
+        bufMem->section2 = (bufMem->nBytes2 > 0) ? circBuf->buf : NULL;
+
+        *tmpHead = circBuf->buf + bufMem->nBytes2;
     }
     
 EXIT_POINT:
@@ -1711,6 +2041,8 @@ PUBLIC void UploadBufAddTimePoint(int_T tid, real_T taskTime,
         BufMem      bufMem;
         BufMem      pktStart;
         int_T       size;
+        int_T       nBytesFree;
+        int_T       nBytesAvail;
         char_T *tmpHead    = circBuf->head;
         const int_T PKT_TYPE_IDX = 0;
         const int_T NBYTES_IDX   = 1;
@@ -1727,6 +2059,11 @@ PUBLIC void UploadBufAddTimePoint(int_T tid, real_T taskTime,
             MOVE_TAIL_ONESTEP(circBuf, end);
             trigInfo->preTrig.count--;
         }
+
+        /* Space not yet released by the upload server is not available. */
+        nBytesAvail = circBuf->bufSize -
+            (int_T)(circBuf->headCount - CircBufLoadCount(&circBuf->tailCount));
+        nBytesFree  = nBytesAvail;
         
         /*
          * Save some space for the 5 integer values that make up the packet
@@ -1734,7 +2071,8 @@ PUBLIC void UploadBufAddTimePoint(int_T tid, real_T taskTime,
          * The values are filled in later.
          */
         size = 5*sizeof(int32_T);
-        overFlow = UploadBufAssignMem(circBuf, size, &tmpHead, &pktStart);
+        overFlow = UploadBufAssignMem(circBuf, size, &tmpHead, &nBytesFree,
+                                      &pktStart);
         if (overFlow) goto EXIT_POINT;
 
         /*
@@ -1748,7 +2086,8 @@ PUBLIC void UploadBufAddTimePoint(int_T tid, real_T taskTime,
         
         /* time */
         overFlow =
-            UploadBufAssignMem(circBuf, sizeof(real_T), &tmpHead, &bufMem);
+            UploadBufAssignMem(circBuf, sizeof(real_T), &tmpHead, &nBytesFree,
+                               &bufMem);
         if (overFlow) goto EXIT_POINT;
         intHdr[NBYTES_IDX] += sizeof(real_T);
         
@@ -1772,7 +2111,8 @@ PUBLIC void UploadBufAddTimePoint(int_T tid, real_T taskTime,
                     /* Add system index */
                     size = sizeof(int32_T);
                     overFlow =
-                        UploadBufAssignMem(circBuf, size, &tmpHead, &bufMem);
+                        UploadBufAssignMem(circBuf, size, &tmpHead,
+                                           &nBytesFree, &bufMem);
                     if (overFlow) goto EXIT_POINT;
                     intHdr[NBYTES_IDX] += size;
                     
@@ -1790,13 +2130,15 @@ PUBLIC void UploadBufAddTimePoint(int_T tid, real_T taskTime,
                             int32_T strNBytes = suStrlen(strPtr) + 1;
                             char *tmpStr;
                             
-                            overFlow = UploadBufAssignMem(circBuf, size, &tmpHead, &bufMem);
+                            overFlow = UploadBufAssignMem(circBuf, size, &tmpHead,
+                                                          &nBytesFree, &bufMem);
                             if (overFlow) goto EXIT_POINT;
                             intHdr[NBYTES_IDX] += size;
                             CIRCBUF_COPY_DATA(bufMem, &strNBytes);
 
                             /* Add character bytes */
-                            overFlow = UploadBufAssignMem(circBuf, strNBytes, &tmpHead, &bufMem);
+                            overFlow = UploadBufAssignMem(circBuf, strNBytes, &tmpHead,
+                                                          &nBytesFree, &bufMem);
                             if (overFlow) goto EXIT_POINT;
                             intHdr[NBYTES_IDX] += strNBytes;
                             
@@ -1809,7 +2151,8 @@ PUBLIC void UploadBufAddTimePoint(int_T tid, real_T taskTime,
                         {
                             /* Regular cases */
                             overFlow = UploadBufAssignMem(
-                                circBuf, sect->nBytes, &tmpHead, &bufMem);
+                                circBuf, sect->nBytes, &tmpHead, &nBytesFree,
+                                &bufMem);
                             if (overFlow) goto EXIT_POINT;
                             intHdr[NBYTES_IDX] += sect->nBytes;
                             
@@ -1835,10 +2178,12 @@ PUBLIC void UploadBufAddTimePoint(int_T tid, real_T taskTime,
         CIRCBUF_COPY_DATA(pktStart, intHdr);
 
         /*
-         * Time point successfully added to queue.
+         * Time point successfully added to queue.  Publish it to the upload
+         * server only after all of its bytes have been written.
          */
-        circBuf->head  = tmpHead;
-        circBuf->empty = false;
+        circBuf->head = tmpHead;
+        CircBufStoreCount(&circBuf->headCount,
+                          circBuf->headCount + (uint_T)(nBytesAvail - nBytesFree));
         
         if (preTrig) {
             trigInfo->preTrig.count++;
@@ -1968,59 +2313,66 @@ PRIVATE void SetExtBufListFields(ExtBufMemList *extBufList,
     BufMemList   *bufList    = &uploadInfo->bufMemList;
 
     bufList->nActiveBufs = 0;
+    bufList->nSpans      = 0;
 
     for (tid=0; tid<numSampTimes; tid++) {
         CircularBuf *circBuf = &uploadInfo->circBufs[tid];
 
-        if (!circBuf->empty) {
+        /* 
+         * Everything up to the published headCount has been completely
+         * written by the model task.
+         */
+        int_T nBytes = (int_T)(CircBufLoadCount(&circBuf->headCount) -
+                               circBuf->tailCount);
+
+        if (nBytes != 0) {
             BufMem  *bufMem;
-            char_T  *head;
             char_T  *tail   = circBuf->tail;
             int_T   size    = circBuf->bufSize;
 
-            
-#ifdef EXTMODE_PROTECT_CRITICAL_REGIONS
-            /* 
-             * disable interrupts around this critical region. We need to 
-             * guarantee that reading the head pointer is an atomic 
-             * operation.
-             */
-            EXTMODE_DISABLE_INTERRUPTS;
-#endif
-
-            head = circBuf->head;
-
-            
-#ifdef EXTMODE_PROTECT_CRITICAL_REGIONS
-            /* re-enable interrupts */
-            EXTMODE_ENABLE_INTERRUPTS;
-#endif
-
-            /* Validate that head/tail ptrs are within allocated range. */
-            assert((head >= circBuf->buf) && (tail >= circBuf->buf));
-            assert((head < circBuf->buf + circBuf->bufSize) &&
+            /* Validate that tail ptr and byte count are within range. */
+            assert((tail >= circBuf->buf) &&
                    (tail < circBuf->buf + circBuf->bufSize));
+            assert((nBytes > 0) && (nBytes <= size));
 
             bufMem = &bufList->bufs[bufList->nActiveBufs];
             bufList->tids[bufList->nActiveBufs] = tid;
             assert(bufList->nActiveBufs < bufList->maxBufs);
             bufList->nActiveBufs++;
 
-            bufMem->section1 = tail;
-            circBuf->newTail = head;
+            bufMem->section1      = tail;
+            circBuf->newTailCount = circBuf->tailCount + (uint_T)nBytes;
 
-            if (head > tail) {
+            if (nBytes < (int_T)(circBuf->buf + size - tail)) {
                 /* not wrapped - only one section required */
-                bufMem->nBytes1  = (int_T)(head - tail);
+                bufMem->nBytes1  = nBytes;
 
                 bufMem->nBytes2  = 0;
                 bufMem->section2 = NULL;
+
+                circBuf->newTail = tail + nBytes;
             } else {
                 /* wrapped - 2 sections required */
                 bufMem->nBytes1 = (int_T)(circBuf->buf + size - tail);
 
-                bufMem->nBytes2  = (int_T)(head - circBuf->buf);
+                bufMem->nBytes2  = nBytes - bufMem->nBytes1;
                 bufMem->section2 = circBuf->buf;
+
+                circBuf->newTail = circBuf->buf + bufMem->nBytes2;
+            }
+
+            /*
+             * Expose the sections in place so the transport can send them
+             * without copying.  The memory is not reused until
+             * UploadBufDataSent moves the tail.
+             */
+            bufList->spans[bufList->nSpans].data   = bufMem->section1;
+            bufList->spans[bufList->nSpans].nBytes = bufMem->nBytes1;
+            bufList->nSpans++;
+            if (bufMem->nBytes2 > 0) {
+                bufList->spans[bufList->nSpans].data   = bufMem->section2;
+                bufList->spans[bufList->nSpans].nBytes = bufMem->nBytes2;
+                bufList->nSpans++;
             }
         }
     }
@@ -2031,6 +2383,8 @@ PRIVATE void SetExtBufListFields(ExtBufMemList *extBufList,
     extBufList->nActiveBufs = bufList->nActiveBufs;
     extBufList->bufs        = (const BufMem *)bufList->bufs;
     extBufList->tids        = (const int_T *)bufList->tids;
+    extBufList->nSpans      = bufList->nSpans;
+    extBufList->spans       = (const ExtHostPktSpan *)bufList->spans;
 } /* end SetExtBufListFields */
 
 
@@ -2046,9 +2400,12 @@ PRIVATE void SetExtBufListFieldsForEmptyList(ExtBufMemList *extBufList,
     BufMemList   *bufList    = &uploadInfo->bufMemList;
 
     bufList->nActiveBufs = 0;
+    bufList->nSpans      = 0;
 
     extBufList->nActiveBufs = bufList->nActiveBufs;
     extBufList->bufs        = (const BufMem *)NULL;
+    extBufList->nSpans      = bufList->nSpans;
+    extBufList->spans       = (const ExtHostPktSpan *)NULL;
 } /* end SetExtBufListFieldsForEmptyList */
 
 
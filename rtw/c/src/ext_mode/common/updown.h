@@ -17,6 +17,17 @@ extern "C" {
 extern void      SetParam(RTWExtModeInfo  *ei,
                           const char      *pbuf);
 
+#ifdef EXTMODE_STAGED_SETPARAM
+extern boolean_T SetParamStage(RTWExtModeInfo *ei,
+                               const char     *pbuf);
+
+extern boolean_T SetParamCommit(void);
+
+extern void      SetParamApplyPending(void);
+
+extern void      SetParamTerm(void);
+#endif
+
 extern void      UploadLogInfoReset(int32_T upInfoIdx);
 
 extern void      UploadPrepareForFinalFlush(int32_T upInfoIdx);
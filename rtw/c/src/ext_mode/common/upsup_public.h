@@ -22,13 +22,17 @@ typedef struct BufMem_tag {
 /*
  * For each of nActiveBufs (buffers with data in them) we have a list of
  * the buffer memory (bufs) and a list of the tid's with which this buffer
- * is associated.
+ * is associated.  The same sections, in the same order, are also provided
+ * as a flat list of spans that can be handed directly to ExtSetHostPktV.
  */
 typedef struct ExtBufMemList_tag {
     int_T        nActiveBufs; /* num bufs with data to upload */
 
     const BufMem *bufs; /* sections of each buffer for uploading */
     const int_T  *tids; /* tid associated with each section      */
+
+    int_T                nSpans; /* num non-empty sections        */
+    const ExtHostPktSpan *spans; /* non-empty sections of all bufs */
 } ExtBufMemList; 
 
 typedef struct BdUploadInfo_tag BdUploadInfo;
@@ -355,6 +355,28 @@ PUBLIC boolean_T ExtSetHostPkt(
 } /* end ExtSetHostPkt */
 
 
+/* Function: ExtSetHostPktV ====================================================
+ * Abstract:
+ *  Sets (sends) a list of data spans on the comm line, in order, as one
+ *  contiguous stream of bytes.  The spans point directly into the upload
+ *  buffers and stay valid until this function returns.  The total number of
+ *  bytes set is returned via the 'nBytesSet' parameter.  EXT_NO_ERROR is
+ *  returned on success, EXT_ERROR is returned on failure.
+ *
+ * NOTES:
+ *  o it is always o.k. for this function to block if no room is available
+ *  o a transport without a native gather write may call ExtSetHostPkt once
+ *    per span
+ */
+PUBLIC boolean_T ExtSetHostPktV(
+    const ExtUserData    *UD,
+    const int            nSpans,
+    const ExtHostPktSpan *spans,
+    int                  *nBytesSet) /* out */
+{
+} /* end ExtSetHostPktV */
+
+
 /* Function: ExtModeSleep ======================================================
  * Abstract:
  *  Called by grt_main, ert_main, and grt_malloc_main to "pause" (hopefully in
@@ -102,26 +102,32 @@ PRIVATE boolean_T IsEscapeChar(char c)
  * Note: In the worst case where every char is an escape char, the
  *       destination buffer will be 2 times the size of the source buffer.
  */
-PRIVATE uint32_T Filter(char *dest, char *src, uint32_T bytes)
+PRIVATE uint32_T Filter(char *dest, const char *src, uint32_T bytes)
 {
-    uint32_T i;
-    uint32_T newSize = bytes;
-    char     *pDest  = dest;
-    char     *pSrc   = src;
-
-    for (i=0 ; i<bytes ; i++, pSrc++) {
-	if (IsEscapeChar(*pSrc)) {
-	    *pDest = escape_character;
-	    pDest++;
-	    *pDest = (char)((*pSrc) ^ mask_character);
-	    pDest++;
-	    newSize++;
-	} else {
-	    *pDest = *pSrc;
-	    pDest++;
-	}
+    const char *pSrc  = src;
+    const char *pEnd  = src + bytes;
+    char       *pDest = dest;
+
+    while (pSrc < pEnd) {
+        /* Copy the run of bytes up to the next escape char in one go. */
+        const char *pRun = pSrc;
+        while ((pSrc < pEnd) && !IsEscapeChar(*pSrc)) {
+            pSrc++;
+        }
+        if (pSrc != pRun) {
+            memcpy(pDest, pRun, (size_t)(pSrc - pRun));
+            pDest += pSrc - pRun;
+        }
+
+        if (pSrc < pEnd) {
+            *pDest = escape_character;
+            pDest++;
+            *pDest = (char)((*pSrc) ^ mask_character);
+            pDest++;
+            pSrc++;
+        }
     }
-    return newSize;
+    return (uint32_T)(pDest - dest);
 
 } /* end Filter */
 
@@ -200,6 +206,122 @@ PRIVATE uint32_T String2Num(char *source, boolean_T endianess)
 } /* end String2Num */
 
 
+/*
+ * Staging buffer for outgoing packets and chunk buffer for incoming bytes.
+ */
+#if EXT_SERIAL_TX_STAGE_SIZE < 2
+#error "EXT_SERIAL_TX_STAGE_SIZE must hold at least one escaped byte"
+#endif
+
+PRIVATE char     TxStage[EXT_SERIAL_TX_STAGE_SIZE];
+PRIVATE uint32_T TxStageCount = 0;
+PRIVATE char     RxChunk[EXT_SERIAL_RX_CHUNK_SIZE];
+
+
+/* Function: FlushTxStage ======================================================
+ * Abstract:
+ *  Sends the contents of the staging buffer on the comm line and empties it.
+ *
+ *  EXT_NO_ERROR is returned on success, EXT_ERROR on failure.
+ */
+PRIVATE boolean_T FlushTxStage(ExtSerialPort *portDev)
+{
+    boolean_T error = EXT_NO_ERROR;
+
+    if (TxStageCount > 0) {
+        error = ExtSerialPortSetData(portDev, TxStage, TxStageCount);
+        TxStageCount = 0;
+    }
+    return error;
+
+} /* end FlushTxStage */
+
+
+/* Function: StageTxData =======================================================
+ * Abstract:
+ *  Appends bytes to the staging buffer, escaping them first if doFilter is
+ *  true.  The staging buffer is flushed only when the next piece might not
+ *  fit, so a packet that fits after escaping is sent with a single call to
+ *  ExtSerialPortSetData.
+ *
+ *  EXT_NO_ERROR is returned on success, EXT_ERROR on failure.
+ */
+PRIVATE boolean_T StageTxData(ExtSerialPort *portDev,
+                              const char *src,
+                              uint32_T bytes,
+                              boolean_T doFilter)
+{
+    boolean_T error = EXT_NO_ERROR;
+
+    while (bytes > 0) {
+        uint32_T room = EXT_SERIAL_TX_STAGE_SIZE - TxStageCount;
+        uint32_T n    = doFilter ? room/2 : room;
+
+        if (n == 0) {
+            error = FlushTxStage(portDev);
+            if (error != EXT_NO_ERROR) goto EXIT_POINT;
+            continue;
+        }
+        if (n > bytes) n = bytes;
+
+        if (doFilter) {
+            TxStageCount += Filter(&TxStage[TxStageCount], src, n);
+        } else {
+            memcpy(&TxStage[TxStageCount], src, n);
+            TxStageCount += n;
+        }
+        src   += n;
+        bytes -= n;
+    }
+
+  EXIT_POINT:
+    return error;
+
+} /* end StageTxData */
+
+
+/* Function: RecvBytesWanted ===================================================
+ * Abstract:
+ *  Returns the number of bytes the current packet still needs if none of
+ *  them are escaped.  Escaping only adds bytes, so this many bytes can be
+ *  read in one call without reading into the next packet.
+ */
+PRIVATE uint32_T RecvBytesWanted(const ExtSerialPacket *pkt)
+{
+    uint32_T wanted;
+
+    switch (pkt->state) {
+      case ESP_InHead:
+        /* Exactly one head byte has been seen in this state. */
+        wanted = (HEAD_SIZE - 1) + PACKET_TYPE_SIZE + sizeof(pkt->size) +
+            TAIL_SIZE;
+        break;
+      case ESP_InType:
+        wanted = (PACKET_TYPE_SIZE - pkt->DataCount) + sizeof(pkt->size) +
+            TAIL_SIZE;
+        break;
+      case ESP_InSize:
+        wanted = (sizeof(pkt->size) - pkt->DataCount) + TAIL_SIZE;
+        break;
+      case ESP_InPayload:
+        wanted = (pkt->size - pkt->DataCount) + TAIL_SIZE;
+        break;
+      case ESP_InTail:
+        wanted = TAIL_SIZE - pkt->DataCount;
+        break;
+      case ESP_NoPacket:
+      default:
+        wanted = HEAD_SIZE + PACKET_TYPE_SIZE + sizeof(pkt->size) + TAIL_SIZE;
+        break;
+    }
+
+    if (wanted > EXT_SERIAL_RX_CHUNK_SIZE) wanted = EXT_SERIAL_RX_CHUNK_SIZE;
+    if (wanted == 0) wanted = 1;
+    return wanted;
+
+} /* end RecvBytesWanted */
+
+
 /* Function: SetExtSerialPacket ================================================
  * Abstract:
  *  Sets (sends) the contents of an ExtSerialPacket on the comm line.  This
@@ -210,11 +332,10 @@ PRIVATE uint32_T String2Num(char *source, boolean_T endianess)
  */
 PUBLIC boolean_T SetExtSerialPacket(ExtSerialPacket *pkt, ExtSerialPort *portDev)
 {
-    uint32_T  i;
-    uint32_T  newByteCnt   = 0; /* Num bytes after filtering. */
+    uint32_T  newByteCnt   = 0;
     boolean_T error        = EXT_NO_ERROR;
 
-    char Buffer[sizeof(uint32_T)*2]; /* Local buffer for converting escape chars. */
+    char Buffer[sizeof(uint32_T)]; /* Local buffer for the size field. */
 
     /* If not connected, return immediately. */
     if (!portDev->fConnected) return false;
@@ -229,33 +350,34 @@ PUBLIC boolean_T SetExtSerialPacket(ExtSerialPacket *pkt, ExtSerialPort *portDev
     pkt->DataCount    = 0;
     pkt->inQuote      = false;
 
-    /* Send the packet header. */
-    error = ExtSerialPortSetData(portDev, pkt->head, HEAD_SIZE);
+    TxStageCount = 0;
+
+    /* Stage the packet header. */
+    error = StageTxData(portDev, pkt->head, HEAD_SIZE, false);
     if (error != EXT_NO_ERROR) goto EXIT_POINT;
 
-    /* Send the packet type. */
-    newByteCnt = Filter(Buffer, &(pkt->PacketType), PACKET_TYPE_SIZE);
-    error = ExtSerialPortSetData(portDev, Buffer, newByteCnt);
+    /* Stage the packet type. */
+    error = StageTxData(portDev, &(pkt->PacketType), PACKET_TYPE_SIZE, true);
     if (error != EXT_NO_ERROR) goto EXIT_POINT;
 
-    /* Send the size of the packet buffer. */
-    newByteCnt = Num2String(Buffer, pkt->size, true, portDev->isLittleEndian);
-    error = ExtSerialPortSetData(portDev, Buffer, newByteCnt);
+    /* Stage the size of the packet buffer. */
+    newByteCnt = Num2String(Buffer, pkt->size, false, portDev->isLittleEndian);
+    error = StageTxData(portDev, Buffer, newByteCnt, true);
     if (error != EXT_NO_ERROR) goto EXIT_POINT;
 
-    /* Send the variable-sized packet buffer data. */
-    for (i=0; i<pkt->size; i++)
-    {
-        newByteCnt = Filter(Buffer, &(pkt->Buffer[i]), 1);
-        error = ExtSerialPortSetData(portDev, Buffer, newByteCnt);
-        if (error != EXT_NO_ERROR) goto EXIT_POINT;
-    }
+    /* Stage the variable-sized packet buffer data. */
+    error = StageTxData(portDev, pkt->Buffer, pkt->size, true);
+    if (error != EXT_NO_ERROR) goto EXIT_POINT;
 
-    /* Send the packet tail. */
-    error = ExtSerialPortSetData(portDev, pkt->tail, TAIL_SIZE);
+    /* Stage the packet tail. */
+    error = StageTxData(portDev, pkt->tail, TAIL_SIZE, false);
     if (error != EXT_NO_ERROR) goto EXIT_POINT;
+
+    /* Send the packet. */
+    error = FlushTxStage(portDev);
  
   EXIT_POINT:
+    TxStageCount = 0;
     return error;
 
 } /* end SetExtSerialPacket */
@@ -293,192 +415,227 @@ PUBLIC boolean_T GetExtSerialPacket(ExtSerialPacket *pkt, ExtSerialPort *portDev
     pkt->inQuote      = false;
 
     for(;;) {
-        /* Get a character from input stream. */
-        error = ExtSerialPortGetData(portDev, &char1, 1, &numCharRecvd);    
-                
+        uint32_T idx;
+        uint32_T bytesWanted = RecvBytesWanted(pkt);
+
+        /*
+         * Get as many characters from the input stream as the packet is
+         * known to still contain.
+         */
+        error = ExtSerialPortGetData(portDev, RxChunk, bytesWanted,
+                                     &numCharRecvd);
         if (error != EXT_NO_ERROR) goto EXIT_POINT;
 
-        if (numCharRecvd != 1) {
+        if (numCharRecvd != bytesWanted) {
             pkt->state  = ESP_NoPacket;
             pkt->cursor = 0;
             error = EXT_ERROR;
             goto EXIT_POINT;
         }
 
-        /* Handle quoting and filtering (does not deal with xon/xoff issues). */
-        switch (pkt->state) {
-          case ESP_InType:
-          case ESP_InSize:
-          case ESP_InPayload:
-            /* Handle quoted characters in payload. */
-            if (pkt->inQuote) {
-                pkt->inQuote = false;
-                char1 ^= mask_character;
-            } else {
-                /*
-                 * No characters requiring escaping should be in the input
-                 * stream, except for control purposes.
-                 */
-                switch (char1) {
-                  case escape_character:
-                    pkt->inQuote = true;
-                    /* Need to go get next character at this point. */
-                    continue;
-                    break;
+        for (idx = 0; idx < numCharRecvd; idx++) {
+            char1 = RxChunk[idx];
+
+            /*
+             * Fast path: copy the run of unescaped payload chars straight
+             * into the packet buffer.
+             */
+            if ((pkt->state == ESP_InPayload) && !pkt->inQuote &&
+                !IsEscapeChar(char1)) {
+                uint32_T runEnd = idx + (pkt->size - pkt->DataCount);
+                uint32_T run    = idx;
+
+                if (runEnd > numCharRecvd) runEnd = numCharRecvd;
+                while ((run < runEnd) && !IsEscapeChar(RxChunk[run])) {
+                    run++;
+                }
+                memcpy(pkt->cursor, &RxChunk[idx], run - idx);
+                pkt->cursor    += run - idx;
+                pkt->DataCount += run - idx;
+                if (pkt->DataCount == pkt->size) {
+                    pkt->state = ESP_InTail;
+                    pkt->cursor = (char *)&pkt->tail;
+                    pkt->DataCount = 0;
+                }
+                idx = run - 1;
+                continue;
+            }
+
+            /* Handle quoting and filtering (does not deal with xon/xoff issues). */
+            switch (pkt->state) {
+              case ESP_InType:
+              case ESP_InSize:
+              case ESP_InPayload:
+                /* Handle quoted characters in payload. */
+                if (pkt->inQuote) {
+                    pkt->inQuote = false;
+                    char1 ^= mask_character;
+                } else {
                     /*
-                     * other special characters should only exist
-                     * in payload when quoted.
+                     * No characters requiring escaping should be in the input
+                     * stream, except for control purposes.
                      */
-                  case packet_head:
+                    switch (char1) {
+                      case escape_character:
+                        pkt->inQuote = true;
+                        /* Need to go get next character at this point. */
+                        continue;
+                        break;
+                        /*
+                         * other special characters should only exist
+                         * in payload when quoted.
+                         */
+                      case packet_head:
+                        /*
+                         * Error - start handling the packet this header
+                         * goes with.
+                         */
+                        pkt->cursor = (char *)&pkt->head;
+                        *pkt->cursor++ = char1;
+                        pkt->DataCount++;
+                        pkt->state = ESP_InHead;
+                        continue;
+                      case packet_tail:
+                        /* Error - reset packet handling. */
+                        pkt->cursor = 0;
+                        pkt->state  = ESP_NoPacket;
+                        PacketError   = false;
+                        break;
+                      default:
+                        break;
+                    }
+                }
+                break;
+                /* No quoting in non-payload portions. */
+              case ESP_NoPacket:
+              case ESP_InHead:
+              case ESP_InTail:
+              case ESP_Complete:
+              default:
+                break;
+            }
+
+            switch (pkt->state) {
+              case ESP_NoPacket:
+                if (char1 == packet_head) {
                     /*
-                     * Error - start handling the packet this header
-                     * goes with.
+                     * When a byte matches a packet header tag byte,
+                     * save it and change state.
                      */
                     pkt->cursor = (char *)&pkt->head;
                     *pkt->cursor++ = char1;
                     pkt->DataCount++;
                     pkt->state = ESP_InHead;
-                    continue;
-                  case packet_tail:
-                    /* Error - reset packet handling. */
-                    pkt->cursor = 0;
-                    pkt->state  = ESP_NoPacket;
-                    PacketError   = false;
-                    break;
-                  default:
-                    break;
-                }
-            }
-            break;
-            /* No quoting in non-payload portions. */
-          case ESP_NoPacket:
-          case ESP_InHead:
-          case ESP_InTail:
-          case ESP_Complete:
-          default:
-            break;
-        }
-
-        switch (pkt->state) {
-          case ESP_NoPacket:
-            if (char1 == packet_head) {
-                /*
-                 * When a byte matches a packet header tag byte,
-                 * save it and change state.
-                 */
-                pkt->cursor = (char *)&pkt->head;
-                *pkt->cursor++ = char1;
-                pkt->DataCount++;
-                pkt->state = ESP_InHead;
-            }		    
-            break;
-          case ESP_InHead:
-            if (char1 == packet_head) {
-                /*
-                 * In this state, the only acceptable input is a packet header
-                 * tag byte which will cause packet processing to progress to
-                 * the next state.
-                 */
-                *pkt->cursor++ = char1;
-                pkt->DataCount = 0;
-                pkt->state = ESP_InType;
-                pkt->cursor = (char *)&pkt->PacketType;
-            } else {
-                PacketError = true; 
-            }
-            break;
-          case ESP_InType:
-            if (pkt->DataCount < sizeof(pkt->PacketType)) {
-                /*
-                 * In this state, the byte count determines where this
-                 * state stands.
-                 */
-                *pkt->cursor++ = char1;
-                pkt->DataCount++;
-                if (pkt->DataCount == sizeof(pkt->PacketType)) {
-                    pkt->state = ESP_InSize;
-                    pkt->cursor = (char *)&pkt->size;
+                }		    
+                break;
+              case ESP_InHead:
+                if (char1 == packet_head) {
+                    /*
+                     * In this state, the only acceptable input is a packet header
+                     * tag byte which will cause packet processing to progress to
+                     * the next state.
+                     */
+                    *pkt->cursor++ = char1;
                     pkt->DataCount = 0;
+                    pkt->state = ESP_InType;
+                    pkt->cursor = (char *)&pkt->PacketType;
+                } else {
+                    PacketError = true; 
                 }
-            } else {
-                PacketError = true; 
-            }
-            break;
-          case ESP_InSize:
-            if (pkt->DataCount < sizeof(pkt->size)) {
-                /*
-                 * In this state, the byte count determines where this
-                 * state stands.
-                 */
-                *pkt->cursor++ = char1;
-                pkt->DataCount++;
-                if (pkt->DataCount == sizeof(pkt->size)) {
-                    pkt->size = String2Num((char *)&pkt->size, portDev->isLittleEndian);
-                    pkt->DataCount = 0;
-                    if (pkt->size != 0) {
-			pkt->state = ESP_InPayload;
-                        pkt->cursor = (char *)pkt->Buffer;
-                    } else {
-			pkt->state = ESP_InTail;
-			pkt->cursor = (char *)&pkt->tail;
+                break;
+              case ESP_InType:
+                if (pkt->DataCount < sizeof(pkt->PacketType)) {
+                    /*
+                     * In this state, the byte count determines where this
+                     * state stands.
+                     */
+                    *pkt->cursor++ = char1;
+                    pkt->DataCount++;
+                    if (pkt->DataCount == sizeof(pkt->PacketType)) {
+                        pkt->state = ESP_InSize;
+                        pkt->cursor = (char *)&pkt->size;
+                        pkt->DataCount = 0;
                     }
+                } else {
+                    PacketError = true; 
                 }
-            } else {
-                PacketError = true; 
-            }
-            break;
-          case ESP_InPayload:
-            if (pkt->DataCount < pkt->size) {
-                /*
-                 * In this state, the byte count determines where this
-                 * state stands.
-                 */
-                *pkt->cursor++ = char1;
-                pkt->DataCount++;
-                if (pkt->DataCount == pkt->size) {
-                    pkt->state = ESP_InTail;
-                    pkt->cursor = (char *)&pkt->tail;
-                    pkt->DataCount = 0;
+                break;
+              case ESP_InSize:
+                if (pkt->DataCount < sizeof(pkt->size)) {
+                    /*
+                     * In this state, the byte count determines where this
+                     * state stands.
+                     */
+                    *pkt->cursor++ = char1;
+                    pkt->DataCount++;
+                    if (pkt->DataCount == sizeof(pkt->size)) {
+                        pkt->size = String2Num((char *)&pkt->size, portDev->isLittleEndian);
+                        pkt->DataCount = 0;
+                        if (pkt->size != 0) {
+    			pkt->state = ESP_InPayload;
+                            pkt->cursor = (char *)pkt->Buffer;
+                        } else {
+    			pkt->state = ESP_InTail;
+    			pkt->cursor = (char *)&pkt->tail;
+                        }
+                    }
+                } else {
+                    PacketError = true; 
                 }
-            } else {
-                PacketError = true; 
-            }
-            break;
-          case ESP_InTail:
-            if (pkt->DataCount < sizeof(pkt->tail)) {
-                if (char1 == packet_tail) {
+                break;
+              case ESP_InPayload:
+                if (pkt->DataCount < pkt->size) {
                     /*
-                     * In this state, the only acceptable input is a packet
-                     * tail tag byte.
+                     * In this state, the byte count determines where this
+                     * state stands.
                      */
                     *pkt->cursor++ = char1;
                     pkt->DataCount++;
-                    if (pkt->DataCount == sizeof(pkt->tail)) {
-                        pkt->state = ESP_Complete;
-                        pkt->cursor = NULL;
+                    if (pkt->DataCount == pkt->size) {
+                        pkt->state = ESP_InTail;
+                        pkt->cursor = (char *)&pkt->tail;
                         pkt->DataCount = 0;
-                        if (pkt->state != ESP_Complete) error = EXT_ERROR;
-                        goto EXIT_POINT;
                     }
                 } else {
                     PacketError = true; 
                 }
-            } else {
-                PacketError = true; 
+                break;
+              case ESP_InTail:
+                if (pkt->DataCount < sizeof(pkt->tail)) {
+                    if (char1 == packet_tail) {
+                        /*
+                         * In this state, the only acceptable input is a packet
+                         * tail tag byte.
+                         */
+                        *pkt->cursor++ = char1;
+                        pkt->DataCount++;
+                        if (pkt->DataCount == sizeof(pkt->tail)) {
+                            pkt->state = ESP_Complete;
+                            pkt->cursor = NULL;
+                            pkt->DataCount = 0;
+                            if (pkt->state != ESP_Complete) error = EXT_ERROR;
+                            goto EXIT_POINT;
+                        }
+                    } else {
+                        PacketError = true; 
+                    }
+                } else {
+                    PacketError = true; 
+                }
+                break;
+              case ESP_Complete:
+                break;
+              default:
+                break;
             }
-            break;
-          case ESP_Complete:
-            break;
-          default:
-            break;
-        }
 
-        if (PacketError) {
-            pkt->cursor = 0;
-            pkt->state  = ESP_NoPacket;            
-            error = EXT_ERROR;
-            goto EXIT_POINT;
-        }
+            if (PacketError) {
+                pkt->cursor = 0;
+                pkt->state  = ESP_NoPacket;            
+                error = EXT_ERROR;
+                goto EXIT_POINT;
+            }
+        } /* end-of-chunk-loop */
     } /* end-of-for-loop */
 
   EXIT_POINT:
@@ -40,6 +40,22 @@
 /* An ACK packet is a normal packet but with 0 bytes for payload */
 #define MAX_ACK_PACKET_SIZE   MAX_NON_PAYLOAD_SIZE
 
+/* SetExtSerialPacket escapes a whole packet into a staging buffer of
+ * EXT_SERIAL_TX_STAGE_SIZE bytes and sends it with a single call to
+ * ExtSerialPortSetData.  Packets that do not fit after escaping are sent in
+ * stage-sized pieces.  GetExtSerialPacket reads at most
+ * EXT_SERIAL_RX_CHUNK_SIZE bytes per call to ExtSerialPortGetData.  Both
+ * buffers are static, matching the single connection supported by
+ * ext_serial_utils.c.
+ */
+#ifndef EXT_SERIAL_TX_STAGE_SIZE
+#define EXT_SERIAL_TX_STAGE_SIZE 128
+#endif
+
+#ifndef EXT_SERIAL_RX_CHUNK_SIZE
+#define EXT_SERIAL_RX_CHUNK_SIZE 64
+#endif
+
 /* Conform to HDLC Framing standard */
 #define packet_head      ((char)0x7e)
 #define packet_tail      ((char)0x03)
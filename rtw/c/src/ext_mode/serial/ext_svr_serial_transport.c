@@ -360,6 +360,40 @@ boolean_T ExtSetHostPkt(
 } /* end ExtSetHostPkt */
 
 
+/* Function: ExtSetHostPktV ====================================================
+ * Abstract:
+ *  Sets (sends) a list of data spans on the comm line, in order.  Each span
+ *  is sent as one or more serial packets.  The total number of bytes set is
+ *  returned via the 'nBytesSet' parameter.  EXT_NO_ERROR is returned on
+ *  success, EXT_ERROR is returned on failure.
+ */
+boolean_T ExtSetHostPktV(
+    const ExtUserData    *UD,
+    const int            nSpans,
+    const ExtHostPktSpan *spans,
+    int                  *nBytesSet) /* out */
+{
+    int       i;
+    boolean_T error = EXT_NO_ERROR;
+
+    *nBytesSet = 0;
+    for (i = 0; i < nSpans; i++) {
+        if (spans[i].nBytes == 0) continue;
+
+        error = ExtSetPktWithACK(UD->portDev,
+                                 spans[i].data,
+                                 spans[i].nBytes,
+                                 EXTMODE_PACKET);
+        if (error != EXT_NO_ERROR) goto EXIT_POINT;
+
+        *nBytesSet += spans[i].nBytes;
+    }
+
+  EXIT_POINT:
+    return(error);
+} /* end ExtSetHostPktV */
+
+
 /* Function: ExtModeSleep ======================================================
  * Abstract:
  *  Called by grt_main, ert_main, and grt_malloc_main to "pause" (hopefully in
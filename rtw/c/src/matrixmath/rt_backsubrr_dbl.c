@@ -9,6 +9,7 @@
  *
  */
 
+#include <string.h>   /* needed for memcpy */
 #include "rt_matrixlib.h"
 
 /* Function: rt_BackwardSubstitutionRR_Dbl =====================================
@@ -29,6 +30,25 @@ void rt_BackwardSubstitutionRR_Dbl(real_T          *pU,
                                    boolean_T        unit_upper)
 {
   int_T i,k;
+
+#if RT_MATRIXLIB_USE_LAPACK
+  if (rt_MatrixLibUseLapack(N)) {
+    /* pU and pb address the last elements of U and b */
+    const real_T *U = pU - (N*N - 1);
+    const real_T *b = pb - (N*P - 1);
+    const int32_T nn = (int32_T)N;
+    const int32_T pp = (int32_T)P;
+    const real_T one = 1.0;
+
+    if (x != b) {
+      (void)memcpy(x, b, N*P*sizeof(real_T));
+    }
+    RT_LAPACK_FCN(dtrsm)("L", "U", "N", unit_upper ? "U" : "N",
+                         &nn, &pp, &one, U, &nn, x, &nn);
+    return;
+  }
+#endif
+
   for(k=P; k>0; k--) {
     real_T *pUcol = pU;
     for(i=0; i<N; i++) {
@@ -9,6 +9,7 @@
  *
  */
 
+#include <string.h>   /* needed for memcpy */
 #include "rt_matrixlib.h"
 
 /* Function: rt_BackwardSubstitutionRR_Sgl =====================================
@@ -29,6 +30,25 @@ void rt_BackwardSubstitutionRR_Sgl(real32_T          *pU,
                                    boolean_T          unit_upper)
 {
   int_T i,k;
+
+#if RT_MATRIXLIB_USE_LAPACK
+  if (rt_MatrixLibUseLapack(N)) {
+    /* pU and pb address the last elements of U and b */
+    const real32_T *U = pU - (N*N - 1);
+    const real32_T *b = pb - (N*P - 1);
+    const int32_T nn = (int32_T)N;
+    const int32_T pp = (int32_T)P;
+    const real32_T one = 1.0F;
+
+    if (x != b) {
+      (void)memcpy(x, b, N*P*sizeof(real32_T));
+    }
+    RT_LAPACK_FCN(strsm)("L", "U", "N", unit_upper ? "U" : "N",
+                         &nn, &pp, &one, U, &nn, x, &nn);
+    return;
+  }
+#endif
+
   for(k=P; k>0; k--) {
     real32_T *pUcol = pU;
     for(i=0; i<N; i++) {
@@ -31,6 +31,25 @@ void rt_ForwardSubstitutionCC_Sgl(creal32_T       *pL,
                                   boolean_T        unit_lower)
 {
   int_T i, k;
+
+#if RT_MATRIXLIB_USE_LAPACK
+  if (rt_MatrixLibUseLapack(N)) {
+    const int32_T nn = (int32_T)N;
+    const int32_T pp = (int32_T)P;
+    const creal32_T one = {1.0F, 0.0F};
+
+    /* x = b(piv,:), then x = L\x in place */
+    for(k=0; k<P; k++) {
+      for(i=0; i<N; i++) {
+        x[i + k*N] = pb[piv[i] + k*N];
+      }
+    }
+    RT_LAPACK_FCN(ctrsm)("L", "L", "N", unit_lower ? "U" : "N",
+                         &nn, &pp, &one, pL, &nn, x, &nn);
+    return;
+  }
+#endif
+
   for (k=0; k<P; k++) {
     creal32_T *pLcol = pL;
     for(i=0; i<N; i++) {
@@ -30,6 +30,25 @@ void rt_ForwardSubstitutionRR_Sgl(real32_T       *pL,
 {
   /* Real inputs: */
   int_T i, k;
+
+#if RT_MATRIXLIB_USE_LAPACK
+  if (rt_MatrixLibUseLapack(N)) {
+    const int32_T nn = (int32_T)N;
+    const int32_T pp = (int32_T)P;
+    const real32_T one = 1.0F;
+
+    /* x = b(piv,:), then x = L\x in place */
+    for(k=0; k<P; k++) {
+      for(i=0; i<N; i++) {
+        x[i + k*N] = pb[piv[i] + k*N];
+      }
+    }
+    RT_LAPACK_FCN(strsm)("L", "L", "N", unit_lower ? "U" : "N",
+                         &nn, &pp, &one, pL, &nn, x, &nn);
+    return;
+  }
+#endif
+
   for(k=0; k<P; k++) {
     real32_T *pLcol = pL;
     for(i=0; i<N; i++) {
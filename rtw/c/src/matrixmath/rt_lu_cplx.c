@@ -21,6 +21,16 @@ void rt_lu_cplx(creal_T *A,     /* in and out                         */
 {
   int_T k;
 
+#if RT_MATRIXLIB_USE_LAPACK
+  if (rt_MatrixLibUseLapack(n)) {
+    const int32_T nn = (int32_T)n;
+    int32_T info;
+    RT_LAPACK_FCN(zgetrf)(&nn, &nn, A, &nn, piv, &info);
+    rt_LapackPivotsToPermutation(piv, n);
+    return;
+  }
+#endif
+
   /* initialize row-pivot indices: */
   for (k = 0; k < n; k++) {
     piv[k] = k;
@@ -20,6 +20,16 @@ void rt_lu_real_sgl(real32_T      *A,    /* in and out                         *
 {
   int_T k;
 
+#if RT_MATRIXLIB_USE_LAPACK
+  if (rt_MatrixLibUseLapack(n)) {
+    const int32_T nn = (int32_T)n;
+    int32_T info;
+    RT_LAPACK_FCN(sgetrf)(&nn, &nn, A, &nn, piv, &info);
+    rt_LapackPivotsToPermutation(piv, n);
+    return;
+  }
+#endif
+
   /* initialize row-pivot indices: */
   for (k = 0; k < n; k++) {
     piv[k] = k;
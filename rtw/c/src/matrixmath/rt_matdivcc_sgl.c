@@ -31,6 +31,22 @@ void rt_MatDivCC_Sgl(creal32_T       *Out,
   const boolean_T unit_upper = false;
   const boolean_T unit_lower = true;
 
+#if RT_MATRIXLIB_USE_LAPACK
+  if (rt_MatrixLibUseLapack(N)) {
+    const int32_T nn = (int32_T)N;
+    const int32_T pp = (int32_T)P;
+    int32_T info;
+
+    (void)memcpy(lu, In1, N2*sizeof(real32_T)*2);
+    if (Out != In2) {
+      (void)memcpy(Out, In2, NP*sizeof(real32_T)*2);
+    }
+    RT_LAPACK_FCN(cgetrf)(&nn, &nn, lu, &nn, piv, &info);
+    RT_LAPACK_FCN(cgetrs)("N", &nn, &pp, lu, &nn, piv, Out, &nn, &info);
+    return;
+  }
+#endif
+
   (void)memcpy(lu, In1, N2*sizeof(real32_T)*2);
 
   rt_lu_cplx_sgl(lu, N, piv);
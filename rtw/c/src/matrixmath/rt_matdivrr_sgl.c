@@ -41,6 +41,22 @@ void rt_MatDivRR_Sgl(real32_T       *Out,
   const boolean_T unit_upper = false;
   const boolean_T unit_lower = true;
 
+#if RT_MATRIXLIB_USE_LAPACK
+  if (rt_MatrixLibUseLapack(N)) {
+    const int32_T nn = (int32_T)N;
+    const int32_T pp = (int32_T)P;
+    int32_T info;
+
+    (void)memcpy(lu, In1, N2*sizeof(real32_T));
+    if (Out != In2) {
+      (void)memcpy(Out, In2, NP*sizeof(real32_T));
+    }
+    RT_LAPACK_FCN(sgetrf)(&nn, &nn, lu, &nn, piv, &info);
+    RT_LAPACK_FCN(sgetrs)("N", &nn, &pp, lu, &nn, piv, Out, &nn, &info);
+    return;
+  }
+#endif
+
   (void)memcpy(lu, In1, N2*sizeof(real32_T));
 
   rt_lu_real_sgl(lu, N, piv);
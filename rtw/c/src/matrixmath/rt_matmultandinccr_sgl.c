@@ -25,6 +25,10 @@ void rt_MatMultAndIncCR_Sgl(creal32_T       *y,
                             const int_T       dims[3])
 {
   int_T k;
+  if (rt_MatMultUseBlocked(dims)) {
+    rt_MatMultBlockedCR_Sgl(y, A, B, dims, (boolean_T)1);
+    return;
+  }
   for(k=dims[2]; k-- > 0; ) {
     const creal32_T *A1 = A;
     int_T i;
@@ -23,6 +23,10 @@ void rt_MatMultAndIncRR_Sgl(real32_T       *y,
                             const int_T      dims[3])
 {
   int_T k;
+  if (rt_MatMultUseBlocked(dims)) {
+    rt_MatMultBlockedRR_Sgl(y, A, B, dims, (boolean_T)1);
+    return;
+  }
   for(k=dims[2]; k-- > 0; ) {
     const real32_T *A1 = A;
     int_T i;
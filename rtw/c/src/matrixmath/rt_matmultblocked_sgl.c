@@ -0,0 +1,481 @@
+/* Copyright 2020 The MathWorks, Inc.
+ *
+ * File: rt_matmultblocked_sgl.c
+ *
+ * Abstract:
+ *      Simulink Coder support routines for blocked matrix multiplication
+ *      of single precision float operands.  Used by rt_MatMult*_Sgl and
+ *      rt_MatMultAndInc*_Sgl when the product is at least
+ *      RT_MATMULT_BLOCKED_MIN multiply-adds.
+ *
+ *      Real products traverse the inner dimension in panels of
+ *      RT_MATMULT_KC columns of A (rows of B).  Within a panel, blocks of
+ *      RT_MATMULT_MC rows of A are multiplied with all the columns of B, so
+ *      the RT_MATMULT_MC x RT_MATMULT_KC block of A stays in cache while it
+ *      is reused, and each column tile of B is only RT_MATMULT_KC long.  y
+ *      is computed in tiles of RT_MM_MR rows by RT_MM_NR columns that are
+ *      held in registers for the length of a panel; the next panel
+ *      continues from the partial sums stored in y, so each element of
+ *      y = A*B is accumulated in the same order as the reference loops.
+ *      For y += A*B with more than one panel, the partial sums are added to
+ *      y before the product is complete, which may differ from the
+ *      reference loops in the last bit.  The AVX-512 tiles are 32 rows, so
+ *      an RT_MATMULT_MC that is not a multiple of 32 leaves part of each
+ *      block to the AVX2 kernel.  Complex products are computed in register
+ *      tiles over the whole inner dimension.
+ *
+ *      On x86 with GCC compatible compilers, real products use AVX-512 or
+ *      AVX2 kernels selected at run time from the capabilities of the CPU.
+ *      These use fused multiply-adds and may differ from the reference
+ *      loops in the last bit.  The portable kernels give the same results
+ *      as the reference loops for finite data.  Define
+ *      RT_MATMULT_REFERENCE=1 to always use the reference loops.
+ *
+ */
+
+#include "rt_matrixlib.h"
+
+#if !defined(RT_MATMULT_REFERENCE) || RT_MATMULT_REFERENCE == 0
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    !defined(RT_MATMULT_NO_SIMD)
+#define RT_MM_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define RT_MM_X86_SIMD 0
+#endif
+
+#define RT_MM_MR 4                          /* rows of a portable tile    */
+#define RT_MM_NR 4                          /* columns of every tile      */
+
+/* Inner dimension of a panel, and rows of A multiplied per panel */
+#ifndef RT_MATMULT_KC
+#define RT_MATMULT_KC 256
+#endif
+#ifndef RT_MATMULT_MC
+#define RT_MATMULT_MC 128
+#endif
+
+#if RT_MATMULT_KC < 1
+#error "RT_MATMULT_KC must be positive"
+#endif
+#if RT_MATMULT_MC < 16 || RT_MATMULT_MC % 16 != 0
+#error "RT_MATMULT_MC must be a positive multiple of 16"
+#endif
+
+/* What a kernel does with the tiles of y */
+#define RT_MM_STORE    0                    /* y  = A*B                   */
+#define RT_MM_ADD      1                    /* y += A*B                   */
+#define RT_MM_CONTINUE 2                    /* continue the sums in y     */
+
+typedef void (*rt_MatMultKernelRR_Sgl)(real32_T       *y,
+                                       const real32_T *A,
+                                       const real32_T *B,
+                                       int_T        nRows,
+                                       int_T        nInner,
+                                       const int_T  dims[3],
+                                       int_T        mode);
+
+/*
+ * Function: rt_MatMultTileRR_Sgl
+ * Abstract:
+ *      Portable kernel.  Compute nRows rows of y starting at the given
+ *      pointers over nInner columns of A; the leading dimensions of y and A
+ *      are dims[0], of B dims[1].
+ */
+static void rt_MatMultTileRR_Sgl(real32_T       *y,
+                                 const real32_T *A,
+                                 const real32_T *B,
+                                 int_T        nRows,
+                                 int_T        nInner,
+                                 const int_T  dims[3],
+                                 int_T        mode)
+{
+  const int_T ld  = dims[0];
+  const int_T ldB = dims[1];
+  const int_T p   = dims[2];
+  int_T i0;
+
+  for (i0 = 0; i0 < nRows; i0 += RT_MM_MR) {
+    const int_T mr = (nRows - i0 < RT_MM_MR) ? nRows - i0 : RT_MM_MR;
+    int_T k0;
+
+    for (k0 = 0; k0 < p; k0 += RT_MM_NR) {
+      const int_T nr = (p - k0 < RT_MM_NR) ? p - k0 : RT_MM_NR;
+      real32_T acc[RT_MM_NR][RT_MM_MR];
+      int_T r, c, j;
+
+      for (c = 0; c < RT_MM_NR; c++) {
+        for (r = 0; r < RT_MM_MR; r++) {
+          acc[c][r] = 0.0F;
+        }
+      }
+      if (mode == RT_MM_CONTINUE) {
+        for (c = 0; c < nr; c++) {
+          const real32_T *yc = y + i0 + (k0+c)*ld;
+          for (r = 0; r < mr; r++) {
+            acc[c][r] = yc[r];
+          }
+        }
+      }
+
+      if (mr == RT_MM_MR && nr == RT_MM_NR) {
+        for (j = 0; j < nInner; j++) {
+          const real32_T *a = A + i0 + j*ld;
+          const real32_T *b = B + j + k0*ldB;
+          for (c = 0; c < RT_MM_NR; c++) {
+            const real32_T bc = b[c*ldB];
+            for (r = 0; r < RT_MM_MR; r++) {
+              acc[c][r] += a[r] * bc;
+            }
+          }
+        }
+      } else {
+        for (j = 0; j < nInner; j++) {
+          const real32_T *a = A + i0 + j*ld;
+          const real32_T *b = B + j + k0*ldB;
+          for (c = 0; c < nr; c++) {
+            const real32_T bc = b[c*ldB];
+            for (r = 0; r < mr; r++) {
+              acc[c][r] += a[r] * bc;
+            }
+          }
+        }
+      }
+
+      for (c = 0; c < nr; c++) {
+        real32_T *yc = y + i0 + (k0+c)*ld;
+        for (r = 0; r < mr; r++) {
+          yc[r] = (mode == RT_MM_ADD) ? yc[r] + acc[c][r] : acc[c][r];
+        }
+      }
+    }
+  }
+}
+
+#if RT_MM_X86_SIMD
+
+/*
+ * Function: rt_MatMultTileRR_Sgl_AVX2
+ * Abstract:
+ *      AVX2 kernel for tiles of 16 rows; the remaining rows are done by the
+ *      portable kernel.
+ */
+__attribute__((target("avx2,fma")))
+static void rt_MatMultTileRR_Sgl_AVX2(real32_T       *y,
+                                      const real32_T *A,
+                                      const real32_T *B,
+                                      int_T        nRows,
+                                      int_T        nInner,
+                                      const int_T  dims[3],
+                                      int_T        mode)
+{
+  const int_T ld    = dims[0];
+  const int_T ldB   = dims[1];
+  const int_T p     = dims[2];
+  const int_T mFull = nRows - nRows % 16;
+  int_T i0;
+
+  for (i0 = 0; i0 < mFull; i0 += 16) {
+    int_T k0;
+    for (k0 = 0; k0 < p; k0 += RT_MM_NR) {
+      const int_T nr = (p - k0 < RT_MM_NR) ? p - k0 : RT_MM_NR;
+      __m256 acc[RT_MM_NR][2];
+      int_T c, j;
+
+      for (c = 0; c < RT_MM_NR; c++) {
+        acc[c][0] = _mm256_setzero_ps();
+        acc[c][1] = _mm256_setzero_ps();
+      }
+      if (mode == RT_MM_CONTINUE) {
+        for (c = 0; c < nr; c++) {
+          const real32_T *yc = y + i0 + (k0+c)*ld;
+          acc[c][0] = _mm256_loadu_ps(yc);
+          acc[c][1] = _mm256_loadu_ps(yc + 8);
+        }
+      }
+      for (j = 0; j < nInner; j++) {
+        const real32_T *a  = A + i0 + j*ld;
+        const real32_T *b  = B + j + k0*ldB;
+        const __m256 a0 = _mm256_loadu_ps(a);
+        const __m256 a1 = _mm256_loadu_ps(a + 8);
+        for (c = 0; c < nr; c++) {
+          const __m256 bc = _mm256_set1_ps(b[c*ldB]);
+          acc[c][0] = _mm256_fmadd_ps(a0, bc, acc[c][0]);
+          acc[c][1] = _mm256_fmadd_ps(a1, bc, acc[c][1]);
+        }
+      }
+      for (c = 0; c < nr; c++) {
+        real32_T *yc = y + i0 + (k0+c)*ld;
+        if (mode == RT_MM_ADD) {
+          acc[c][0] = _mm256_add_ps(_mm256_loadu_ps(yc), acc[c][0]);
+          acc[c][1] = _mm256_add_ps(_mm256_loadu_ps(yc + 8), acc[c][1]);
+        }
+        _mm256_storeu_ps(yc, acc[c][0]);
+        _mm256_storeu_ps(yc + 8, acc[c][1]);
+      }
+    }
+  }
+
+  if (mFull < nRows) {
+    rt_MatMultTileRR_Sgl(y + mFull, A + mFull, B, nRows - mFull, nInner,
+                         dims, mode);
+  }
+}
+
+/*
+ * Function: rt_MatMultTileRR_Sgl_AVX512
+ * Abstract:
+ *      AVX-512 kernel for tiles of 32 rows; the remaining rows are done by
+ *      the AVX2 kernel.
+ */
+__attribute__((target("avx512f,avx2,fma")))
+static void rt_MatMultTileRR_Sgl_AVX512(real32_T       *y,
+                                        const real32_T *A,
+                                        const real32_T *B,
+                                        int_T        nRows,
+                                        int_T        nInner,
+                                        const int_T  dims[3],
+                                        int_T        mode)
+{
+  const int_T ld    = dims[0];
+  const int_T ldB   = dims[1];
+  const int_T p     = dims[2];
+  const int_T mFull = nRows - nRows % 32;
+  int_T i0;
+
+  for (i0 = 0; i0 < mFull; i0 += 32) {
+    int_T k0;
+    for (k0 = 0; k0 < p; k0 += RT_MM_NR) {
+      const int_T nr = (p - k0 < RT_MM_NR) ? p - k0 : RT_MM_NR;
+      __m512 acc[RT_MM_NR][2];
+      int_T c, j;
+
+      for (c = 0; c < RT_MM_NR; c++) {
+        acc[c][0] = _mm512_setzero_ps();
+        acc[c][1] = _mm512_setzero_ps();
+      }
+      if (mode == RT_MM_CONTINUE) {
+        for (c = 0; c < nr; c++) {
+          const real32_T *yc = y + i0 + (k0+c)*ld;
+          acc[c][0] = _mm512_loadu_ps(yc);
+          acc[c][1] = _mm512_loadu_ps(yc + 16);
+        }
+      }
+      for (j = 0; j < nInner; j++) {
+        const real32_T *a  = A + i0 + j*ld;
+        const real32_T *b  = B + j + k0*ldB;
+        const __m512 a0 = _mm512_loadu_ps(a);
+        const __m512 a1 = _mm512_loadu_ps(a + 16);
+        for (c = 0; c < nr; c++) {
+          const __m512 bc = _mm512_set1_ps(b[c*ldB]);
+          acc[c][0] = _mm512_fmadd_ps(a0, bc, acc[c][0]);
+          acc[c][1] = _mm512_fmadd_ps(a1, bc, acc[c][1]);
+        }
+      }
+      for (c = 0; c < nr; c++) {
+        real32_T *yc = y + i0 + (k0+c)*ld;
+        if (mode == RT_MM_ADD) {
+          acc[c][0] = _mm512_add_ps(_mm512_loadu_ps(yc), acc[c][0]);
+          acc[c][1] = _mm512_add_ps(_mm512_loadu_ps(yc + 16), acc[c][1]);
+        }
+        _mm512_storeu_ps(yc, acc[c][0]);
+        _mm512_storeu_ps(yc + 16, acc[c][1]);
+      }
+    }
+  }
+
+  if (mFull < nRows) {
+    rt_MatMultTileRR_Sgl_AVX2(y + mFull, A + mFull, B, nRows - mFull,
+                              nInner, dims, mode);
+  }
+}
+
+#endif /* RT_MM_X86_SIMD */
+
+/*
+ * Function: rt_MatMultSelectRR_Sgl
+ * Abstract:
+ *      Select the fastest real kernel supported by the CPU.  The selection
+ *      is made once; concurrent first calls select the same kernel.
+ */
+static rt_MatMultKernelRR_Sgl rt_MatMultSelectRR_Sgl(void)
+{
+  static rt_MatMultKernelRR_Sgl kernel = NULL;
+
+  if (kernel == NULL) {
+    rt_MatMultKernelRR_Sgl selected = rt_MatMultTileRR_Sgl;
+#if RT_MM_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+      selected = rt_MatMultTileRR_Sgl_AVX512;
+    } else if (__builtin_cpu_supports("avx2") &&
+               __builtin_cpu_supports("fma")) {
+      selected = rt_MatMultTileRR_Sgl_AVX2;
+    }
+#endif
+    kernel = selected;
+  }
+  return kernel;
+}
+
+/*
+ * Function: rt_MatMultBlockedRR_Sgl
+ * Abstract:
+ *      y = A*B, or y += A*B if increment is set.
+ *      Input 1: Real, single-precision
+ *      Input 2: Real, single-precision
+ */
+void rt_MatMultBlockedRR_Sgl(real32_T       *y,
+                             const real32_T *A,
+                             const real32_T *B,
+                             const int_T  dims[3],
+                             boolean_T    increment)
+{
+  const rt_MatMultKernelRR_Sgl kernel = rt_MatMultSelectRR_Sgl();
+  const int_T                  m      = dims[0];
+  const int_T                  n      = dims[1];
+  int_T j0;
+
+  for (j0 = 0; j0 < n; j0 += RT_MATMULT_KC) {
+    const int_T kc   = (n - j0 < RT_MATMULT_KC) ? n - j0 : RT_MATMULT_KC;
+    const int_T mode = (j0 > 0) ? RT_MM_CONTINUE :
+                       (increment ? RT_MM_ADD : RT_MM_STORE);
+    int_T i0;
+
+    for (i0 = 0; i0 < m; i0 += RT_MATMULT_MC) {
+      const int_T mc = (m - i0 < RT_MATMULT_MC) ? m - i0 : RT_MATMULT_MC;
+      kernel(y + i0, A + i0 + j0*m, B + j0, mc, kc, dims, mode);
+    }
+  }
+}
+
+#ifdef CREAL_T
+
+/*
+ * Complex kernels.  The products are written out instead of calling
+ * rt_ComplexTimes_Sgl, which only differs for non-finite data.
+ */
+#define RT_MM_CPLX_TILE(fcnName, yType, aType, bType, MULRE, MULIM)       \
+static void fcnName(yType        *y,                                      \
+                    const aType  *A,                                      \
+                    const bType  *B,                                      \
+                    const int_T  dims[3],                                 \
+                    boolean_T    increment)                               \
+{                                                                         \
+  const int_T m = dims[0];                                                \
+  const int_T n = dims[1];                                                \
+  const int_T p = dims[2];                                                \
+  int_T i0;                                                               \
+                                                                          \
+  for (i0 = 0; i0 < m; i0 += RT_MM_MR) {                                  \
+    const int_T mr = (m - i0 < RT_MM_MR) ? m - i0 : RT_MM_MR;             \
+    int_T k0;                                                             \
+                                                                          \
+    for (k0 = 0; k0 < p; k0 += RT_MM_NR) {                                \
+      const int_T nr = (p - k0 < RT_MM_NR) ? p - k0 : RT_MM_NR;           \
+      real32_T accRe[RT_MM_NR][RT_MM_MR];                                   \
+      real32_T accIm[RT_MM_NR][RT_MM_MR];                                   \
+      int_T r, c, j;                                                      \
+                                                                          \
+      for (c = 0; c < RT_MM_NR; c++) {                                    \
+        for (r = 0; r < RT_MM_MR; r++) {                                  \
+          accRe[c][r] = 0.0F;                                              \
+          accIm[c][r] = 0.0F;                                              \
+        }                                                                 \
+      }                                                                   \
+      for (j = 0; j < n; j++) {                                           \
+        const aType *a = A + i0 + j*m;                                    \
+        const bType *b = B + j + k0*n;                                    \
+        for (c = 0; c < nr; c++) {                                        \
+          const bType bc = b[c*n];                                        \
+          for (r = 0; r < mr; r++) {                                      \
+            const aType ar = a[r];                                        \
+            accRe[c][r] += MULRE(ar, bc);                                 \
+            accIm[c][r] += MULIM(ar, bc);                                 \
+          }                                                               \
+        }                                                                 \
+      }                                                                   \
+      for (c = 0; c < nr; c++) {                                          \
+        yType *yc = y + i0 + (k0+c)*m;                                    \
+        for (r = 0; r < mr; r++) {                                        \
+          if (increment) {                                                \
+            yc[r].re += accRe[c][r];                                      \
+            yc[r].im += accIm[c][r];                                      \
+          } else {                                                        \
+            yc[r].re = accRe[c][r];                                       \
+            yc[r].im = accIm[c][r];                                       \
+          }                                                               \
+        }                                                                 \
+      }                                                                   \
+    }                                                                     \
+  }                                                                       \
+}
+
+#define RT_MM_MULRE_RC(a, b) ((a) * (b).re)
+#define RT_MM_MULIM_RC(a, b) ((a) * (b).im)
+#define RT_MM_MULRE_CR(a, b) ((a).re * (b))
+#define RT_MM_MULIM_CR(a, b) ((a).im * (b))
+#define RT_MM_MULRE_CC(a, b) ((a).re * (b).re - (a).im * (b).im)
+#define RT_MM_MULIM_CC(a, b) ((a).re * (b).im + (a).im * (b).re)
+
+RT_MM_CPLX_TILE(rt_MatMultTileRC_Sgl, creal32_T, real32_T, creal32_T,
+                RT_MM_MULRE_RC, RT_MM_MULIM_RC)
+RT_MM_CPLX_TILE(rt_MatMultTileCR_Sgl, creal32_T, creal32_T, real32_T,
+                RT_MM_MULRE_CR, RT_MM_MULIM_CR)
+RT_MM_CPLX_TILE(rt_MatMultTileCC_Sgl, creal32_T, creal32_T, creal32_T,
+                RT_MM_MULRE_CC, RT_MM_MULIM_CC)
+
+/*
+ * Function: rt_MatMultBlockedRC_Sgl
+ * Abstract:
+ *      y = A*B, or y += A*B if increment is set.
+ *      Input 1: Real, single-precision
+ *      Input 2: Complex, single-precision
+ */
+void rt_MatMultBlockedRC_Sgl(creal32_T       *y,
+                             const real32_T  *A,
+                             const creal32_T *B,
+                             const int_T   dims[3],
+                             boolean_T     increment)
+{
+  rt_MatMultTileRC_Sgl(y, A, B, dims, increment);
+}
+
+/*
+ * Function: rt_MatMultBlockedCR_Sgl
+ * Abstract:
+ *      y = A*B, or y += A*B if increment is set.
+ *      Input 1: Complex, single-precision
+ *      Input 2: Real, single-precision
+ */
+void rt_MatMultBlockedCR_Sgl(creal32_T       *y,
+                             const creal32_T *A,
+                             const real32_T  *B,
+                             const int_T   dims[3],
+                             boolean_T     increment)
+{
+  rt_MatMultTileCR_Sgl(y, A, B, dims, increment);
+}
+
+/*
+ * Function: rt_MatMultBlockedCC_Sgl
+ * Abstract:
+ *      y = A*B, or y += A*B if increment is set.
+ *      Input 1: Complex, single-precision
+ *      Input 2: Complex, single-precision
+ */
+void rt_MatMultBlockedCC_Sgl(creal32_T       *y,
+                             const creal32_T *A,
+                             const creal32_T *B,
+                             const int_T   dims[3],
+                             boolean_T     increment)
+{
+  rt_MatMultTileCC_Sgl(y, A, B, dims, increment);
+}
+
+#endif /* CREAL_T */
+
+#endif /* !RT_MATMULT_REFERENCE */
+
+/* [EOF] rt_matmultblocked_sgl.c */
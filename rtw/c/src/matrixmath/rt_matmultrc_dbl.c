@@ -24,6 +24,10 @@ void rt_MatMultRC_Dbl(creal_T       *y,
                       const int_T     dims[3])
 {
   int_T k;
+  if (rt_MatMultUseBlocked(dims)) {
+    rt_MatMultBlockedRC_Dbl(y, A, B, dims, (boolean_T)0);
+    return;
+  }
   for(k=dims[2]; k-- > 0; ) {
     const real_T *A1 = A;
     int_T i;
@@ -109,6 +109,76 @@ extern void rt_MatMultAndIncCC_Sgl(creal32_T       *y,
                                    const int_T   dims[3]);
 #endif 
 
+/*
+ * Blocked kernels used by rt_MatMult* and rt_MatMultAndInc* when the product
+ * has at least RT_MATMULT_BLOCKED_MIN multiply-adds.  Define
+ * RT_MATMULT_REFERENCE=1 to always use the reference loops, e.g. for
+ * certification runs that must reproduce earlier results bit for bit.
+ */
+#ifndef RT_MATMULT_BLOCKED_MIN
+#define RT_MATMULT_BLOCKED_MIN 4096
+#endif
+
+#if defined(RT_MATMULT_REFERENCE) && RT_MATMULT_REFERENCE != 0
+#define rt_MatMultUseBlocked(dims) 0
+#else
+#define rt_MatMultUseBlocked(dims) \
+    ((real_T)(dims)[0]*(real_T)(dims)[1]*(real_T)(dims)[2] >= \
+     (real_T)RT_MATMULT_BLOCKED_MIN)
+#endif
+
+extern void rt_MatMultBlockedRR_Dbl(real_T       *y,
+                                    const real_T *A,
+                                    const real_T *B,
+                                    const int_T  dims[3],
+                                    boolean_T    increment);
+
+#ifdef CREAL_T
+extern void rt_MatMultBlockedRC_Dbl(creal_T       *y,
+                                    const real_T  *A,
+                                    const creal_T *B,
+                                    const int_T   dims[3],
+                                    boolean_T     increment);
+
+extern void rt_MatMultBlockedCR_Dbl(creal_T       *y,
+                                    const creal_T *A,
+                                    const real_T  *B,
+                                    const int_T   dims[3],
+                                    boolean_T     increment);
+
+extern void rt_MatMultBlockedCC_Dbl(creal_T       *y,
+                                    const creal_T *A,
+                                    const creal_T *B,
+                                    const int_T   dims[3],
+                                    boolean_T     increment);
+#endif
+
+extern void rt_MatMultBlockedRR_Sgl(real32_T       *y,
+                                    const real32_T *A,
+                                    const real32_T *B,
+                                    const int_T    dims[3],
+                                    boolean_T      increment);
+
+#ifdef CREAL_T
+extern void rt_MatMultBlockedRC_Sgl(creal32_T       *y,
+                                    const real32_T  *A,
+                                    const creal32_T *B,
+                                    const int_T     dims[3],
+                                    boolean_T       increment);
+
+extern void rt_MatMultBlockedCR_Sgl(creal32_T       *y,
+                                    const creal32_T *A,
+                                    const real32_T  *B,
+                                    const int_T     dims[3],
+                                    boolean_T       increment);
+
+extern void rt_MatMultBlockedCC_Sgl(creal32_T       *y,
+                                    const creal32_T *A,
+                                    const creal32_T *B,
+                                    const int_T     dims[3],
+                                    boolean_T       increment);
+#endif
+
 /* Matrix Inversion Utility Functions */
 extern void rt_lu_real(real_T      *A,
                        const int_T n,
@@ -314,6 +384,103 @@ extern void rt_MatDivCC_Sgl(creal32_T       *Out,
 #endif
 
 
+/*
+ * Optional LAPACK backend.  Build with RT_MATRIXLIB_USE_LAPACK=1 and link an
+ * LP64 LAPACK/BLAS (e.g. -lopenblas, or -llapack -lblas) to route rt_lu_*,
+ * the RR/CC substitution routines and rt_MatDivRR/CC of order
+ * RT_MATRIXLIB_LAPACK_MIN_N and above to ?getrf, ?getrs and ?trsm.  Smaller
+ * systems, where the call overhead dominates, keep the loops below.  The
+ * backend can be switched off at run time by clearing
+ * rt_MatrixLibLapackEnabled.
+ */
+#ifndef RT_MATRIXLIB_USE_LAPACK
+#define RT_MATRIXLIB_USE_LAPACK 0
+#endif
+
+#if RT_MATRIXLIB_USE_LAPACK
+
+#ifndef RT_MATRIXLIB_LAPACK_MIN_N
+#define RT_MATRIXLIB_LAPACK_MIN_N 24
+#endif
+
+#if defined(_WIN32)
+#define RT_LAPACK_FCN(x) x
+#else
+#define RT_LAPACK_FCN(x) x ## _
+#endif
+
+#define rt_MatrixLibUseLapack(n) \
+    (rt_MatrixLibLapackEnabled && (n) >= RT_MATRIXLIB_LAPACK_MIN_N)
+
+extern boolean_T rt_MatrixLibLapackEnabled;
+
+extern void rt_LapackPivotsToPermutation(int32_T *piv,
+                                         int_T   n);
+
+extern void RT_LAPACK_FCN(dgetrf)(const int32_T *m, const int32_T *n,
+                                  real_T *a, const int32_T *lda,
+                                  int32_T *ipiv, int32_T *info);
+extern void RT_LAPACK_FCN(dgetrs)(const char *trans, const int32_T *n,
+                                  const int32_T *nrhs, const real_T *a,
+                                  const int32_T *lda, const int32_T *ipiv,
+                                  real_T *b, const int32_T *ldb,
+                                  int32_T *info);
+extern void RT_LAPACK_FCN(dtrsm)(const char *side, const char *uplo,
+                                 const char *transa, const char *diag,
+                                 const int32_T *m, const int32_T *n,
+                                 const real_T *alpha, const real_T *a,
+                                 const int32_T *lda, real_T *b,
+                                 const int32_T *ldb);
+
+extern void RT_LAPACK_FCN(sgetrf)(const int32_T *m, const int32_T *n,
+                                  real32_T *a, const int32_T *lda,
+                                  int32_T *ipiv, int32_T *info);
+extern void RT_LAPACK_FCN(sgetrs)(const char *trans, const int32_T *n,
+                                  const int32_T *nrhs, const real32_T *a,
+                                  const int32_T *lda, const int32_T *ipiv,
+                                  real32_T *b, const int32_T *ldb,
+                                  int32_T *info);
+extern void RT_LAPACK_FCN(strsm)(const char *side, const char *uplo,
+                                 const char *transa, const char *diag,
+                                 const int32_T *m, const int32_T *n,
+                                 const real32_T *alpha, const real32_T *a,
+                                 const int32_T *lda, real32_T *b,
+                                 const int32_T *ldb);
+
+#ifdef CREAL_T
+extern void RT_LAPACK_FCN(zgetrf)(const int32_T *m, const int32_T *n,
+                                  creal_T *a, const int32_T *lda,
+                                  int32_T *ipiv, int32_T *info);
+extern void RT_LAPACK_FCN(zgetrs)(const char *trans, const int32_T *n,
+                                  const int32_T *nrhs, const creal_T *a,
+                                  const int32_T *lda, const int32_T *ipiv,
+                                  creal_T *b, const int32_T *ldb,
+                                  int32_T *info);
+extern void RT_LAPACK_FCN(ztrsm)(const char *side, const char *uplo,
+                                 const char *transa, const char *diag,
+                                 const int32_T *m, const int32_T *n,
+                                 const creal_T *alpha, const creal_T *a,
+                                 const int32_T *lda, creal_T *b,
+                                 const int32_T *ldb);
+
+extern void RT_LAPACK_FCN(cgetrf)(const int32_T *m, const int32_T *n,
+                                  creal32_T *a, const int32_T *lda,
+                                  int32_T *ipiv, int32_T *info);
+extern void RT_LAPACK_FCN(cgetrs)(const char *trans, const int32_T *n,
+                                  const int32_T *nrhs, const creal32_T *a,
+                                  const int32_T *lda, const int32_T *ipiv,
+                                  creal32_T *b, const int32_T *ldb,
+                                  int32_T *info);
+extern void RT_LAPACK_FCN(ctrsm)(const char *side, const char *uplo,
+                                 const char *transa, const char *diag,
+                                 const int32_T *m, const int32_T *n,
+                                 const creal32_T *alpha, const creal32_T *a,
+                                 const int32_T *lda, creal32_T *b,
+                                 const int32_T *ldb);
+#endif
+
+#endif /* RT_MATRIXLIB_USE_LAPACK */
+
 /* Matrix multiplication defines */
 
 /* Quick (approximate) complex absolute value: */
@@ -0,0 +1,55 @@
+/* Copyright 2026 The MathWorks, Inc.
+ *
+ * File: rt_matrixlib_lapack.c
+ *
+ * Abstract:
+ *      Simulink Coder support for the optional LAPACK backend of the
+ *      LU factorization, substitution and matrix division routines
+ *
+ */
+
+#include "rt_matrixlib.h"
+
+/* Logical definitions */
+#if (!defined(__cplusplus))
+#  ifndef true
+#   define true                        (1U)
+#  endif
+#endif
+
+#if RT_MATRIXLIB_USE_LAPACK
+
+/* Run-time switch; cleared to force the built-in loops. */
+boolean_T rt_MatrixLibLapackEnabled = true;
+
+/* Function: rt_LapackPivotsToPermutation ======================================
+ * Abstract: Convert the 1-based row interchanges returned by ?getrf
+ *           (row k was swapped with row ipiv[k]) in place into the 0-based
+ *           row permutation returned by rt_lu_* (row k of LU is row piv[k]
+ *           of A).
+ *
+ *           Entry k of the permutation only depends on interchanges 0..k,
+ *           so walking k downwards lets each entry overwrite its own
+ *           interchange.
+ */
+void rt_LapackPivotsToPermutation(int32_T *piv,
+                                  int_T   n)
+{
+  int_T k;
+  for (k = n; k-- > 0; ) {
+    int32_T row = piv[k] - 1;
+    int_T   j;
+    for (j = k; j-- > 0; ) {
+      if (row == (int32_T)j) {
+        row = piv[j] - 1;
+      } else if (row == piv[j] - 1) {
+        row = (int32_T)j;
+      }
+    }
+    piv[k] = row;
+  }
+}
+
+#endif /* RT_MATRIXLIB_USE_LAPACK */
+
+/* [EOF] rt_matrixlib_lapack.c */
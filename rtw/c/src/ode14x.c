@@ -3,6 +3,13 @@
  *
  * File: ode14x.c        
  *
+ * Abstract:
+ *      Fixed-step implicit extrapolation solver.  The optional sparse
+ *      Jacobian path (see "Sparse Jacobian support" below) exists only with
+ *      RT_MALLOC and is unused by default: ODE14X_SPARSE_MIN_STATES is 0,
+ *      so no pattern is detected, and no code in this tree sets one with
+ *      rtsiSetSolverJacobianPatternJc/Ir.
+ *
  */
 
 #include <math.h>
@@ -18,6 +25,26 @@
 
 #define MAXORDER 4
 
+/*
+ * Jacobian reuse.  The Jacobian is kept for up to ODE14X_JACOBIAN_MAX_AGE
+ * steps (1: evaluated every step) and re-evaluated early when a Newton
+ * iteration contracts by less than ODE14X_NEWTON_MAX_RATE, which needs at
+ * least two Newton iterations to be observed.  With reuse enabled, the LU
+ * of I - hN*J for each extrapolation order is kept as well and refactored
+ * only when the Jacobian or hN changes.
+ */
+#ifndef ODE14X_JACOBIAN_MAX_AGE
+# define ODE14X_JACOBIAN_MAX_AGE 1
+#endif
+#ifndef ODE14X_NEWTON_MAX_RATE
+# define ODE14X_NEWTON_MAX_RATE  0.5
+#endif
+#if ODE14X_JACOBIAN_MAX_AGE > 1
+# define ODE14X_LU_SLOTS MAXORDER
+#else
+# define ODE14X_LU_SLOTS 1
+#endif
+
 static int_T rt_ODE14x_N[MAXORDER] = {12, 8, 6, 4};
 
 typedef struct IntgData_tag {
@@ -34,10 +61,740 @@ typedef struct IntgData_tag {
     real_T  *DFDX; /* nx x nx */
 
     /* LU: */
-    real_T  *W;    /* nx x nx */
-    int32_T *pivots; /* nx */
+    real_T  *W;    /* ODE14X_LU_SLOTS x nx x nx */
+    int32_T *pivots; /* ODE14X_LU_SLOTS x nx */
+
+    /* reuse: */
+    int_T   jacAge;                 /* steps since evaluation, 0: evaluate */
+    real_T  luH[ODE14X_LU_SLOTS];   /* hN factored in each slot, 0: none */
+
+#ifdef RT_MALLOC
+    /* sparse Jacobian and LU, replaces DFDX, W and pivots when non-NULL */
+    struct SparseJac_tag *sparse;
+#endif
 } IntgData;
 
+/* Constants of the finite-difference Jacobian */
+#define NUMJAC_THRESH 1e-6
+#define NUMJAC_FACMAX 0.1
+
+/* Function: local_numjac_del ==================================================
+ * Abstract:
+ *      Select an increment del for a difference approximation to column j of
+ *      dFdy.  The vector fac accounts for experience gained in previous calls
+ *      to numjac.
+ */
+static real_T local_numjac_del(const real_T *x,
+                               const real_T *y,
+                               const real_T *Fty,
+                               real_T       *fac,
+                               int_T        j)
+{
+    real_T xscale = fabs(x[j]);
+    real_T temp;
+    real_T del;
+
+    if (xscale < NUMJAC_THRESH) xscale = NUMJAC_THRESH;
+    temp = (x[j] + fac[j]*xscale);
+    del  = temp  - y[j];
+    while (del == 0.0) {
+        if (fac[j] < NUMJAC_FACMAX) {
+            fac[j] *= 100.0;
+            if (fac[j] > NUMJAC_FACMAX) fac[j] = NUMJAC_FACMAX;
+            temp = (x[j] + fac[j]*xscale);
+            del  = temp  - x[j];
+        } else {
+            del = NUMJAC_THRESH; /* thresh is nonzero */
+            break;
+        }
+    }
+    /* Keep del pointing into region. */
+    if (Fty[j] >= 0.0) del = fabs(del);
+    else del = -fabs(del);
+
+    return del;
+
+} /* end local_numjac_del */
+
+
+/* Function: local_numjac_fac ==================================================
+ * Abstract:
+ *      Adjust fac[j] for the next call to numjac from the largest difference
+ *      difmax seen in column j, found in a row where the perturbed and
+ *      nominal derivatives are FdelRowmax and FtyRowmax.
+ */
+static void local_numjac_fac(real_T *fac,
+                             int_T  j,
+                             real_T difmax,
+                             real_T FdelRowmax,
+                             real_T FtyRowmax,
+                             real_T BL,
+                             real_T BU,
+                             real_T FACMIN)
+{
+    if (((FdelRowmax != 0.0) && (FtyRowmax != 0.0)) || (difmax == 0.0)) {
+        real_T fscale = fabs(FdelRowmax);
+        if (fscale < fabs(FtyRowmax)) fscale = fabs(FtyRowmax);
+
+        if (difmax <= BL*fscale) {
+            /* The difference is small, so increase the increment. */
+            fac[j] *= 10.0;
+            if (fac[j] > NUMJAC_FACMAX) fac[j] = NUMJAC_FACMAX;
+
+        } else if (difmax > BU*fscale) {
+            /* The difference is large, so reduce the increment. */
+            fac[j] *= 0.1;
+            if (fac[j] < FACMIN) fac[j] = FACMIN;
+
+        }
+    }
+
+} /* end local_numjac_fac */
+
+
+#ifdef RT_MALLOC
+/*
+ * Sparse Jacobian support.
+ *
+ * With many loosely coupled states, the dense difference Jacobian (one
+ * model evaluation per state) and the dense LU of I - h*J dominate the
+ * cost of a step.  Given the sparsity pattern of df/dx -- supplied by the
+ * model with rtsiSetSolverJacobianPatternJc/Ir, or detected from full
+ * differences during the first ODE14X_SPARSE_DETECT_STEPS steps -- the
+ * columns are grouped so that no two columns of a group share a row, each
+ * group costs a single model evaluation, and I - h*J is factored by a
+ * sparse left-looking LU with threshold partial pivoting.
+ *
+ * A supplied pattern is used as is (compressed columns, no duplicate
+ * entries); the diagonal is added if missing.  A detected pattern that is
+ * denser than ODE14X_SPARSE_MAX_DENSITY falls back to the dense solver.
+ *
+ * Detection is off unless ODE14X_SPARSE_MIN_STATES is defined: a detected
+ * pattern only holds the couplings that were nonzero during the detection
+ * steps, so terms that switch on later or multiply states that start at
+ * zero are missing from the Jacobian for the rest of the run.  Enable it
+ * only for models known not to have such terms.
+ *
+ * Limitations: all of this is compiled only with RT_MALLOC, and nothing in
+ * this tree supplies a pattern -- the generated model code does not call
+ * rtsiSetSolverJacobianPatternJc/Ir -- so with the default settings every
+ * model uses the dense solver.  The sparse path is reached only when a
+ * target sets the pattern itself or defines ODE14X_SPARSE_MIN_STATES.
+ */
+#ifndef ODE14X_SPARSE_MIN_STATES
+# define ODE14X_SPARSE_MIN_STATES   0    /* detect for nx >= this, 0: never */
+#endif
+#ifndef ODE14X_SPARSE_DETECT_STEPS
+# define ODE14X_SPARSE_DETECT_STEPS 3
+#endif
+#ifndef ODE14X_SPARSE_MAX_DENSITY
+# define ODE14X_SPARSE_MAX_DENSITY  0.2
+#endif
+#ifndef ODE14X_SPARSE_PIVOT_TOL
+# define ODE14X_SPARSE_PIVOT_TOL    0.1  /* keep the diagonal pivot if it is
+                                            at least this times the largest */
+#endif
+
+/* LU of W: L unit lower with the diagonal first in each column, U upper
+   with the diagonal last; row i of W is row pinv[i] of LU */
+typedef struct SparseLU_tag {
+    int_T   lcap;
+    int_T   *Lp;          /* nx+1 */
+    int_T   *Li;          /* lcap */
+    real_T  *Lx;          /* lcap */
+    int_T   ucap;
+    int_T   *Up;          /* nx+1 */
+    int_T   *Ui;          /* ucap */
+    real_T  *Ux;          /* ucap */
+    int_T   *pinv;        /* nx */
+} SparseLU;
+
+typedef struct SparseJac_tag {
+    int_T   nx;
+    int_T   detectSteps;  /* steps left that use full differences */
+
+    /* J = df/dx on its pattern, compressed columns, diagonal included */
+    int_T   *Jc;          /* nx+1 */
+    int_T   *Ir;          /* Jc[nx] */
+    int_T   *diag;        /* nx, position of J(j,j) */
+    real_T  *Jx;          /* Jc[nx] */
+    real_T  *Wx;          /* Jc[nx], I - hN*J */
+
+    /* groups of columns that share no row */
+    int_T   ngroups;
+    int_T   *groupJc;     /* ngroups+1 */
+    int_T   *groupCols;   /* nx */
+
+    SparseLU lu[ODE14X_LU_SLOTS];
+
+    real_T  *work;        /* 3*nx */
+    int_T   *iwork;       /* 4*nx */
+} SparseJac;
+
+
+static void local_sparse_destroy(SparseJac *sj)
+{
+    int_T k;
+
+    for (k = 0; k < ODE14X_LU_SLOTS; k++) {
+        free(sj->lu[k].Lp);
+        free(sj->lu[k].Li);
+        free(sj->lu[k].Lx);
+        free(sj->lu[k].Up);
+        free(sj->lu[k].Ui);
+        free(sj->lu[k].Ux);
+        free(sj->lu[k].pinv);
+    }
+    free(sj->Jc);
+    free(sj->Ir);
+    free(sj->diag);
+    free(sj->Jx);
+    free(sj->Wx);
+    free(sj->groupJc);
+    free(sj->groupCols);
+    free(sj->work);
+    free(sj->iwork);
+    free(sj);
+
+} /* end local_sparse_destroy */
+
+
+/* Function: local_sparse_set_pattern ==========================================
+ * Abstract:
+ *      Install a new pattern (Jc already updated) with its values and locate
+ *      the diagonal.  Takes ownership of Ir and Jx.
+ */
+static boolean_T local_sparse_set_pattern(SparseJac *sj,
+                                          int_T     *Ir,
+                                          real_T    *Jx)
+{
+    int_T j, p;
+
+    free(sj->Ir);
+    free(sj->Jx);
+    free(sj->Wx);
+    sj->Ir = Ir;
+    sj->Jx = Jx;
+    sj->Wx = (real_T *) malloc(sj->Jc[sj->nx]*sizeof(real_T));
+    if (sj->Wx == NULL) return(0);
+
+    for (j = 0; j < sj->nx; j++) {
+        for (p = sj->Jc[j]; p < sj->Jc[j+1]; p++) {
+            if (Ir[p] == j) sj->diag[j] = p;
+        }
+    }
+    return(1);
+
+} /* end local_sparse_set_pattern */
+
+
+/* Function: local_sparse_group ================================================
+ * Abstract:
+ *      Greedy column grouping: each column joins the lowest numbered group
+ *      in which no column shares a row with it.  Columns of a group can then
+ *      be perturbed together.
+ */
+static boolean_T local_sparse_group(SparseJac *sj)
+{
+    int_T       nx        = sj->nx;
+    const int_T *Jc       = sj->Jc;
+    const int_T *Ir       = sj->Ir;
+    int_T       *rowPtr   = sj->iwork;       /* nx+1 */
+    int_T       *color    = rowPtr + nx + 1; /* nx */
+    int_T       *forbid   = color + nx;      /* nx */
+    int_T       *colIdx;
+    int_T       i, j, p, q;
+
+    colIdx = (int_T *) malloc(Jc[nx]*sizeof(int_T));
+    if (colIdx == NULL) return(0);
+
+    /* Row-wise copy of the pattern */
+    for (i = 0; i <= nx; i++) rowPtr[i] = 0;
+    for (p = 0; p < Jc[nx]; p++) rowPtr[Ir[p]+1]++;
+    for (i = 0; i < nx; i++) rowPtr[i+1] += rowPtr[i];
+    for (j = 0; j < nx; j++) {
+        for (p = Jc[j]; p < Jc[j+1]; p++) colIdx[rowPtr[Ir[p]]++] = j;
+    }
+    for (i = nx; i > 0; i--) rowPtr[i] = rowPtr[i-1];
+    rowPtr[0] = 0;
+
+    for (j = 0; j < nx; j++) {
+        color[j]  = -1;
+        forbid[j] = -1;
+    }
+    sj->ngroups = 0;
+    for (j = 0; j < nx; j++) {
+        int_T c = 0;
+        for (p = Jc[j]; p < Jc[j+1]; p++) {
+            i = Ir[p];
+            for (q = rowPtr[i]; q < rowPtr[i+1]; q++) {
+                if (color[colIdx[q]] >= 0) forbid[color[colIdx[q]]] = j;
+            }
+        }
+        while (forbid[c] == j) c++;
+        color[j] = c;
+        if (c >= sj->ngroups) sj->ngroups = c + 1;
+    }
+    free(colIdx);
+
+    /* Sort the columns by group */
+    for (i = 0; i <= sj->ngroups; i++) sj->groupJc[i] = 0;
+    for (j = 0; j < nx; j++) sj->groupJc[color[j]+1]++;
+    for (i = 0; i < sj->ngroups; i++) {
+        sj->groupJc[i+1] += sj->groupJc[i];
+        forbid[i] = sj->groupJc[i];
+    }
+    for (j = 0; j < nx; j++) sj->groupCols[forbid[color[j]]++] = j;
+
+    return(1);
+
+} /* end local_sparse_group */
+
+
+/* Function: local_sparse_create ===============================================
+ * Abstract:
+ *      Allocate the sparse Jacobian data.  With a supplied pattern the column
+ *      groups are formed right away; otherwise the pattern starts as the
+ *      diagonal and is completed by the detection steps.
+ */
+static SparseJac *local_sparse_create(int_T       nx,
+                                      const int_T *Jc,
+                                      const int_T *Ir)
+{
+    SparseJac *sj = (SparseJac *) calloc(1, sizeof(SparseJac));
+    int_T     nz  = 0;
+    int_T     *newIr;
+    real_T    *newJx;
+    boolean_T luOk = 1;
+    int_T     j, p;
+
+    if (sj == NULL) return(NULL);
+    sj->nx        = nx;
+    sj->Jc        = (int_T *) malloc((nx+1)*sizeof(int_T));
+    sj->diag      = (int_T *) malloc(nx*sizeof(int_T));
+    sj->groupJc   = (int_T *) malloc((nx+1)*sizeof(int_T));
+    sj->groupCols = (int_T *) malloc(nx*sizeof(int_T));
+    for (j = 0; j < ODE14X_LU_SLOTS; j++) {
+        SparseLU *f = &sj->lu[j];
+        f->Lp   = (int_T *) malloc((nx+1)*sizeof(int_T));
+        f->Up   = (int_T *) malloc((nx+1)*sizeof(int_T));
+        f->pinv = (int_T *) malloc(nx*sizeof(int_T));
+        if (f->Lp == NULL || f->Up == NULL || f->pinv == NULL) luOk = 0;
+    }
+    sj->work      = (real_T *) malloc(3*nx*sizeof(real_T));
+    sj->iwork     = (int_T *) malloc(4*nx*sizeof(int_T));
+
+    nz    = (Jc != NULL) ? Jc[nx] + nx : nx;
+    newIr = (int_T *) malloc(nz*sizeof(int_T));
+    newJx = (real_T *) calloc(nz, sizeof(real_T));
+
+    if (sj->Jc == NULL || sj->diag == NULL || sj->groupJc == NULL ||
+        sj->groupCols == NULL || !luOk ||
+        sj->work == NULL || sj->iwork == NULL ||
+        newIr == NULL || newJx == NULL) {
+        free(newIr);
+        free(newJx);
+        local_sparse_destroy(sj);
+        return(NULL);
+    }
+
+    nz = 0;
+    for (j = 0; j < nx; j++) {
+        boolean_T hasDiag = 0;
+        sj->Jc[j] = nz;
+        if (Jc != NULL) {
+            for (p = Jc[j]; p < Jc[j+1]; p++) {
+                newIr[nz++] = Ir[p];
+                if (Ir[p] == j) hasDiag = 1;
+            }
+        }
+        if (!hasDiag) newIr[nz++] = j;
+    }
+    sj->Jc[nx] = nz;
+
+    if (!local_sparse_set_pattern(sj, newIr, newJx) ||
+        (Jc != NULL && !local_sparse_group(sj))) {
+        local_sparse_destroy(sj);
+        return(NULL);
+    }
+    sj->detectSteps = (Jc != NULL) ? 0 : ODE14X_SPARSE_DETECT_STEPS;
+
+    return(sj);
+
+} /* end local_sparse_create */
+
+
+/* Function: local_sparse_detect ===============================================
+ * Abstract:
+ *      Full difference Jacobian, one model evaluation per column as in
+ *      local_numjac, that adds every nonzero difference to the pattern.
+ */
+static boolean_T local_sparse_detect(RTWSolverInfo *si,
+                                     SparseJac     *sj,
+                                     real_T        *y,
+                                     const real_T  *Fty,
+                                     real_T        *fac)
+{
+    real_T EPS    = 2.2e-16;  /* utGetEps(); */
+    real_T BL     = pow(EPS, 0.75);
+    real_T BU     = pow(EPS, 0.25);
+    real_T FACMIN = pow(EPS, 0.78);
+
+    int_T  nx     = sj->nx;
+    int_T  *Jc    = sj->Jc;
+    real_T *x     = rtsiGetContStates(si);
+    real_T *fdel  = sj->work;
+    int_T  nzmax  = Jc[nx] + nx;
+    int_T  nz     = 0;
+    int_T  *newIr = (int_T *) malloc(nzmax*sizeof(int_T));
+    real_T *newJx = (real_T *) malloc(nzmax*sizeof(real_T));
+    int_T  i, j;
+
+    if (newIr == NULL || newJx == NULL) goto NOMEM;
+
+    if (x != y) (void)memcpy(x,y,nx*sizeof(real_T));
+
+    rtsiSetdX(si,fdel);
+    for (j = 0; j < nx; j++) {
+        real_T del    = local_numjac_del(x,y,Fty,fac,j);
+        real_T temp   = x[j];
+        real_T difmax = 0.0;
+        real_T FdelRowmax;
+        int_T  rowmax = 0;
+        int_T  q      = Jc[j];
+        int_T  qend   = Jc[j+1];
+
+        x[j] += del;
+        OUTPUTS(si,0);
+        DERIVATIVES(si);
+        x[j] = temp;
+
+        if (nz + nx > nzmax) {
+            int_T  *tmpIr;
+            real_T *tmpJx;
+            nzmax = 2*nzmax;
+            tmpIr = (int_T *) realloc(newIr, nzmax*sizeof(int_T));
+            if (tmpIr == NULL) goto NOMEM;
+            newIr = tmpIr;
+            tmpJx = (real_T *) realloc(newJx, nzmax*sizeof(real_T));
+            if (tmpJx == NULL) goto NOMEM;
+            newJx = tmpJx;
+        }
+
+        /* Merge the rows with a nonzero difference into the pattern */
+        Jc[j] = nz;
+        FdelRowmax = fdel[0];
+        temp = 1.0 / del;
+        for (i = 0; i < nx; i++) {
+            real_T Fdiff = fdel[i] - Fty[i];
+            real_T maybe = fabs(Fdiff);
+            if (maybe > difmax) {
+                difmax = maybe;
+                rowmax = i;
+                FdelRowmax = fdel[i];
+            }
+            while (q < qend && sj->Ir[q] < i) q++;
+            if (Fdiff != 0.0 || i == j || (q < qend && sj->Ir[q] == i)) {
+                newIr[nz]   = i;
+                newJx[nz++] = temp * Fdiff;
+            }
+        }
+
+        local_numjac_fac(fac,j,difmax,FdelRowmax,Fty[rowmax],BL,BU,FACMIN);
+    }
+    Jc[nx] = nz;
+
+    return(local_sparse_set_pattern(sj, newIr, newJx));
+
+  NOMEM:
+    free(newIr);
+    free(newJx);
+    return(0);
+
+} /* end local_sparse_detect */
+
+
+/* Function: local_sparse_numjac ===============================================
+ * Abstract:
+ *      Difference Jacobian on the pattern, one model evaluation per column
+ *      group.
+ */
+static void local_sparse_numjac(RTWSolverInfo *si,
+                                SparseJac     *sj,
+                                real_T        *y,
+                                const real_T  *Fty,
+                                real_T        *fac)
+{
+    real_T EPS    = 2.2e-16;  /* utGetEps(); */
+    real_T BL     = pow(EPS, 0.75);
+    real_T BU     = pow(EPS, 0.25);
+    real_T FACMIN = pow(EPS, 0.78);
+
+    int_T       nx    = sj->nx;
+    const int_T *Jc   = sj->Jc;
+    const int_T *Ir   = sj->Ir;
+    real_T      *x    = rtsiGetContStates(si);
+    real_T      *fdel = sj->work;
+    real_T      *del  = fdel + nx;
+    real_T      *xsav = del + nx;
+    int_T       g, k, p;
+
+    if (x != y) (void)memcpy(x,y,nx*sizeof(real_T));
+
+    rtsiSetdX(si,fdel);
+    for (g = 0; g < sj->ngroups; g++) {
+        const int_T *cols = sj->groupCols + sj->groupJc[g];
+        int_T       ncols = sj->groupJc[g+1] - sj->groupJc[g];
+
+        /* Perturb all columns of the group at once */
+        for (k = 0; k < ncols; k++) {
+            int_T j = cols[k];
+            del[j]  = local_numjac_del(x,y,Fty,fac,j);
+            xsav[j] = x[j];
+            x[j]   += del[j];
+        }
+
+        OUTPUTS(si,0);
+        DERIVATIVES(si);
+
+        for (k = 0; k < ncols; k++) x[cols[k]] = xsav[cols[k]];
+
+        for (k = 0; k < ncols; k++) {
+            int_T  j          = cols[k];
+            real_T temp       = 1.0 / del[j];
+            real_T difmax     = 0.0;
+            int_T  rowmax     = Ir[Jc[j]];
+            real_T FdelRowmax = fdel[rowmax];
+
+            for (p = Jc[j]; p < Jc[j+1]; p++) {
+                int_T  i     = Ir[p];
+                real_T Fdiff = fdel[i] - Fty[i];
+                real_T maybe = fabs(Fdiff);
+                if (maybe > difmax) {
+                    difmax = maybe;
+                    rowmax = i;
+                    FdelRowmax = fdel[i];
+                }
+                sj->Jx[p] = temp * Fdiff;
+            }
+
+            local_numjac_fac(fac,j,difmax,FdelRowmax,Fty[rowmax],BL,BU,FACMIN);
+        }
+    }
+
+} /* end local_sparse_numjac */
+
+
+/* Function: local_sparse_reach ================================================
+ * Abstract:
+ *      Rows reached from column k of W in the graph of the columns of L
+ *      computed so far, in topological order in xi[top..nx-1].
+ */
+static int_T local_sparse_reach(SparseJac      *sj,
+                                const SparseLU *f,
+                                int_T          k)
+{
+    int_T       nx     = sj->nx;
+    const int_T *Li    = f->Li;
+    int_T       *xi    = sj->iwork;
+    int_T       *stack = xi + nx;
+    int_T       *pstk  = stack + nx;
+    int_T       *mark  = pstk + nx;
+    int_T       top    = nx;
+    int_T       p;
+
+    for (p = sj->Jc[k]; p < sj->Jc[k+1]; p++) {
+        int_T head = 0;
+        if (mark[sj->Ir[p]] == k) continue;
+        stack[0] = sj->Ir[p];
+        while (head >= 0) {
+            int_T j = stack[head];
+            int_T J = f->pinv[j];
+            int_T q, qend;
+
+            if (mark[j] != k) {
+                mark[j] = k;
+                pstk[head] = (J < 0) ? 0 : f->Lp[J] + 1;
+            }
+            qend = (J < 0) ? 0 : f->Lp[J+1];
+            for (q = pstk[head]; q < qend && mark[Li[q]] == k; q++);
+            if (q < qend) {
+                pstk[head] = q + 1;
+                stack[++head] = Li[q];
+            } else {
+                head--;
+                xi[--top] = j;
+            }
+        }
+    }
+    return(top);
+
+} /* end local_sparse_reach */
+
+
+static boolean_T local_sparse_grow(int_T  **i,
+                                   real_T **x,
+                                   int_T  *cap,
+                                   int_T  need)
+{
+    int_T  newcap = 2*(*cap);
+    int_T  *ni;
+    real_T *nx;
+
+    if (newcap < need) newcap = need;
+    ni = (int_T *) realloc(*i, newcap*sizeof(int_T));
+    if (ni == NULL) return(0);
+    *i = ni;
+    nx = (real_T *) realloc(*x, newcap*sizeof(real_T));
+    if (nx == NULL) return(0);
+    *x = nx;
+    *cap = newcap;
+    return(1);
+
+} /* end local_sparse_grow */
+
+
+/* Function: local_sparse_lu ===================================================
+ * Abstract:
+ *      [L,U] = lu(I - hN*J) into LU slot f, left-looking (Gilbert-Peierls)
+ *      with threshold partial pivoting.  A zero pivot is kept, as in
+ *      rt_lu_real, and shows up in the solution.
+ */
+static boolean_T local_sparse_lu(SparseJac *sj,
+                                 SparseLU  *f,
+                                 real_T    hN)
+{
+    int_T       nx   = sj->nx;
+    const int_T *Jc  = sj->Jc;
+    const int_T *Ir  = sj->Ir;
+    real_T      *Wx  = sj->Wx;
+    real_T      *x   = sj->work;
+    int_T       *xi  = sj->iwork;
+    int_T       *mark = xi + 3*nx;
+    int_T       *pinv = f->pinv;
+    int_T       lnz  = 0;
+    int_T       unz  = 0;
+    int_T       i, k, p;
+
+    for (p = 0; p < Jc[nx]; p++) Wx[p] = -hN * sj->Jx[p];
+    for (k = 0; k < nx; k++) Wx[sj->diag[k]] += 1.0;
+
+    for (i = 0; i < nx; i++) {
+        pinv[i] = -1;
+        mark[i] = -1;
+    }
+
+    for (k = 0; k < nx; k++) {
+        int_T  top;
+        int_T  ipiv = -1;
+        real_T a    = -1.0;
+        real_T pivot;
+
+        if ((lnz + nx > f->lcap &&
+             !local_sparse_grow(&f->Li, &f->Lx, &f->lcap, lnz + nx)) ||
+            (unz + nx > f->ucap &&
+             !local_sparse_grow(&f->Ui, &f->Ux, &f->ucap, unz + nx))) {
+            return(0);
+        }
+        f->Lp[k] = lnz;
+        f->Up[k] = unz;
+
+        /* x = L \ W(:,k) */
+        top = local_sparse_reach(sj, f, k);
+        for (p = top; p < nx; p++) x[xi[p]] = 0.0;
+        for (p = Jc[k]; p < Jc[k+1]; p++) x[Ir[p]] = Wx[p];
+        for (p = top; p < nx; p++) {
+            int_T  j = xi[p];
+            int_T  J = pinv[j];
+            real_T xj;
+            int_T  q;
+            if (J < 0) continue;
+            xj = x[j];
+            for (q = f->Lp[J] + 1; q < f->Lp[J+1]; q++) {
+                x[f->Li[q]] -= f->Lx[q] * xj;
+            }
+        }
+
+        /* Pivotal rows go to U; the largest remaining entry is the pivot,
+           unless the diagonal is close enough to it */
+        for (p = top; p < nx; p++) {
+            i = xi[p];
+            if (pinv[i] < 0) {
+                if (fabs(x[i]) > a) {
+                    a = fabs(x[i]);
+                    ipiv = i;
+                }
+            } else {
+                f->Ui[unz]   = pinv[i];
+                f->Ux[unz++] = x[i];
+            }
+        }
+        if (ipiv < 0) {
+            /* structurally singular column */
+            for (ipiv = 0; pinv[ipiv] >= 0; ipiv++);
+            pivot = 0.0;
+        } else {
+            if (mark[k] == k && pinv[k] < 0 &&
+                fabs(x[k]) >= ODE14X_SPARSE_PIVOT_TOL * a) {
+                ipiv = k;
+            }
+            pivot = x[ipiv];
+        }
+        f->Ui[unz]   = k;
+        f->Ux[unz++] = pivot;
+        pinv[ipiv]    = k;
+        f->Li[lnz]   = ipiv;
+        f->Lx[lnz++] = 1.0;
+        for (p = top; p < nx; p++) {
+            i = xi[p];
+            if (pinv[i] < 0) {
+                f->Li[lnz]   = i;
+                f->Lx[lnz++] = (pivot != 0.0) ? x[i] / pivot : x[i];
+            }
+        }
+    }
+    f->Lp[nx] = lnz;
+    f->Up[nx] = unz;
+
+    /* Renumber the rows of L in pivot order */
+    for (p = 0; p < lnz; p++) f->Li[p] = pinv[f->Li[p]];
+
+    return(1);
+
+} /* end local_sparse_lu */
+
+
+/* Function: local_sparse_solve ================================================
+ * Abstract:
+ *      b = U \ (L \ b(p)), in place, with the factors in LU slot f.
+ */
+static void local_sparse_solve(SparseJac      *sj,
+                               const SparseLU *f,
+                               real_T         *b)
+{
+    int_T  nx = sj->nx;
+    real_T *x = sj->work;
+    int_T  i, j, p;
+
+    for (i = 0; i < nx; i++) x[f->pinv[i]] = b[i];
+    for (j = 0; j < nx; j++) {
+        real_T xj = x[j];
+        for (p = f->Lp[j] + 1; p < f->Lp[j+1]; p++) {
+            x[f->Li[p]] -= f->Lx[p] * xj;
+        }
+    }
+    for (j = nx - 1; j >= 0; j--) {
+        real_T xj = (x[j] /= f->Ux[f->Up[j+1] - 1]);
+        for (p = f->Up[j]; p < f->Up[j+1] - 1; p++) {
+            x[f->Ui[p]] -= f->Ux[p] * xj;
+        }
+    }
+    (void)memcpy(b, x, nx*sizeof(real_T));
+
+} /* end local_sparse_solve */
+#endif /* RT_MALLOC */
+
+
 #ifndef RT_MALLOC
   /* statically declare data */
   static real_T   rt_ODE14x_X0[NCSTATES];
@@ -48,8 +805,8 @@ typedef struct IntgData_tag {
   static real_T   rt_ODE14x_E[MAXORDER*NCSTATES];
   static real_T   rt_ODE14x_FAC[NCSTATES];
   static real_T   rt_ODE14x_DFDX[NCSTATES*NCSTATES];
-  static real_T   rt_ODE14x_W[NCSTATES*NCSTATES];
-  static int32_T  rt_ODE14x_PIVOTS[NCSTATES];
+  static real_T   rt_ODE14x_W[ODE14X_LU_SLOTS*NCSTATES*NCSTATES];
+  static int32_T  rt_ODE14x_PIVOTS[ODE14X_LU_SLOTS*NCSTATES];
 
   static IntgData rt_ODE14x_IntgData = {rt_ODE14x_X0,
                                         rt_ODE14x_F0,
@@ -60,7 +817,9 @@ typedef struct IntgData_tag {
 					rt_ODE14x_FAC,
 					rt_ODE14x_DFDX,
                                         rt_ODE14x_W,
-                                        rt_ODE14x_PIVOTS};
+                                        rt_ODE14x_PIVOTS,
+                                        0,
+                                        {0.0}};
 					
   void rt_ODECreateIntegrationData(RTWSolverInfo *si)
   {
@@ -78,12 +837,28 @@ typedef struct IntgData_tag {
 #else
   /* dynamically allocated data */
 
+  /* Allocate the dense Jacobian and iteration matrix */
+  static boolean_T local_alloc_dense(IntgData *id, int_T nx)
+  {
+      int_T msize = nx * nx * sizeof(real_T);
+
+      id->DFDX = (real_T *) malloc((1+ODE14X_LU_SLOTS)*msize +
+                                   ODE14X_LU_SLOTS*nx*sizeof(int32_T));
+      if(id->DFDX == NULL) {
+          return(0);
+      }
+      id->W       = id->DFDX    + nx * nx;
+      id->pivots  = (int32_T *) (id->W + ODE14X_LU_SLOTS * nx * nx);
+      return(1);
+  }
+
   void rt_ODECreateIntegrationData(RTWSolverInfo *si)
   {
       int_T nx    = rtsiGetNumContStates(si);
       int_T vsize = nx * sizeof(real_T);
-      int_T msize = nx * vsize;
-      int_T size  = (6+MAXORDER)*vsize + 2*msize + nx*sizeof(int_T); 
+      int_T size  = (6+MAXORDER)*vsize;
+      const int_T *patternJc = rtsiGetSolverJacobianPatternJc(si);
+      int_T i;
 
       IntgData *id = (IntgData *) malloc(sizeof(IntgData));
       if(id == NULL) {
@@ -102,9 +877,28 @@ typedef struct IntgData_tag {
       id->Delta   = id->f1      + nx;
       id->E       = id->Delta   + nx;
       id->fac     = id->E       + MAXORDER * nx;
-      id->DFDX    = id->fac     + nx;
-      id->W       = id->DFDX    + nx * nx;
-      id->pivots  = (int32_T *) (id->W + nx * nx);
+      id->DFDX    = NULL;
+      id->W       = NULL;
+      id->pivots  = NULL;
+      id->sparse  = NULL;
+      id->jacAge  = 0;
+      for (i = 0; i < ODE14X_LU_SLOTS; i++) {
+          id->luH[i] = 0.0;
+      }
+
+      if (nx > 0 && (patternJc != NULL ||
+                     (ODE14X_SPARSE_MIN_STATES > 0 &&
+                      nx >= ODE14X_SPARSE_MIN_STATES))) {
+          id->sparse = local_sparse_create(nx, patternJc,
+                                           rtsiGetSolverJacobianPatternIr(si));
+          if(id->sparse == NULL) {
+              rtsiSetErrorStatus(si, RT_MEMORY_ALLOCATION_ERROR);
+              return;
+          }
+      } else if (!local_alloc_dense(id, nx)) {
+          rtsiSetErrorStatus(si, RT_MEMORY_ALLOCATION_ERROR);
+          return;
+      }
 
       { /* Initialize */
 	  real_T SQRT_EPS = 1.5e-8;   /* sqrt(utGetEps()); */
@@ -126,10 +920,58 @@ typedef struct IntgData_tag {
           if (id->x0 != NULL) {
               free(id->x0);
           }
+          if (id->DFDX != NULL) {
+              free(id->DFDX);
+          }
+          if (id->sparse != NULL) {
+              local_sparse_destroy(id->sparse);
+          }
           free(id);
           rtsiSetSolverData(si, NULL);
       }
   }
+
+  /* Sparse Jacobian: detection steps, then grouped differences.  Once
+     detection ends, a pattern that is too dense to pay off is handed back
+     to the dense solver. */
+  static boolean_T local_sparse_jacobian(RTWSolverInfo *si,
+                                         IntgData      *id,
+                                         real_T        *y,
+                                         const real_T  *Fty,
+                                         real_T        *fac)
+  {
+      SparseJac *sj = id->sparse;
+      int_T     nx  = sj->nx;
+      int_T     j, p;
+
+      if (sj->detectSteps == 0) {
+          local_sparse_numjac(si, sj, y, Fty, fac);
+          return(1);
+      }
+
+      if (!local_sparse_detect(si, sj, y, Fty, fac)) goto NOMEM;
+      if (--sj->detectSteps > 0) return(1);
+
+      if ((real_T)sj->Jc[nx] >
+          ODE14X_SPARSE_MAX_DENSITY * (real_T)nx * (real_T)nx) {
+          if (!local_alloc_dense(id, nx)) goto NOMEM;
+          (void)memset(id->DFDX, 0, nx*nx*sizeof(real_T));
+          for (j = 0; j < nx; j++) {
+              for (p = sj->Jc[j]; p < sj->Jc[j+1]; p++) {
+                  id->DFDX[sj->Ir[p] + j*nx] = sj->Jx[p];
+              }
+          }
+          local_sparse_destroy(sj);
+          id->sparse = NULL;
+          return(1);
+      }
+      if (!local_sparse_group(sj)) goto NOMEM;
+      return(1);
+
+    NOMEM:
+      rtsiSetErrorStatus(si, RT_MEMORY_ALLOCATION_ERROR);
+      return(0);
+  }
 #endif
 
 
@@ -141,12 +983,10 @@ void local_numjac(RTWSolverInfo   *si,
 		  real_T          *dFdy)
 {
     /* constants */
-    real_T THRESH = 1e-6;
     real_T EPS    = 2.2e-16;  /* utGetEps(); */
     real_T BL     = pow(EPS, 0.75);
     real_T BU     = pow(EPS, 0.25);
     real_T FACMIN = pow(EPS, 0.78);
-    real_T FACMAX = 0.1;
 
 #ifdef NCSTATES
     int_T     nx = NCSTATES;
@@ -161,8 +1001,6 @@ void local_numjac(RTWSolverInfo   *si,
     real_T    temp;
     real_T    Fdiff;
     real_T    maybe;
-    real_T    xscale;
-    real_T    fscale;
     real_T    *p;
     int_T     rowmax;
     int_T     i,j;
@@ -171,27 +1009,7 @@ void local_numjac(RTWSolverInfo   *si,
 
     for (p = dFdy, j = 0; j < nx; j++, p += nx) {
 
-        /* Select an increment del for a difference approximation to
-           column j of dFdy.  The vector fac accounts for experience
-           gained in previous calls to numjac. */
-        xscale = fabs(x[j]);
-        if (xscale < THRESH) xscale = THRESH;
-	temp = (x[j] + fac[j]*xscale); 
-        del  = temp  - y[j];
-        while (del == 0.0) {
-            if (fac[j] < FACMAX) {
-                fac[j] *= 100.0;
-                if (fac[j] > FACMAX) fac[j] = FACMAX;
-		temp = (x[j] + fac[j]*xscale); 
-                del  = temp  - x[j];
-            } else {
-                del = THRESH; /* thresh is nonzero */
-                break;
-            }
-        }
-        /* Keep del pointing into region. */
-        if (Fty[j] >= 0.0) del = fabs(del);
-        else del = -fabs(del);
+        del = local_numjac_del(x,y,Fty,fac,j);
 
         /* Form a difference approximation to column j of dFdy. */
         temp = x[j];
@@ -218,25 +1036,53 @@ void local_numjac(RTWSolverInfo   *si,
         }
 
         /* Adjust fac for next call to numjac. */
-        if (((FdelRowmax != 0.0) && (Fty[rowmax] != 0.0)) || (difmax == 0.0)) {
-            fscale = fabs(FdelRowmax);
-            if (fscale < fabs(Fty[rowmax])) fscale = fabs(Fty[rowmax]);
+        local_numjac_fac(fac,j,difmax,FdelRowmax,Fty[rowmax],BL,BU,FACMIN);
+    }
 
-	    if (difmax <= BL*fscale) {
-                /* The difference is small, so increase the increment. */
-                fac[j] *= 10.0;
-                if (fac[j] > FACMAX) fac[j] = FACMAX;
+} /* end local_numjac */
 
-            } else if (difmax > BU*fscale) {
-                /* The difference is large, so reduce the increment. */
-                fac[j] *= 0.1;
-                if (fac[j] < FACMIN) fac[j] = FACMIN;
 
-            }
-        }
+/* Delta = (U \ (L \ Delta)) with the factors in LU slot, using tmp as
+   temporary storage */
+static void local_solve(IntgData *id,
+                        int_T    slot,
+                        real_T   *Delta,
+                        real_T   *tmp,
+                        int_T    nx)
+{
+    real_T  *W;
+
+#ifdef RT_MALLOC
+    if (id->sparse != NULL) {
+        local_sparse_solve(id->sparse, &id->sparse->lu[slot], Delta);
+        return;
     }
+#endif
+    /* Modeled after rt_matdivrr_dbl.c */
+    W = id->W + slot*nx*nx;
+    rt_ForwardSubstitutionRR_Dbl(W,Delta,tmp,nx,1,id->pivots+slot*nx,1);
+    rt_BackwardSubstitutionRR_Dbl(W+nx*nx-1,tmp+nx-1,Delta,nx,1,0);
+
+} /* end local_solve */
 
-} /* end local_numjac */
+
+/* Largest magnitude of a Newton correction */
+static real_T local_norm(const real_T *v,
+                         int_T        nx)
+{
+    real_T norm = 0.0;
+    int_T  i;
+    for (i = 0; i < nx; i++) {
+        if (fabs(v[i]) > norm) norm = fabs(v[i]);
+    }
+    return(norm);
+
+} /* end local_norm */
+
+
+/* Count a solver event in RTWSolverInfo */
+#define ODE14X_COUNT(si,what) \
+    rtsiSetSolverNum##what(si, rtsiGetSolverNum##what(si) + 1U)
 
 
 void rt_ODEUpdateContinuousStates(RTWSolverInfo *si)
@@ -256,11 +1102,9 @@ void rt_ODEUpdateContinuousStates(RTWSolverInfo *si)
     real_T    *Delta     = id->Delta;
     real_T    *E         = id->E;
     real_T    *fac       = id->fac;
-    real_T    *dfdx      = id->DFDX;
-    real_T    *W         = id->W;
-    int_T     *pivots    = id->pivots;
     int_T     *N         = &(rt_ODE14x_N[0]); 
     int_T     i,j,k,iter;
+    real_T    norm, prevNorm;
 
 #ifdef NCSTATES
     int_T     nx        = NCSTATES;
@@ -278,28 +1122,63 @@ void rt_ODEUpdateContinuousStates(RTWSolverInfo *si)
     rtsiSetdX(si, f0);
     DERIVATIVES(si);
 
-    /* Compute the Jacobian */
-    local_numjac(si,x0,f0,fac,dfdx);
+    /* Compute the Jacobian, unless the previous one is young enough and
+       Newton converged well with it */
+#ifdef RT_MALLOC
+    if (id->sparse != NULL && id->sparse->detectSteps > 0) id->jacAge = 0;
+#endif
+    if (id->jacAge == 0 || id->jacAge >= ODE14X_JACOBIAN_MAX_AGE) {
+#ifdef RT_MALLOC
+        if (id->sparse != NULL) {
+            if (!local_sparse_jacobian(si,id,x0,f0,fac)) return;
+        } else
+#endif
+        {
+            local_numjac(si,x0,f0,fac,id->DFDX);
+        }
+        ODE14X_COUNT(si,JacobianEvaluations);
+        id->jacAge = 1;
+        for (i = 0; i < ODE14X_LU_SLOTS; i++) id->luH[i] = 0.0;
+    } else {
+        id->jacAge++;
+    }
 
     for (j = 0; j < order; j++) {
 	
 	real_T *p;
 	real_T hN = h / N[j];
+	int_T  slot = (ODE14X_LU_SLOTS > 1) ? j : 0;
 	
 	/* Get the iteration matrix and solution at t0 */
 
 	/* [L,U] = lu(I - hN*J) */
-        (void) memcpy(W, dfdx, nx*nx*sizeof(real_T));
-        for (p = W, i = 0; i < nx*nx; i++, p++) *p *= (-hN);
-        for (p = W, i = 0; i < nx; i++, p += (nx+1)) *p += 1.0;
-	rt_lu_real(W,nx,pivots);
+        if (id->luH[slot] != hN) {
+#ifdef RT_MALLOC
+            if (id->sparse != NULL) {
+                if (!local_sparse_lu(id->sparse,&id->sparse->lu[slot],hN)) {
+                    rtsiSetErrorStatus(si, RT_MEMORY_ALLOCATION_ERROR);
+                    return;
+                }
+            } else
+#endif
+            {
+                real_T *W = id->W + slot*nx*nx;
+                (void) memcpy(W, id->DFDX, nx*nx*sizeof(real_T));
+                for (p = W, i = 0; i < nx*nx; i++, p++) *p *= (-hN);
+                for (p = W, i = 0; i < nx; i++, p += (nx+1)) *p += 1.0;
+                rt_lu_real(W,nx,id->pivots+slot*nx);
+            }
+            ODE14X_COUNT(si,Factorizations);
+            id->luH[slot] = hN;
+        }
 
 	/* First Newton's iteration at t0. */
 	/* rhs = hN*f0  */
 	for (i = 0; i < nx; i++) Delta[i] = hN*f0[i];
 	/* Delta = (U \ (L \ rhs)) */
-	rt_ForwardSubstitutionRR_Dbl(W,Delta,f1,nx,1,pivots,1);
-	rt_BackwardSubstitutionRR_Dbl(W+nx*nx-1,f1+nx-1,Delta,nx,1,0);
+	local_solve(id,slot,Delta,f1,nx);
+	ODE14X_COUNT(si,NewtonIterations);
+	prevNorm = local_norm(Delta,nx);
 	/* ytmp = y0 + Delta */ 
 	(void)memcpy(x1, x0, nx*sizeof(real_T));
 	for (i = 0; i < nx; i++) x1[i] += Delta[i];
@@ -320,8 +1199,13 @@ void rt_ODEUpdateContinuousStates(RTWSolverInfo *si)
 
 	    for (i = 0; i < nx; i++) Delta[i] = (x0[i]-x1[i]) + hN*f1[i];
 
-	    rt_ForwardSubstitutionRR_Dbl(W,Delta,f1,nx,1,pivots,1);
-	    rt_BackwardSubstitutionRR_Dbl(W+nx*nx-1,f1+nx-1,Delta,nx,1,0);
+	    local_solve(id,slot,Delta,f1,nx);
+	    ODE14X_COUNT(si,NewtonIterations);
+
+	    /* Slow contraction: evaluate the Jacobian on the next step */
+	    norm = local_norm(Delta,nx);
+	    if (norm > ODE14X_NEWTON_MAX_RATE*prevNorm) id->jacAge = 0;
+	    prevNorm = norm;
 
 	    for (i = 0; i < nx; i++) x1[i] += Delta[i];
 	}
@@ -354,9 +1238,15 @@ void rt_ODEUpdateContinuousStates(RTWSolverInfo *si)
 		    for (i = 0; i < nx; i++) Delta[i] = (x1start[i]-x1[i]) + hN*f1[i];
 		}
 
-		/* Modeled after rt_matdivrr_dbl.c, use f1 as a temp storage */
-		rt_ForwardSubstitutionRR_Dbl(W,Delta,f1,nx,1,pivots,1);
-		rt_BackwardSubstitutionRR_Dbl(W+nx*nx-1,f1+nx-1,Delta,nx,1,0);
+		/* Use f1 as a temp storage */
+		local_solve(id,slot,Delta,f1,nx);
+		ODE14X_COUNT(si,NewtonIterations);
+
+		norm = local_norm(Delta,nx);
+		if (iter > 0 && norm > ODE14X_NEWTON_MAX_RATE*prevNorm) {
+		    id->jacAge = 0;
+		}
+		prevNorm = norm;
 
 		for (i = 0; i < nx; i++) x1[i] += Delta[i];
 	    }   
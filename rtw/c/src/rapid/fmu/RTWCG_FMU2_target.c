@@ -101,6 +101,154 @@ static fmi2Boolean CheckStatus(struct FMU2_CS_RTWCG * fmustruct, fmi2Status stat
     else
         return fmi2False;
 }
+/*
+  Value reference lists: the generated code registers, once after
+  FMU2_fmuInitialize, the value reference and the signal address of every
+  input or output of a type. Each step then exchanges the whole list with a
+  single fmi2Set / fmi2Get call. The addresses must hold the FMI type
+  (fmi2Real, fmi2Integer, fmi2Boolean); when they are consecutive the values
+  are exchanged in place, otherwise through the staging buffer.
+*/
+static size_t VRListValueSize(FMU2_VRListType type){
+    switch(type){
+      case FMU2_REAL_INPUT:
+      case FMU2_REAL_OUTPUT:
+        return sizeof(fmi2Real);
+      case FMU2_INTEGER_INPUT:
+      case FMU2_INTEGER_OUTPUT:
+        return sizeof(fmi2Integer);
+      default:
+        return sizeof(fmi2Boolean);
+    }
+}
+
+fmi2Status FMU2_createVRList(void** fmuv, FMU2_VRListType type, size_t nvr){
+    struct FMU2_CS_RTWCG * fmustruct = (struct FMU2_CS_RTWCG *)(*fmuv);
+    struct FMU2_VRList * list = &fmustruct->vrList[type];
+    free(list->vr);
+    free(list->addr);
+    free(list->values);
+    memset(list, 0, sizeof(*list));
+    if(nvr == 0)
+        return fmi2True;
+    list->vr = (fmi2ValueReference *)calloc(nvr, sizeof(fmi2ValueReference));
+    list->addr = (void **)calloc(nvr, sizeof(void *));
+    list->values = calloc(nvr, VRListValueSize(type));
+    if(list->vr == NULL || list->addr == NULL || list->values == NULL){
+        /*leave an empty list, which FMU2_setVRList and FMU2_getVRList skip*/
+        free(list->vr);
+        free(list->addr);
+        free(list->values);
+        memset(list, 0, sizeof(*list));
+        return CheckStatus(fmustruct, fmi2Error, "FMU2_createVRList");
+    }
+    list->nvr = nvr;
+    return fmi2True;
+}
+
+int FMU2_setVRListEntry(void** fmuv, FMU2_VRListType type, size_t idx, fmi2ValueReference vr, void* addr){
+    struct FMU2_CS_RTWCG * fmustruct = (struct FMU2_CS_RTWCG *)(*fmuv);
+    struct FMU2_VRList * list = &fmustruct->vrList[type];
+    if(idx >= list->nvr)
+        return 1;
+    list->vr[idx] = vr;
+    list->addr[idx] = addr;
+    list->isChecked = 0;
+    return 0;
+}
+
+void FMU2_freeVRLists(void** fmuv){
+    struct FMU2_CS_RTWCG * fmustruct = (struct FMU2_CS_RTWCG *)(*fmuv);
+    int type;
+    for(type = 0; type < FMU2_NUM_VR_LISTS; type++){
+        struct FMU2_VRList * list = &fmustruct->vrList[type];
+        free(list->vr);
+        free(list->addr);
+        free(list->values);
+        memset(list, 0, sizeof(*list));
+    }
+}
+
+/*buffer the values of a list are exchanged through*/
+static void * VRListBuffer(struct FMU2_VRList * list, size_t size){
+    if(!list->isChecked){
+        size_t i;
+        list->isContiguous = 1;
+        for(i = 1; i < list->nvr && list->isContiguous; i++){
+            list->isContiguous = ((char *)list->addr[i] == (char *)list->addr[0] + i*size);
+        }
+        list->isChecked = 1;
+    }
+    return list->isContiguous ? list->addr[0] : list->values;
+}
+
+fmi2Status FMU2_setVRList(void** fmuv, FMU2_VRListType type){
+    struct FMU2_CS_RTWCG * fmustruct = (struct FMU2_CS_RTWCG *)(*fmuv);
+    struct FMU2_VRList * list = &fmustruct->vrList[type];
+    size_t size = VRListValueSize(type);
+    void * buffer;
+    fmi2Status fmi2Flag;
+    size_t i;
+
+    if(list->nvr == 0)
+        return fmi2True;
+    buffer = VRListBuffer(list, size);
+    if(buffer == list->values){
+        for(i = 0; i < list->nvr; i++){
+            memcpy((char *)list->values + i*size, list->addr[i], size);
+        }
+    }
+    switch(type){
+      case FMU2_REAL_INPUT:
+        fmi2Flag = fmustruct->setReal(fmustruct->mFMIComp, list->vr, list->nvr, (const fmi2Real *)buffer);
+        return CheckStatus(fmustruct, fmi2Flag, "fmi2SetReal");
+      case FMU2_INTEGER_INPUT:
+        fmi2Flag = fmustruct->setInteger(fmustruct->mFMIComp, list->vr, list->nvr, (const fmi2Integer *)buffer);
+        return CheckStatus(fmustruct, fmi2Flag, "fmi2SetInteger");
+      case FMU2_BOOLEAN_INPUT:
+        fmi2Flag = fmustruct->setBoolean(fmustruct->mFMIComp, list->vr, list->nvr, (const fmi2Boolean *)buffer);
+        return CheckStatus(fmustruct, fmi2Flag, "fmi2SetBoolean");
+      default:
+        return CheckStatus(fmustruct, fmi2Error, "fmi2SetValueReferenceList");
+    }
+}
+
+fmi2Status FMU2_getVRList(void** fmuv, FMU2_VRListType type){
+    struct FMU2_CS_RTWCG * fmustruct = (struct FMU2_CS_RTWCG *)(*fmuv);
+    struct FMU2_VRList * list = &fmustruct->vrList[type];
+    size_t size = VRListValueSize(type);
+    void * buffer;
+    fmi2Status fmi2Flag;
+    fmi2String fcnName;
+    size_t i;
+
+    if(list->nvr == 0)
+        return fmi2True;
+    buffer = VRListBuffer(list, size);
+    switch(type){
+      case FMU2_REAL_OUTPUT:
+        fmi2Flag = fmustruct->getReal(fmustruct->mFMIComp, list->vr, list->nvr, (fmi2Real *)buffer);
+        fcnName = "fmi2GetReal";
+        break;
+      case FMU2_INTEGER_OUTPUT:
+        fmi2Flag = fmustruct->getInteger(fmustruct->mFMIComp, list->vr, list->nvr, (fmi2Integer *)buffer);
+        fcnName = "fmi2GetInteger";
+        break;
+      case FMU2_BOOLEAN_OUTPUT:
+        fmi2Flag = fmustruct->getBoolean(fmustruct->mFMIComp, list->vr, list->nvr, (fmi2Boolean *)buffer);
+        fcnName = "fmi2GetBoolean";
+        break;
+      default:
+        return CheckStatus(fmustruct, fmi2Error, "fmi2GetValueReferenceList");
+    }
+    if((fmi2Flag == fmi2OK || fmi2Flag == fmi2Warning) && buffer == list->values){
+        for(i = 0; i < list->nvr; i++){
+            memcpy(list->addr[i], (char *)list->values + i*size, size);
+        }
+    }
+    return CheckStatus(fmustruct, fmi2Flag, fcnName);
+}
+
 /*This function is required by FMI2 standard
   FMU logger is currently not enabled, so it will not be called
   reportasInfo API is currently not avaiable for Rapid accelerator
@@ -273,6 +421,7 @@ fmi2Boolean FMU2_terminate(void **fmuv){
     CLOSE_LIBRARY(fmustruct->Handle);
     free(fmustruct->paramIdxToOffset);
     free(fmustruct->enumValueList);
+    FMU2_freeVRLists(fmuv);
     free(fmustruct);
     return fmi2True;
 }
@@ -67,6 +67,26 @@
 #define RTWCG_FMU2_GUARD
 typedef fmi2Status (*_fmi2_default_fcn_type) (fmi2Component, ...);
 
+/*value reference lists exchanged with one fmi2Get/fmi2Set call per step*/
+typedef enum {
+    FMU2_REAL_INPUT,
+    FMU2_REAL_OUTPUT,
+    FMU2_INTEGER_INPUT,
+    FMU2_INTEGER_OUTPUT,
+    FMU2_BOOLEAN_INPUT,
+    FMU2_BOOLEAN_OUTPUT,
+    FMU2_NUM_VR_LISTS
+} FMU2_VRListType;
+
+struct FMU2_VRList {
+    size_t nvr;
+    fmi2ValueReference * vr;
+    void ** addr;          /*storage of the FMI type read from / written to per vr*/
+    void * values;         /*staging buffer of nvr values*/
+    int isContiguous;      /*addr[i] == addr[0] + i, values are exchanged in place*/
+    int isChecked;         /*isContiguous is up to date*/
+};
+
 struct FMU2_CS_RTWCG {
     /*common functions*/
     fmi2GetTypesPlatformTYPE* getTypesPlatform;
@@ -132,6 +152,8 @@ struct FMU2_CS_RTWCG {
     /*two int arrays for maping enum param original value to actual value*/
     int * paramIdxToOffset;
     int * enumValueList;
+
+    struct FMU2_VRList vrList[FMU2_NUM_VR_LISTS];
 };
 
 void fmu2Logger(fmi2Component c, fmi2String instanceName, fmi2Status status,
@@ -169,6 +191,19 @@ void LoadFMU2CommonFunctions(struct FMU2_CS_RTWCG* fmustruct);
 void LoadFMU2CSFunctions(struct FMU2_CS_RTWCG* fmustruct);
 void LoadFMU2MEFunctions(struct FMU2_CS_RTWCG* fmustruct);
 
+/*helpers to exchange all values of a type with one call per step.
+  They are entry points for the generated FMU block code, which is not
+  part of this tree; until it calls them, the per-reference FMU2_getReal,
+  FMU2_setReal, ... functions remain the path in use.
+  FMU2_createVRList reports an allocation failure through the simulation
+  error status and leaves the list empty; FMU2_setVRListEntry returns
+  non-zero for an index outside the list*/
+fmi2Status FMU2_createVRList(void** fmuv, FMU2_VRListType type, size_t nvr);
+int FMU2_setVRListEntry(void** fmuv, FMU2_VRListType type, size_t idx, fmi2ValueReference vr, void* addr);
+fmi2Status FMU2_setVRList(void** fmuv, FMU2_VRListType type);
+fmi2Status FMU2_getVRList(void** fmuv, FMU2_VRListType type);
+void FMU2_freeVRLists(void** fmuv);
+
 /*helper to preprocess Enum type*/
 void createParamIdxToOffset(void** fmuv, int array_size);
 void createEnumValueList(void** fmuv, int array_size);
@@ -10,6 +10,26 @@
  *      major time step and finally written to a MAT-file at the end of the
  *      simulation.
  *
+ *      If LOGGING_STREAM_BUFFER_SIZE is defined to a positive number of rows,
+ *      log variables whose buffers would otherwise grow during the simulation
+ *      are instead flushed to a spill file each time that many rows have been
+ *      logged.  All log variables share one temporary spill file (tmpfile),
+ *      which is streamed into the MAT-file at the end of the simulation.
+ *      This bounds the memory used for logging by the chunk size rather than
+ *      by the length of the simulation.  With MULTITASKING, where rates may
+ *      log concurrently, each streamed log variable gets a spill file of its
+ *      own instead.
+ *
+ *      If LOGGING_ASYNC_BUFFER_SIZE is defined to a power of two number of
+ *      bytes, rt_UpdateLogVar only copies the signal data into a ring buffer
+ *      of that size and a low priority logging thread, created with the
+ *      rtw_linux.c task helpers, does the conversion, decimation and file
+ *      writes.  When the ring buffer is too full to hold another time step
+ *      the model step waits for the logging thread, unless
+ *      LOGGING_ASYNC_DROP is defined, in which case the samples of that step
+ *      are dropped and counted instead.  The ring has a single producer, so
+ *      it cannot be combined with MULTITASKING.
+ *
  *      This file handles redefining the following standard MathWorks types
  *      (see tmwtypes.h):
  *         [u]int8_T     to be int32_T (logged as Matlab [u]int32)
@@ -65,6 +85,49 @@
 #define DEFAULT_BUFFER_SIZE      1024  /* used if maxRows=0 and Tfinal=0.0    */
 #endif
 
+#ifndef LOGGING_ARENA_BLOCK_SIZE
+#define LOGGING_ARENA_BLOCK_SIZE (1024*1024) /* bytes per logging arena block */
+#endif
+
+#define LOG_ARENA_ALIGN(n)     ( ( ((size_t)(n))+15 ) & (~((size_t)15)) )
+
+/*
+ * With MULTITASKING (MT) the rates of the model may log from concurrent
+ * threads, e.g. the subrate threads of rt_main.c with MT_PTHREADS.  The
+ * logging arena and the spill file are not locked, so they are only shared
+ * in single-tasking models; with concurrent rates each log variable grows
+ * its own buffers and spills to its own file.
+ */
+#if defined(MULTITASKING) || (defined(MT) && MT != 0) || \
+    (defined(MT_PTHREADS) && MT_PTHREADS != 0)
+#define LOG_CONCURRENT_RATES 1
+#else
+#define LOG_CONCURRENT_RATES 0
+#endif
+
+#ifndef LOGGING_STREAM_BUFFER_SIZE
+#define LOGGING_STREAM_BUFFER_SIZE  0  /* rows per spilled chunk, 0 => off    */
+#endif
+
+#if LOGGING_STREAM_BUFFER_SIZE > 0 && LOGGING_STREAM_BUFFER_SIZE < 8
+#error "LOGGING_STREAM_BUFFER_SIZE must be 0 or at least 8 rows"
+#endif
+
+#ifndef LOGGING_ASYNC_BUFFER_SIZE
+#define LOGGING_ASYNC_BUFFER_SIZE   0  /* bytes in the async ring, 0 => off  */
+#endif
+
+#if LOGGING_ASYNC_BUFFER_SIZE > 0
+#if LOGGING_ASYNC_BUFFER_SIZE < 4096 || \
+    (LOGGING_ASYNC_BUFFER_SIZE & (LOGGING_ASYNC_BUFFER_SIZE-1)) != 0
+#error "LOGGING_ASYNC_BUFFER_SIZE must be 0 or a power of 2 of at least 4096"
+#endif
+#if LOG_CONCURRENT_RATES
+#error "LOGGING_ASYNC_BUFFER_SIZE must be 0 with MULTITASKING (single producer)"
+#endif
+#include "rtw_linux.h"
+#endif
+
 #define FREE(m) if (m != NULL) free(m)
 
 /* Logical definitions */
@@ -81,6 +144,50 @@
  * typedefs *
  *==========*/
 
+typedef struct LogArenaBlock_Tag LogArenaBlock;
+
+struct LogArenaBlock_Tag {
+    LogArenaBlock *next;               /* Next block in the arena             */
+    size_t        size;                /* Usable bytes in this block          */
+    size_t        used;                /* Bytes handed out so far             */
+};
+
+struct LogArena_Tag {
+    LogArenaBlock *blocks;             /* Most recently allocated block first */
+};
+
+typedef struct LogSpill_Tag {
+    FILE          *fp;                 /* Temporary file, opened at first use */
+} LogSpill;
+
+struct LogSegment_Tag {
+    void          *re;                 /* Rows of the real part               */
+    void          *im;                 /* Rows of the imaginary part          */
+    real_T        *dimsData;           /* valueDimensions of these rows       */
+    int_T         nRows;               /* Number of rows in the segment       */
+    boolean_T     fromHeap;            /* Buffers from malloc (not the arena)?*/
+    LogSegment    *next;
+};
+
+#if LOGGING_ASYNC_BUFFER_SIZE > 0
+struct LogAsyncQueue_Tag {
+    char_T        *buf;                /* Ring buffer of queued records       */
+    size_t        head;                /* Bytes produced by the model step    */
+    size_t        tail;                /* Bytes consumed by the logging thread*/
+    int           stop;                /* Set when the thread should finish   */
+    size_t        pending;             /* Bytes reserved but not yet produced */
+    int_T         step;                /* LOG_ASYNC_STEP_* of the time step   */
+    size_t        stepBytes;           /* Bytes queued in this time step      */
+    size_t        maxStepBytes;        /* Most bytes queued in one time step  */
+    void          *task;               /* Logging thread, NULL if not running */
+    unsigned long nRecords;
+    unsigned long nStalls;
+    unsigned long nSteps;
+    unsigned long nDroppedSteps;
+    size_t        maxUsed;
+};
+#endif
+
 typedef struct LogInfo_Tag {
     LogVar       *t;                   /* Time log variable                   */
     void         *x;                   /* State log variable                  */
@@ -92,8 +199,28 @@ typedef struct LogInfo_Tag {
     StructLogVar *structLogVarsList;   /* Linked list of all StructLogVars    */
 
     boolean_T   haveLogVars;           /* Are logging one or more vars?       */
+
+    LogArena    arena;                 /* Segments of growing log variables   */
+    LogSpill    spill;                 /* Spill file of streamed variables    */
+#if LOGGING_ASYNC_BUFFER_SIZE > 0
+    LogAsyncQueue async;               /* Queue of the logging thread         */
+#endif
 } LogInfo;
 
+struct LogStream_Tag {
+    LogSpill  *spill;                  /* Spill file shared by the LogInfo    */
+#if LOG_CONCURRENT_RATES
+    LogSpill  ownSpill;                /* Spill file used instead of it       */
+#endif
+    int_T     chunkRows;               /* Rows in each flushed chunk          */
+    int_T     nRowsFlushed;            /* Total rows written to the file      */
+    int_T     nChunks;                 /* Number of chunks in the file        */
+    int_T     maxChunks;               /* Capacity of chunkPos                */
+    fpos_t    *chunkPos;               /* File position of each chunk         */
+    boolean_T transposed;              /* Chunks stored column-major?         */
+    char_T    *scratch;                /* One chunk worth of transfer memory  */
+};
+
 typedef struct MatItem_tag {
   int32_T    type;
   uint32_T    nbytes;
@@ -601,6 +728,291 @@ static int_T rt_GetMatIdFromMxId(mxClassID mxID)
 } /* end rt_GetMatIdFromMxId */
 
 
+/* Function: rt_DestroyLogSpill ================================================
+ * Abstract:
+ *      Close the spill file, which removes it.
+ */
+static void rt_DestroyLogSpill(LogSpill *spill)
+{
+    if (spill->fp != NULL) {
+        (void)fclose(spill->fp);
+        spill->fp = NULL;
+    }
+
+} /* end rt_DestroyLogSpill */
+
+
+/* Function: rt_CreateLogStream ===============================================
+ * Abstract:
+ *      Create the book keeping structure used to spill the rows of a log
+ *      variable to the spill file of the LogInfo, or to its own spill file
+ *      with concurrent rates, which would otherwise interleave their seeks
+ *      and writes.  The file itself is only created when the first chunk is
+ *      flushed, so short simulations never touch the disk.
+ *
+ * Returns:
+ *	~= NULL  => success
+ *	== NULL  => failure
+ */
+static LogStream *rt_CreateLogStream(LogSpill  *spill,
+                                     int_T     chunkRows,
+                                     boolean_T transposed)
+{
+    LogStream *stream = calloc(1, sizeof(LogStream));
+
+    if (stream != NULL) {
+#if LOG_CONCURRENT_RATES
+        (void)spill;
+        stream->ownSpill.fp  = NULL;
+        stream->spill        = &stream->ownSpill;
+#else
+        stream->spill        = spill;
+#endif
+        stream->chunkRows    = chunkRows;
+        stream->nRowsFlushed = 0;
+        stream->nChunks      = 0;
+        stream->maxChunks    = 0;
+        stream->chunkPos     = NULL;
+        stream->transposed   = transposed;
+        stream->scratch      = NULL;
+    }
+    return(stream);
+
+} /* end rt_CreateLogStream */
+
+
+/* Function: rt_DestroyLogStream ===============================================
+ * Abstract:
+ *      Free the stream.  Its chunks stay in the spill file until the LogInfo
+ *      is destroyed, unless the stream has a spill file of its own.
+ */
+static void rt_DestroyLogStream(LogStream *stream)
+{
+#if LOG_CONCURRENT_RATES
+    rt_DestroyLogSpill(&stream->ownSpill);
+#endif
+    FREE(stream->chunkPos);
+    FREE(stream->scratch);
+    FREE(stream);
+
+} /* end rt_DestroyLogStream */
+
+
+/* Function: rt_FlushLogVarChunk ===============================================
+ * Abstract:
+ *      Append the rows currently held in the buffers of the log variable to
+ *      the spill file and reset the buffers.  Chunks of different variables
+ *      are interleaved in the file, each stream records where its own are.  The real part of a chunk is
+ *      followed by its imaginary part.  Two dimensional logs that get
+ *      transposed for MATLAB are stored column-major within each chunk so
+ *      that every column can be copied into the MAT-file in large pieces.
+ *      Exit if the data cannot be written.
+ */
+static void rt_FlushLogVarChunk(LogVar *var)
+{
+    LogStream *stream = var->data.stream;
+    LogSpill  *spill  = stream->spill;
+    int_T     nRows   = var->rowIdx;
+    int_T     nCols   = var->data.nCols;
+    size_t    elSize  = var->data.elSize;
+    size_t    nBytes  = nRows*nCols*elSize;
+    int_T     nParts  = var->data.complex ? 2 : 1;
+    int_T     part;
+
+    if (nRows == 0) return;
+
+    if (spill->fp == NULL) {
+        if ((spill->fp = tmpfile()) == NULL) {
+            (void)fprintf(stderr, "*** Error creating the temporary file\n");
+            goto ERROR_EXIT;
+        }
+    }
+    if (stream->scratch == NULL) {
+        stream->scratch = malloc(stream->chunkRows*nCols*elSize);
+        if (stream->scratch == NULL) goto ALLOC_ERROR_EXIT;
+    }
+
+    if (stream->nChunks == stream->maxChunks) {
+        int_T  maxChunks = stream->maxChunks == 0 ? 64 : 2*stream->maxChunks;
+        fpos_t *tmp      = realloc(stream->chunkPos, maxChunks*sizeof(fpos_t));
+
+        if (tmp == NULL) goto ALLOC_ERROR_EXIT;
+        stream->chunkPos  = tmp;
+        stream->maxChunks = maxChunks;
+    }
+    /* Chunks of other variables may have been read back since the last
+     * write, append after all of them */
+    if (fseek(spill->fp, 0L, SEEK_END) ||
+        fgetpos(spill->fp, &stream->chunkPos[stream->nChunks])) {
+        goto ERROR_EXIT;
+    }
+
+    for (part = 0; part < nParts; part++) {
+        const char_T *src = part ? var->data.im : var->data.re;
+
+        if (stream->transposed) {
+            int_T k;
+            int_T nEl = nRows*nCols;
+
+            for (k = 0; k < nEl; k++) {
+                int_T kT = nRows*(k%nCols) + (k/nCols);
+                (void)memcpy(stream->scratch + kT*elSize, src + k*elSize,
+                             elSize);
+            }
+            src = stream->scratch;
+        }
+        if (fwrite(src, 1, nBytes, spill->fp) != nBytes) goto ERROR_EXIT;
+    }
+
+    ++stream->nChunks;
+    stream->nRowsFlushed += nRows;
+    var->rowIdx = 0;
+    return;
+
+  ALLOC_ERROR_EXIT:
+    (void)fprintf(stderr, "*** Memory allocation error.\n");
+  ERROR_EXIT:
+    (void)fprintf(stderr, ""
+                  "*** Error writing log variable %s to the spill file\n"
+                  "    nRows            = %d\n"
+                  "    nCols            = %d\n"
+                  "    elementSize      = %lu\n"
+                  "    Rows on file     = %d\n\n",
+                  var->data.name,
+                  nRows,
+                  nCols,
+                  (unsigned long) elSize,
+                  stream->nRowsFlushed);
+    exit(1);
+
+} /* end rt_FlushLogVarChunk */
+
+
+/* Function: rt_WriteStreamedItemToMatFile =====================================
+ * Abstract:
+ *      Write the real (part == 0) or imaginary (part == 1) data of a streamed
+ *      log variable to the mat file, reading it back one chunk (or one column
+ *      of a chunk) at a time from the spill file.  The item type and number of
+ *      bytes are taken from pItem.
+ *
+ *      Return values is
+ *          == 0 : upon success
+ *          <> 0 : upon failure
+ */
+static int_T rt_WriteStreamedItemToMatFile(FILE             *fp,
+                                           const MatItem    *pItem,
+                                           const MatrixData *var,
+                                           int_T            part)
+{
+    LogStream *stream     = var->stream;
+    FILE      *spillFp    = stream->spill->fp;
+    int_T     nRowsTotal  = stream->nRowsFlushed;
+    int_T     nCols       = var->nCols;
+    size_t    elSize      = var->elSize;
+    int_T     nColLoops   = stream->transposed ? nCols : 1;
+    int32_T   nAlignBytes;
+    int_T     c, j;
+
+    if (fwrite(pItem, 1, matTAG_SIZE, fp) != matTAG_SIZE) return(1);
+
+    for (j = 0; j < nColLoops; j++) {
+        for (c = 0; c < stream->nChunks; c++) {
+            int_T  nRows  = nRowsTotal - c*stream->chunkRows;
+            size_t nBytes;
+            long   offset;
+
+            if (nRows > stream->chunkRows) nRows = stream->chunkRows;
+
+            if (stream->transposed) {
+                offset = (long)((part*nRows*nCols + j*nRows)*elSize);
+                nBytes = nRows*elSize;
+            } else {
+                offset = (long)(part*nRows*nCols*elSize);
+                nBytes = nRows*nCols*elSize;
+            }
+            if (fsetpos(spillFp, &stream->chunkPos[c]) ||
+                fseek(spillFp, offset, SEEK_CUR) ||
+                fread(stream->scratch, 1, nBytes, spillFp) != nBytes ||
+                fwrite(stream->scratch, 1, nBytes, fp) != nBytes) {
+                return(1);
+            }
+        }
+    }
+
+    /* Add offset for 8-byte alignment */
+    nAlignBytes = matINT64_ALIGN(pItem->nbytes) - pItem->nbytes;
+    if (nAlignBytes > 0) {
+        int pad[2] = {0, 0};
+        if ( fwrite(pad,1,nAlignBytes,fp) != ((size_t) nAlignBytes) ) {
+            return(1);
+        }
+    }
+    return(0);
+
+} /* end rt_WriteStreamedItemToMatFile */
+
+
+/* Function: rt_LogArenaAlloc ==================================================
+ * Abstract:
+ *      Bump allocate nbytes from the logging arena.  Memory handed out by the
+ *      arena is never freed individually, it is all released at once by
+ *      rt_DestroyLogArena when logging stops.
+ *
+ * Returns:
+ *	~= NULL  => success
+ *	== NULL  => failure
+ */
+static void *rt_LogArenaAlloc(LogArena *arena, size_t nbytes)
+{
+    LogArenaBlock *block   = arena->blocks;
+    size_t        hdrBytes = LOG_ARENA_ALIGN(sizeof(LogArenaBlock));
+    void          *ptr;
+
+    nbytes = LOG_ARENA_ALIGN(nbytes);
+
+    if (block == NULL || block->size - block->used < nbytes) {
+        size_t size = (nbytes > LOGGING_ARENA_BLOCK_SIZE) ?
+            nbytes : LOG_ARENA_ALIGN(LOGGING_ARENA_BLOCK_SIZE);
+
+        if ((block = malloc(hdrBytes + size)) == NULL) return(NULL);
+        block->size = size;
+        block->used = 0;
+
+        /*
+         * Keep filling the current block if the new one was only created
+         * for a single large request.
+         */
+        if (arena->blocks != NULL && size == nbytes) {
+            block->next = arena->blocks->next;
+            arena->blocks->next = block;
+        } else {
+            block->next = arena->blocks;
+            arena->blocks = block;
+        }
+    }
+
+    ptr = ((char_T*)block) + hdrBytes + block->used;
+    block->used += nbytes;
+    return(ptr);
+
+} /* end rt_LogArenaAlloc */
+
+
+/* Function: rt_DestroyLogArena ================================================
+ * Abstract:
+ *      Free all the memory in the logging arena.
+ */
+static void rt_DestroyLogArena(LogArena *arena)
+{
+    while (arena->blocks != NULL) {
+        LogArenaBlock *block = arena->blocks;
+        arena->blocks = block->next;
+        free(block);
+    }
+
+} /* end rt_DestroyLogArena */
+
+
 /* Forward declaration */
 static int_T rt_WriteItemToMatFile(FILE         *fp,
                                    MatItem      *pItem,
@@ -744,7 +1156,12 @@ static int_T rt_ProcessMatItem(FILE         *fp,
         if (cmd) {
             item.type = matID;
             item.data = var->re;
-            if (rt_WriteItemToMatFile(fp, &item, DATA_ITEM)) {
+            if (var->stream != NULL) {
+                if (rt_WriteStreamedItemToMatFile(fp, &item, var, 0)) {
+                    retStat = 1;
+                    goto EXIT_POINT;
+                }
+            } else if (rt_WriteItemToMatFile(fp, &item, DATA_ITEM)) {
                 retStat = 1;
                 goto EXIT_POINT;
             }
@@ -758,7 +1175,12 @@ static int_T rt_ProcessMatItem(FILE         *fp,
             if (cmd) {
                 item.type = matID;
                 item.data = var->im;
-                if (rt_WriteItemToMatFile(fp, &item, DATA_ITEM)) {
+                if (var->stream != NULL) {
+                    if (rt_WriteStreamedItemToMatFile(fp, &item, var, 1)) {
+                        retStat = 1;
+                        goto EXIT_POINT;
+                    }
+                } else if (rt_WriteItemToMatFile(fp, &item, DATA_ITEM)) {
                     retStat = 1;
                     goto EXIT_POINT;
                 }
@@ -935,6 +1357,7 @@ static int_T rt_ProcessMatItem(FILE         *fp,
                       tempData.complex = 0;
                       tempData.frameData = 0;
                       tempData.frameSize = 1;
+                      tempData.stream = NULL;
 
                       item.type = matMATRIX;                    
                       item.data = &tempData; /*values->valDims;*/
@@ -1189,17 +1612,145 @@ static int_T rt_WriteMat5FileHeader(FILE *fp)
 } /* end rt_WriteMat5FileHeader */
 
 
+/* Function: rt_LinearizeLogVar ===============================================
+ * Abstract:
+ *	Join the filled segments and the rows in the current buffers of a
+ *	segmented log variable into a single buffer in the layout used by the
+ *	non-segmented log variables.  This is done once, when the data is
+ *	written to the MAT-file.
+ */
+static const char_T *rt_LinearizeLogVar(LogVar *var)
+{
+    int_T      nRows    = var->nSegmentRows + var->rowIdx;
+    size_t     rowBytes = var->data.nCols * var->data.elSize;
+    ValDimsData *valDims = (var->valDims != NULL &&
+                            var->valDims->dimsData != NULL) ? var->valDims : NULL;
+    int_T      nColsDims = (valDims != NULL) ? valDims->nCols : 0;
+    char_T     *re       = NULL;
+    char_T     *im       = NULL;
+    real_T     *dimsData = NULL;
+    LogSegment *seg;
+    int_T      rowOffset;
+    int_T      k;
+
+    if ((re = malloc(nRows*rowBytes)) == NULL) goto ERROR_EXIT;
+    if (var->data.complex && (im = malloc(nRows*rowBytes)) == NULL) {
+        goto ERROR_EXIT;
+    }
+    if (valDims != NULL &&
+        (dimsData = malloc(nRows*nColsDims*sizeof(real_T))) == NULL) {
+        goto ERROR_EXIT;
+    }
+
+    /* The rows of the data are contiguous in each segment */
+    for (seg = var->segments, rowOffset = 0; seg != NULL; seg = seg->next) {
+        (void)memcpy(re + rowOffset*rowBytes, seg->re, seg->nRows*rowBytes);
+        if (im != NULL) {
+            (void)memcpy(im + rowOffset*rowBytes, seg->im, seg->nRows*rowBytes);
+        }
+        rowOffset += seg->nRows;
+    }
+    (void)memcpy(re + rowOffset*rowBytes, var->data.re, var->rowIdx*rowBytes);
+    if (im != NULL) {
+        (void)memcpy(im + rowOffset*rowBytes, var->data.im,
+                     var->rowIdx*rowBytes);
+    }
+
+    /* valueDimensions are stored one column after another in each segment */
+    if (valDims != NULL) {
+        for (k = 0; k < nColsDims; k++) {
+            real_T *dst = dimsData + k*nRows;
+
+            for (seg = var->segments; seg != NULL; seg = seg->next) {
+                (void)memcpy(dst, seg->dimsData + k*seg->nRows,
+                             seg->nRows*sizeof(real_T));
+                dst += seg->nRows;
+            }
+            (void)memcpy(dst, valDims->dimsData + k*valDims->nRows,
+                         var->rowIdx*sizeof(real_T));
+        }
+    }
+
+    /* Release the heap owned buffers, the rest belongs to the arena */
+    for (seg = var->segments; seg != NULL; seg = seg->next) {
+        if (seg->fromHeap) {
+            FREE(seg->re);
+            FREE(seg->im);
+            FREE(seg->dimsData);
+        }
+    }
+    var->segments     = NULL;
+    var->lastSegment  = NULL;
+    var->nSegmentRows = 0;
+
+    var->data.re    = re;
+    var->data.im    = im;
+    var->data.nRows = nRows;
+    var->rowIdx     = nRows;
+    if (valDims != NULL) {
+        valDims->dimsData = dimsData;
+        valDims->nRows    = nRows;
+    } else if (var->valDims != NULL) {
+        /* An empty valueDimensions keeps the row count, as when reallocated */
+        var->valDims->nRows = nRows;
+    }
+    return(NULL);
+
+  ERROR_EXIT:
+    FREE(re);
+    FREE(im);
+    FREE(dimsData);
+    return("unable to allocate memory for the logged data\n");
+
+} /* end rt_LinearizeLogVar */
+
+
 /* Function: rt_FixupLogVar ====================================================
  * Abstract:
  *	Make the logged variable suitable for MATLAB.
  */
 static const char_T *rt_FixupLogVar(LogVar *var,int verbose)
 {
-    int_T  nCols   = var->data.nCols;
-    int_T  maxRows = var->data.nRows;
-    int_T  nDims   = var->data.nDims;
-    size_t elSize  = var->data.elSize;
-    int_T  nRows   = (var->wrapped ?  maxRows : var->rowIdx);
+    int_T  nCols;
+    int_T  maxRows;
+    int_T  nDims;
+    size_t elSize;
+    int_T  nRows;
+
+    if (var->segments != NULL) {
+        const char_T *msg = rt_LinearizeLogVar(var);
+        if (msg != NULL) return(msg);
+    }
+
+    nCols   = var->data.nCols;
+    maxRows = var->data.nRows;
+    nDims   = var->data.nDims;
+    elSize  = var->data.elSize;
+    nRows   = (var->wrapped ?  maxRows : var->rowIdx);
+
+    if (var->data.stream != NULL) {
+        LogStream *stream = var->data.stream;
+
+        if (stream->nChunks > 0) {
+            /* Spill the remaining rows, the data is written from the file */
+            rt_FlushLogVarChunk(var);
+            if (((double)stream->nRowsFlushed)*((double)nCols)*
+                ((double)elSize) >= UINT_MAX) {
+                return("logged data exceeds the MAT-file variable size limit\n");
+            }
+            var->nDataPoints = stream->nRowsFlushed;
+            var->data.nRows  = stream->nRowsFlushed;
+            if (var->valDims != NULL) {
+                /* Only fixed-size logs are streamed, keep the row count of
+                 * their empty valueDimensions as when reallocated */
+                var->valDims->nRows = stream->nRowsFlushed;
+            }
+            return(NULL);
+        }
+        /* Nothing was spilled, write the data from memory as usual */
+        rt_DestroyLogStream(stream);
+        var->data.stream = NULL;
+    }
 
     var->nDataPoints = var->rowIdx + var->wrapped * maxRows;
 
@@ -1480,20 +2031,36 @@ static void rt_DestroyLogVar(LogVar *head)
     while(head) {
         LogVar *var = head;
         head = var->next;
-        FREE(var->data.re);
-        FREE(var->data.im);
+        if (var->data.stream != NULL) {
+            rt_DestroyLogStream(var->data.stream);
+        }
+        if (var->segments != NULL) {
+            /* Only the first segment came from the heap */
+            LogSegment *seg;
+            for (seg = var->segments; seg != NULL; seg = seg->next) {
+                if (seg->fromHeap) {
+                    FREE(seg->re);
+                    FREE(seg->im);
+                    FREE(seg->dimsData);
+                }
+            }
+        } else {
+            FREE(var->data.re);
+            FREE(var->data.im);
+            if (var->valDims != NULL) {
+                FREE(var->valDims->dimsData);
+            }
+        }
         if (var->data.dims != var->data._dims) {
             FREE(var->data.dims);
         }
         /* free valDims if necessary */
-        if(var->valDims != NULL) {
-            FREE(var->valDims->dimsData);
-            FREE(var->valDims);
-        }
+        FREE(var->valDims);
         /* free coords, strides and currStrides if necessary */
         FREE(var->coords);
         FREE(var->strides);
         FREE(var->currStrides);
+        FREE(var->convBuf);
 
         FREE(var);
     }
@@ -2411,6 +2978,10 @@ static void rt_ReallocLogVar(LogVar *var, boolean_T isVarDims)
     else
     {
         nRows = var->data.nRows == 0 ? 1 : 2*var->data.nRows;
+        if (var->data.stream != NULL && nRows > var->data.stream->chunkRows) {
+            /* Streamed logs only grow up to the chunk size */
+            nRows = var->data.stream->chunkRows;
+        }
     }
     
     tmp = realloc(var->data.re, nRows*nCols*elSize);
@@ -2529,6 +3100,844 @@ static void rt_ReallocLogVar(LogVar *var, boolean_T isVarDims)
 
 } /* end rt_ReallocLogVar */
 
+
+/* Function: rt_GrowLogVar =====================================================
+ * Abstract:
+ *   Retire the full buffers of the log variable to its list of segments and
+ *   continue logging into a new segment from the logging arena.  Each new
+ *   segment is as large as all the previous ones together, so the capacity
+ *   doubles without moving any of the rows that have already been logged.
+ *   Exit if unable to allocate more memory.
+ */
+static void rt_GrowLogVar(LogVar *var)
+{
+    LogArena   *arena     = var->arena;
+    int_T      nCols      = var->data.nCols;
+    size_t     elSize     = var->data.elSize;
+    int_T      nRows      = var->nSegmentRows + var->data.nRows;
+    boolean_T  hasDims    = (var->valDims != NULL &&
+                             var->valDims->dimsData != NULL);
+    int_T      nColsDims  = hasDims ? var->valDims->nCols : 0;
+    LogSegment *seg;
+    void       *re;
+    void       *im        = NULL;
+    real_T     *dimsData  = NULL;
+
+    if (nRows <= 0) nRows = 1;
+
+    seg = rt_LogArenaAlloc(arena, sizeof(LogSegment));
+    re  = rt_LogArenaAlloc(arena, nRows*nCols*elSize);
+    if (var->data.complex) {
+        im = rt_LogArenaAlloc(arena, nRows*nCols*elSize);
+    }
+    if (hasDims) {
+        dimsData = rt_LogArenaAlloc(arena, nRows*nColsDims*sizeof(real_T));
+    }
+    if (seg == NULL || re == NULL || (var->data.complex && im == NULL) ||
+        (hasDims && dimsData == NULL)) {
+        (void)fprintf(stderr,
+                      "*** Memory allocation error.\n");
+        (void)fprintf(stderr, ""
+                      "    varName          = %s\n"
+                      "    nRows            = %d\n"
+                      "    nCols            = %d\n"
+                      "    elementSize      = %lu\n"
+                      "    Current Size     = %.16g\n"
+                      "    Failed resize    = %.16g\n\n",
+                      var->data.name,
+                      var->nSegmentRows + var->data.nRows,
+                      var->data.nCols,
+                      (unsigned long)  var->data.elSize,
+                      (double)(var->nSegmentRows + var->data.nRows)*nCols*elSize,
+                      (double)(var->nSegmentRows + var->data.nRows + nRows)*
+                      nCols*elSize);
+        exit(1);
+    }
+
+    /* The first segment holds the buffers allocated with the log variable */
+    seg->re       = var->data.re;
+    seg->im       = var->data.im;
+    seg->dimsData = hasDims ? var->valDims->dimsData : NULL;
+    seg->nRows    = var->data.nRows;
+    seg->fromHeap = (var->segments == NULL);
+    seg->next     = NULL;
+
+    if (var->lastSegment != NULL) {
+        var->lastSegment->next = seg;
+    } else {
+        var->segments = seg;
+    }
+    var->lastSegment   = seg;
+    var->nSegmentRows += var->data.nRows;
+
+    var->data.re    = re;
+    var->data.im    = im;
+    var->data.nRows = nRows;
+    if (hasDims) {
+        var->valDims->dimsData = dimsData;
+        var->valDims->nRows    = nRows;
+    }
+    var->rowIdx = 0;
+
+} /* end rt_GrowLogVar */
+
+
+/* Function: rt_MakeRoomInLogVar ===============================================
+ * Abstract:
+ *   Called when all the rows of the log variable's buffers are in use.
+ *   Depending on how the log variable was set up, flush the rows to the spill
+ *   file, grow the buffers or wrap around the circular buffer.
+ */
+static void rt_MakeRoomInLogVar(LogVar *var, boolean_T isVarDims)
+{
+    const LogStream *stream = var->data.stream;
+
+    if (stream != NULL && var->data.nRows >= stream->chunkRows) {
+        rt_FlushLogVarChunk(var);
+    } else if (var->okayToRealloc == 1) {
+        if (var->arena != NULL) {
+            rt_GrowLogVar(var);
+        } else {
+            rt_ReallocLogVar(var, isVarDims);
+        }
+    } else {
+        /* Circular buffer */
+        var->rowIdx = 0;
+        ++(var->wrapped); /* increment the wrap around counter */
+    }
+
+} /* end rt_MakeRoomInLogVar */
+
+/*
+ * Conversion kernels used by LOG_COPY_CONVERT. A read kernel converts n
+ * strided input elements to double, applying the slope and bias of the
+ * original data type, and a write kernel casts them to the logged type.
+ */
+#define RT_LOG_READ_FCN(fcnName, inType)                                     \
+static void fcnName(double                      *dst,                        \
+                    const char_T                *src,                        \
+                    size_t                      srcStride,                   \
+                    int_T                       n,                           \
+                    const RTWLogDataTypeConvert *convert)                    \
+{                                                                            \
+    double fracSlope = convert->fracSlope;                                   \
+    int    fixedExp  = convert->fixedExp;                                    \
+    double bias      = convert->bias;                                        \
+    int_T  k;                                                                \
+                                                                             \
+    for (k = 0; k < n; k++, src += srcStride) {                              \
+        dst[k] = ldexp(fracSlope * (double)(*(const inType *)src),           \
+                       fixedExp) + bias;                                     \
+    }                                                                        \
+}
+
+#define RT_LOG_WRITE_FCN(fcnName, outType)                                   \
+static void fcnName(void *dst, const double *src, int_T n)                   \
+{                                                                            \
+    outType *out = (outType *)dst;                                           \
+    int_T   k;                                                               \
+                                                                             \
+    for (k = 0; k < n; k++) {                                                \
+        out[k] = (outType)src[k];                                            \
+    }                                                                        \
+}
+
+RT_LOG_READ_FCN(rt_LogRead_double,  real_T)
+RT_LOG_READ_FCN(rt_LogRead_single,  real32_T)
+RT_LOG_READ_FCN(rt_LogRead_int8,    int8_T)
+RT_LOG_READ_FCN(rt_LogRead_uint8,   uint8_T)
+RT_LOG_READ_FCN(rt_LogRead_int16,   int16_T)
+RT_LOG_READ_FCN(rt_LogRead_uint16,  uint16_T)
+RT_LOG_READ_FCN(rt_LogRead_int32,   int32_T)
+RT_LOG_READ_FCN(rt_LogRead_uint32,  uint32_T)
+RT_LOG_READ_FCN(rt_LogRead_boolean, boolean_T)
+
+RT_LOG_WRITE_FCN(rt_LogWrite_double, real_T)
+RT_LOG_WRITE_FCN(rt_LogWrite_single, real32_T)
+RT_LOG_WRITE_FCN(rt_LogWrite_int8,   int8_T)
+RT_LOG_WRITE_FCN(rt_LogWrite_uint8,  uint8_T)
+RT_LOG_WRITE_FCN(rt_LogWrite_int16,  int16_T)
+RT_LOG_WRITE_FCN(rt_LogWrite_uint16, uint16_T)
+RT_LOG_WRITE_FCN(rt_LogWrite_int32,  int32_T)
+RT_LOG_WRITE_FCN(rt_LogWrite_uint32, uint32_T)
+
+static void rt_LogWrite_boolean(void *dst, const double *src, int_T n)
+{
+    boolean_T *out = (boolean_T *)dst;
+    int_T     k;
+
+    for (k = 0; k < n; k++) {
+        out[k] = (boolean_T)(src[k] != 0.0);
+    }
+}
+
+
+/* Function: rt_GetLogReadFcn ==================================================
+ * Abstract:
+ *      Get the read kernel for the original data type, NULL if there is none.
+ */
+static LogReadFcn rt_GetLogReadFcn(DTypeId dTypeID)
+{
+    switch (dTypeID) {
+      case SS_DOUBLE:  return(rt_LogRead_double);
+      case SS_SINGLE:  return(rt_LogRead_single);
+      case SS_INT8:    return(rt_LogRead_int8);
+      case SS_UINT8:   return(rt_LogRead_uint8);
+      case SS_INT16:   return(rt_LogRead_int16);
+      case SS_UINT16:  return(rt_LogRead_uint16);
+      case SS_INT32:   return(rt_LogRead_int32);
+      case SS_UINT32:  return(rt_LogRead_uint32);
+      case SS_BOOLEAN: return(rt_LogRead_boolean);
+      default:         return(NULL);
+    }
+
+} /* end rt_GetLogReadFcn */
+
+
+/* Function: rt_GetLogWriteFcn =================================================
+ * Abstract:
+ *      Get the write kernel for the logged data type, NULL if there is none.
+ */
+static LogWriteFcn rt_GetLogWriteFcn(DTypeId dTypeID)
+{
+    switch (dTypeID) {
+      case SS_DOUBLE:  return(rt_LogWrite_double);
+      case SS_SINGLE:  return(rt_LogWrite_single);
+      case SS_INT8:    return(rt_LogWrite_int8);
+      case SS_UINT8:   return(rt_LogWrite_uint8);
+      case SS_INT16:   return(rt_LogWrite_int16);
+      case SS_UINT16:  return(rt_LogWrite_uint16);
+      case SS_INT32:   return(rt_LogWrite_int32);
+      case SS_UINT32:  return(rt_LogWrite_uint32);
+      case SS_BOOLEAN: return(rt_LogWrite_boolean);
+      default:         return(NULL);
+    }
+
+} /* end rt_GetLogWriteFcn */
+
+
+/* Function: rt_InitLogVarCopyPlan =============================================
+ * Abstract:
+ *      Select how rt_UpdateLogVar copies a row of input data into the log
+ *      variable.  Anything the specialized plans cannot reproduce exactly
+ *      (variable-size signals, multiword and other non built-in types) is
+ *      left to the generic element by element code.
+ *
+ * Returns:
+ *	== 0  => success
+ *	~= 0  => failure to allocate memory
+ */
+static int_T rt_InitLogVarCopyPlan(LogVar *var, LogValDimsStat logValDimsStat)
+{
+    const RTWLogDataTypeConvert *convert = &var->data.dataTypeConvertInfo;
+
+    var->copyPlan     = LOG_COPY_GENERIC;
+    var->srcPointSize = 0;
+    var->readFcn      = NULL;
+    var->writeFcn     = NULL;
+    var->convBuf      = NULL;
+
+    if (logValDimsStat == LOGVALDIMS_VARDIMS) return(0);
+
+    if (!convert->conversionNeeded) {
+        BuiltInDTypeId dTypeID = var->data.dTypeID;
+
+        var->srcPointSize = var->data.complex ?
+            rt_GetSizeofComplexType(dTypeID) : var->data.elSize;
+        var->copyPlan = (!var->data.complex && !var->data.frameData) ?
+            LOG_COPY_ROW : LOG_COPY_GATHER;
+    } else {
+        DTypeId        dTypeIDOrig = convert->dataTypeIdOriginal;
+        LogReadFcn     readFcn     = rt_GetLogReadFcn(dTypeIDOrig);
+        LogWriteFcn    writeFcn    = rt_GetLogWriteFcn(convert->dataTypeIdLoggingTo);
+
+        /* complex boolean data is indexed differently, keep it generic */
+        if (readFcn == NULL || writeFcn == NULL || convert->numOfChunk > 1 ||
+            (var->data.complex && dTypeIDOrig == SS_BOOLEAN)) {
+            return(0);
+        }
+        if ((var->convBuf = malloc(var->data.nCols*sizeof(double))) == NULL) {
+            return(1);
+        }
+        var->srcPointSize = var->data.complex ?
+            rt_GetSizeofComplexType((BuiltInDTypeId)dTypeIDOrig) :
+            rt_GetSizeofDataType((BuiltInDTypeId)dTypeIDOrig);
+        var->readFcn  = readFcn;
+        var->writeFcn = writeFcn;
+        var->copyPlan = LOG_COPY_CONVERT;
+    }
+    return(0);
+
+} /* end rt_InitLogVarCopyPlan */
+
+
+/* Function: rt_GatherElements =================================================
+ * Abstract:
+ *      Copy n elements of size elSize that are srcStride bytes apart into
+ *      contiguous memory.  The common element sizes get fixed size copies.
+ */
+static void rt_GatherElements(char_T       *dst,
+                              const char_T *src,
+                              size_t       srcStride,
+                              int_T        n,
+                              size_t       elSize)
+{
+    int_T k;
+
+    switch (elSize) {
+      case 8:
+        for (k = 0; k < n; k++, dst += 8, src += srcStride) {
+            (void)memcpy(dst, src, 8);
+        }
+        break;
+      case 4:
+        for (k = 0; k < n; k++, dst += 4, src += srcStride) {
+            (void)memcpy(dst, src, 4);
+        }
+        break;
+      case 2:
+        for (k = 0; k < n; k++, dst += 2, src += srcStride) {
+            (void)memcpy(dst, src, 2);
+        }
+        break;
+      case 1:
+        for (k = 0; k < n; k++, dst += 1, src += srcStride) {
+            *dst = *src;
+        }
+        break;
+      default:
+        for (k = 0; k < n; k++, dst += elSize, src += srcStride) {
+            (void)memcpy(dst, src, elSize);
+        }
+        break;
+    }
+
+} /* end rt_GatherElements */
+
+
+/* Function: rt_UpdateLogVarWithCopyPlan =======================================
+ * Abstract:
+ *      Log the rows of fixed-size input data using the copy plan selected
+ *      when the log variable was created.  Produces the same data as the
+ *      generic code in rt_UpdateLogVar.
+ */
+static void rt_UpdateLogVarWithCopyPlan(LogVar *var, const void *data)
+{
+    const char_T *cData      = data;
+    const int_T  frameSize   = var->data.frameData ? var->data.frameSize : 1;
+    const int_T  nCols       = var->data.nCols;
+    const size_t rowBytes    = nCols * var->data.elSize;
+    const size_t pointSize   = var->srcPointSize;
+    const size_t srcStride   = frameSize * pointSize;
+    int_T        i;
+
+    for (i = 0; i < frameSize; i++) {
+        const char_T *src = cData + i*pointSize;
+        char_T       *dstRe;
+        char_T       *dstIm;
+
+        if (var->decimation > 1) {
+            if (++var->numHits % var->decimation) continue;
+            var->numHits = 0;
+        }
+
+        if (var->rowIdx == var->data.nRows) {
+            rt_MakeRoomInLogVar(var, false);
+        }
+        dstRe = ((char_T*) (var->data.re)) + rowBytes*var->rowIdx;
+        dstIm = (var->data.complex) ?
+                ((char_T*) (var->data.im)) + rowBytes*var->rowIdx : NULL;
+
+        switch (var->copyPlan) {
+          case LOG_COPY_ROW:
+            (void)memcpy(dstRe, src, rowBytes);
+            break;
+          case LOG_COPY_GATHER:
+            rt_GatherElements(dstRe, src, srcStride, nCols, var->data.elSize);
+            if (dstIm != NULL) {
+                rt_GatherElements(dstIm, src + pointSize/2, srcStride, nCols,
+                                  var->data.elSize);
+            }
+            break;
+          case LOG_COPY_CONVERT:
+            var->readFcn(var->convBuf, src, srcStride, nCols,
+                         &var->data.dataTypeConvertInfo);
+            var->writeFcn(dstRe, var->convBuf, nCols);
+            if (dstIm != NULL) {
+                var->readFcn(var->convBuf, src + pointSize/2, srcStride, nCols,
+                             &var->data.dataTypeConvertInfo);
+                var->writeFcn(dstIm, var->convBuf, nCols);
+            }
+            break;
+          default:
+            break;
+        }
+
+        ++var->rowIdx;
+    }
+
+} /* end rt_UpdateLogVarWithCopyPlan */
+
+
+/* Function: rt_GetCurrDimsValue ==============================================
+ * Abstract:
+ *      Get the current value of dimension k of a variable-size signal.
+ */
+static int32_T rt_GetCurrDimsValue(const void * const *currDimsPtr,
+                                   const int_T        *currDimsSizePtr,
+                                   int_T              k)
+{
+    int32_T currDimsVal = 0;
+
+    switch (currDimsSizePtr[k]) {
+      case 1:
+        currDimsVal = (**(((const uint8_T * const *) currDimsPtr)+k));
+        break;
+      case 2:
+        currDimsVal = (**(((const uint16_T * const *) currDimsPtr)+k));
+        break;
+      case 4:
+        currDimsVal = (**(((const uint32_T * const *) currDimsPtr)+k));
+        break;
+    }
+    return(currDimsVal);
+
+} /* end rt_GetCurrDimsValue */
+
+
+static void rt_UpdateLogVarImpl(LogVar          *var,
+                                const void      *data,
+                                boolean_T       isVarDims,
+                                const int32_T   *currDims);
+
+static const char_T *rt_UpdateLogVarWithDiscontiguousDataImpl(
+    LogVar                 *var,
+    int8_T**               data,
+    const int_T            *segmentLengths,
+    int_T                  nSegments,
+    RTWPreprocessingFcnPtr *preprocessingPtrs);
+
+
+#if LOGGING_ASYNC_BUFFER_SIZE > 0
+
+/*
+ * Asynchronous logging. The model step is the only producer and the logging
+ * thread the only consumer of the LogAsyncQueue of a LogInfo, so head is only
+ * written by the model step and tail only by the logging thread.  They are
+ * accessed with the GCC __atomic builtins, which order the record contents
+ * with respect to them.  Each record is a
+ * LogAsyncRecord followed by the signal data and, for variable-size signals,
+ * the current dimensions.  Records never wrap around the end of the ring.
+ *
+ * Samples are queued or dropped a whole time step at a time, so that the
+ * time and signal variables stay aligned.  A time step ends with
+ * rt_UpdateTXXFYLogVars; the first record of the next step is only queued if
+ * the ring has room for twice the biggest step so far (records may be padded
+ * up to their own size at the end of the ring).
+ */
+#define LOG_ASYNC_UPDATE         1  /* rt_UpdateLogVar                        */
+#define LOG_ASYNC_ROW            2  /* rt_UpdateLogVarWithDiscontiguousData   */
+#define LOG_ASYNC_SKIP           3  /* rest of the ring is unused             */
+#define LOG_ASYNC_SLEEP_NSEC     100000L
+#define LOG_ASYNC_MASK           ((size_t)(LOGGING_ASYNC_BUFFER_SIZE-1))
+
+#define LOG_ASYNC_STEP_START     0  /* no record of this step seen yet        */
+#define LOG_ASYNC_STEP_QUEUE     1  /* the records of this step are queued    */
+#define LOG_ASYNC_STEP_DROP      2  /* the records of this step are dropped   */
+
+/* head, tail and stop are shared between the two threads */
+#define LOG_ASYNC_LOAD(x)        __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define LOG_ASYNC_STORE(x, v)    __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+
+#define LOG_ASYNC_FREE(q)        (LOGGING_ASYNC_BUFFER_SIZE - \
+                                  ((q)->head - LOG_ASYNC_LOAD((q)->tail)))
+
+typedef struct LogAsyncRecord_Tag {
+    LogVar    *var;
+    size_t    size;                   /* bytes in the record, header included */
+    int_T     kind;
+    int_T     nDims;                  /* current dimensions after the data    */
+    boolean_T isVarDims;
+} LogAsyncRecord;
+
+#define LOG_ASYNC_HEADER_SIZE    LOG_ARENA_ALIGN(sizeof(LogAsyncRecord))
+
+
+/* Function: rt_LogAsyncWorker =================================================
+ * Abstract:
+ *      Body of the logging thread.  Log the queued records until the queue is
+ *      empty and rt_LogAsyncStop has been called.
+ */
+static void rt_LogAsyncWorker(void *arg)
+{
+    LogAsyncQueue *q = (LogAsyncQueue *)arg;
+
+    for (;;) {
+        int            stop = LOG_ASYNC_LOAD(q->stop);
+        size_t         head = LOG_ASYNC_LOAD(q->head);
+        size_t         tail = q->tail;
+        size_t         idx  = tail & LOG_ASYNC_MASK;
+        size_t         room = LOGGING_ASYNC_BUFFER_SIZE - idx;
+        LogAsyncRecord *rec;
+
+        if (tail == head) {
+            if (stop) break;
+            rtw_sleep(LOG_ASYNC_SLEEP_NSEC);
+            continue;
+        }
+
+        if (room < LOG_ASYNC_HEADER_SIZE) {
+            LOG_ASYNC_STORE(q->tail, tail + room);
+            continue;
+        }
+        rec = (LogAsyncRecord *)(q->buf + idx);
+
+        if (rec->kind == LOG_ASYNC_SKIP) {
+            tail += room;
+        } else {
+            char_T *payload = (char_T *)rec + LOG_ASYNC_HEADER_SIZE;
+
+            if (rec->kind == LOG_ASYNC_ROW) {
+                int_T                  nCols        = rec->var->data.nCols;
+                int8_T                 *segment     = (int8_T *)payload;
+                RTWPreprocessingFcnPtr preprocessing = NULL;
+
+                (void)rt_UpdateLogVarWithDiscontiguousDataImpl(
+                    rec->var, &segment, &nCols, 1, &preprocessing);
+            } else {
+                const int32_T *currDims = rec->isVarDims ? (const int32_T *)
+                    ((char_T *)rec + rec->size - rec->nDims*sizeof(int32_T)) :
+                    NULL;
+
+                rt_UpdateLogVarImpl(rec->var, payload, rec->isVarDims,
+                                    currDims);
+            }
+            tail += rec->size;
+        }
+        LOG_ASYNC_STORE(q->tail, tail);
+    }
+
+} /* end rt_LogAsyncWorker */
+
+
+/* Function: rt_LogAsyncDrain ==================================================
+ * Abstract:
+ *      Wait until the logging thread has logged all the queued records.
+ */
+static void rt_LogAsyncDrain(LogAsyncQueue *q)
+{
+    while (LOG_ASYNC_LOAD(q->tail) != q->head) {
+        rtw_sleep(LOG_ASYNC_SLEEP_NSEC);
+    }
+
+} /* end rt_LogAsyncDrain */
+
+
+/* Function: rt_LogAsyncAdmit ==================================================
+ * Abstract:
+ *      Decide at the first record of a time step whether the records of the
+ *      step are queued or dropped.  Returns false if they are dropped.
+ */
+static boolean_T rt_LogAsyncAdmit(LogAsyncQueue *q)
+{
+#ifdef LOGGING_ASYNC_DROP
+    if (q->step == LOG_ASYNC_STEP_START) {
+        /* A step that cannot fit at all is queued and waited for */
+        if (2*q->maxStepBytes > LOGGING_ASYNC_BUFFER_SIZE ||
+            LOG_ASYNC_FREE(q) >= 2*q->maxStepBytes) {
+            q->step = LOG_ASYNC_STEP_QUEUE;
+        } else {
+            q->step = LOG_ASYNC_STEP_DROP;
+        }
+    }
+    return((boolean_T)(q->step != LOG_ASYNC_STEP_DROP));
+#else
+    q->step = LOG_ASYNC_STEP_QUEUE;
+    return(true);
+#endif
+
+} /* end rt_LogAsyncAdmit */
+
+
+/* Function: rt_LogAsyncEndStep ================================================
+ * Abstract:
+ *      Mark the end of a time step.
+ */
+static void rt_LogAsyncEndStep(LogAsyncQueue *q)
+{
+    if (q->step == LOG_ASYNC_STEP_DROP) {
+        ++q->nDroppedSteps;
+    } else if (q->stepBytes > q->maxStepBytes) {
+        q->maxStepBytes = q->stepBytes;
+    }
+    ++q->nSteps;
+    q->step      = LOG_ASYNC_STEP_START;
+    q->stepBytes = 0;
+
+} /* end rt_LogAsyncEndStep */
+
+
+/* Function: rt_LogAsyncReserve ================================================
+ * Abstract:
+ *      Reserve a record with nBytes of signal data and nDims current
+ *      dimensions, waiting for the logging thread if the ring is full.
+ *      Returns NULL when the record is too big for the ring; the caller must
+ *      then drain the queue and log synchronously.
+ */
+static LogAsyncRecord *rt_LogAsyncReserve(LogAsyncQueue *q,
+                                          LogVar        *var,
+                                          int_T         kind,
+                                          size_t        nBytes,
+                                          boolean_T     isVarDims,
+                                          int_T         nDims)
+{
+    size_t         size   = LOG_ARENA_ALIGN(LOG_ASYNC_HEADER_SIZE + nBytes +
+                                            nDims*sizeof(int32_T));
+    size_t         head   = q->head;
+    size_t         idx    = head & LOG_ASYNC_MASK;
+    size_t         room   = LOGGING_ASYNC_BUFFER_SIZE - idx;
+    size_t         pad    = (room < size) ? room : 0;
+    size_t         used;
+    LogAsyncRecord *rec;
+
+    if (size > LOGGING_ASYNC_BUFFER_SIZE/2) return(NULL);
+
+    if (LOG_ASYNC_FREE(q) < pad + size) {
+        ++q->nStalls;
+        while (LOG_ASYNC_FREE(q) < pad + size) {
+            rtw_sleep(LOG_ASYNC_SLEEP_NSEC);
+        }
+    }
+
+    if (pad >= LOG_ASYNC_HEADER_SIZE) {
+        ((LogAsyncRecord *)(q->buf + idx))->kind = LOG_ASYNC_SKIP;
+    }
+    used = head + pad + size - LOG_ASYNC_LOAD(q->tail);
+    if (used > q->maxUsed) q->maxUsed = used;
+
+    rec = (LogAsyncRecord *)(q->buf + ((head + pad) & LOG_ASYNC_MASK));
+    rec->var       = var;
+    rec->size      = size;
+    rec->kind      = kind;
+    rec->nDims     = nDims;
+    rec->isVarDims = isVarDims;
+    q->pending     = pad + size;
+    q->stepBytes  += size;
+    return(rec);
+
+} /* end rt_LogAsyncReserve */
+
+
+/* Function: rt_LogAsyncCommit =================================================
+ * Abstract:
+ *      Hand the record reserved last to the logging thread.
+ */
+static void rt_LogAsyncCommit(LogAsyncQueue *q)
+{
+    LOG_ASYNC_STORE(q->head, q->head + q->pending);
+    q->pending = 0;
+    ++q->nRecords;
+
+} /* end rt_LogAsyncCommit */
+
+
+/* Function: rt_GetLogVarInputSize =============================================
+ * Abstract:
+ *      Number of bytes of input data read by one call to rt_UpdateLogVar.
+ */
+static size_t rt_GetLogVarInputSize(const LogVar *var)
+{
+    const RTWLogDataTypeConvert *convert = &var->data.dataTypeConvertInfo;
+    size_t  frameSize = var->data.frameData ? var->data.frameSize : 1;
+    size_t  nParts    = var->data.complex ? 2 : 1;
+    DTypeId dTypeIDOrig;
+    size_t  pointSize;
+
+    if (!convert->conversionNeeded) {
+        pointSize = var->data.complex ?
+            rt_GetSizeofComplexType(var->data.dTypeID) : var->data.elSize;
+        return(frameSize * var->data.nCols * pointSize);
+    }
+
+    dTypeIDOrig = convert->dataTypeIdOriginal;
+    if (convert->numOfChunk > 1 || rt_GetLogReadFcn(dTypeIDOrig) == NULL) {
+        /* multiword */
+        pointSize = nParts * (size_t)(convert->bitsPerChunk *
+                                      convert->numOfChunk / 8);
+    } else if (dTypeIDOrig == SS_BOOLEAN) {
+        pointSize = nParts * sizeof(boolean_T);
+    } else {
+        pointSize = var->data.complex ?
+            rt_GetSizeofComplexType((BuiltInDTypeId)dTypeIDOrig) :
+            rt_GetSizeofDataType((BuiltInDTypeId)dTypeIDOrig);
+    }
+    return(frameSize * var->data.nCols * pointSize);
+
+} /* end rt_GetLogVarInputSize */
+
+
+/* Function: rt_LogAsyncUpdateLogVar ===========================================
+ * Abstract:
+ *      Queue the data of one rt_UpdateLogVar call for the logging thread.
+ *      The current dimensions of a variable-size signal are captured along
+ *      with the data.
+ */
+static void rt_LogAsyncUpdateLogVar(LogVar     *var,
+                                    const void *data,
+                                    boolean_T  isVarDims)
+{
+    LogAsyncQueue  *q     = var->async;
+    size_t         nBytes = rt_GetLogVarInputSize(var);
+    int_T          nDims  = isVarDims ? var->valDims->nCols : 0;
+    LogAsyncRecord *rec;
+    char_T         *payload;
+    int32_T        *currDims;
+    int_T          k;
+
+    if (!rt_LogAsyncAdmit(q)) return;
+
+    rec = rt_LogAsyncReserve(q, var, LOG_ASYNC_UPDATE, nBytes, isVarDims,
+                             nDims);
+    if (rec == NULL) {
+        rt_LogAsyncDrain(q);
+        rt_UpdateLogVarImpl(var, data, isVarDims, NULL);
+        return;
+    }
+
+    payload  = (char_T *)rec + LOG_ASYNC_HEADER_SIZE;
+    currDims = (int32_T *)((char_T *)rec + rec->size - nDims*sizeof(int32_T));
+    (void)memcpy(payload, data, nBytes);
+    for (k = 0; k < nDims; k++) {
+        currDims[k] = rt_GetCurrDimsValue(
+            (const void * const *)var->valDims->currSigDims,
+            var->valDims->currSigDimsSize, k);
+    }
+    rt_LogAsyncCommit(q);
+
+} /* end rt_LogAsyncUpdateLogVar */
+
+
+/* Function: rt_LogAsyncUpdateLogVarWithDiscontiguousData ======================
+ * Abstract:
+ *      Gather (and preprocess) one row of discontiguous data into a record
+ *      for the logging thread.
+ */
+static const char_T *rt_LogAsyncUpdateLogVarWithDiscontiguousData(
+    LogVar                 *var,
+    int8_T**               data,
+    const int_T            *segmentLengths,
+    int_T                  nSegments,
+    RTWPreprocessingFcnPtr *preprocessingPtrs)
+{
+    LogAsyncQueue  *q     = var->async;
+    size_t         elSize = var->data.elSize * (var->data.complex ? 2 : 1);
+    LogAsyncRecord *rec;
+    char_T         *dst;
+    int_T          segIdx;
+
+    if (!rt_LogAsyncAdmit(q)) return(NULL);
+
+    rec = rt_LogAsyncReserve(q, var, LOG_ASYNC_ROW, elSize*var->data.nCols,
+                             false, 0);
+    if (rec == NULL) {
+        rt_LogAsyncDrain(q);
+        return(rt_UpdateLogVarWithDiscontiguousDataImpl(var, data,
+                                                        segmentLengths,
+                                                        nSegments,
+                                                        preprocessingPtrs));
+    }
+
+    dst = (char_T *)rec + LOG_ASYNC_HEADER_SIZE;
+    for (segIdx = 0; segIdx < nSegments; segIdx++) {
+        size_t                 segSize          = elSize*segmentLengths[segIdx];
+        RTWPreprocessingFcnPtr preprocessingPtr = preprocessingPtrs[segIdx];
+
+        if (preprocessingPtr != NULL) {
+            preprocessingPtr(dst, data[segIdx]);
+        } else {
+            (void)memcpy(dst, data[segIdx], segSize);
+        }
+        dst += segSize;
+    }
+    rt_LogAsyncCommit(q);
+    return(NULL);
+
+} /* end rt_LogAsyncUpdateLogVarWithDiscontiguousData */
+
+
+/* Function: rt_LogAsyncStart ==================================================
+ * Abstract:
+ *      Create the ring buffer and start the logging thread.
+ *
+ * Returns:
+ *	== 0  => success
+ *	~= 0  => failure to allocate memory
+ */
+static int_T rt_LogAsyncStart(LogAsyncQueue *q)
+{
+    if (q->task != NULL) return(0); /* already running */
+
+    if ((q->buf = malloc(LOGGING_ASYNC_BUFFER_SIZE)) == NULL) return(1);
+    q->head          = 0;
+    q->tail          = 0;
+    q->stop          = 0;
+    q->pending       = 0;
+    q->step          = LOG_ASYNC_STEP_START;
+    q->stepBytes     = 0;
+    q->maxStepBytes  = 0;
+    q->nRecords      = 0;
+    q->nStalls       = 0;
+    q->nSteps        = 0;
+    q->nDroppedSteps = 0;
+    q->maxUsed       = 0;
+
+    q->task = rtw_register_task_with_arg(rt_LogAsyncWorker, q);
+    rtw_lower_task_priority(q->task);
+    rtw_trigger_task(q->task);
+    return(0);
+
+} /* end rt_LogAsyncStart */
+
+
+/* Function: rt_LogAsyncStop ===================================================
+ * Abstract:
+ *      Log the queued records, stop the logging thread and free the ring
+ *      buffer.  Warn if the model step had to wait for the logging thread.
+ */
+static void rt_LogAsyncStop(LogAsyncQueue *q)
+{
+    if (q->task == NULL) return;
+
+    LOG_ASYNC_STORE(q->stop, 1);
+    rtw_waitfor_task(q->task);
+    rtw_deregister_task(q->task);
+    q->task = NULL;
+    FREE(q->buf);
+    q->buf = NULL;
+
+    if (q->nStalls > 0) {
+        (void)fprintf(stderr,
+                      "*** Warning: the model step waited %lu times (out of "
+                      "%lu) for the logging thread; %lu of %lu bytes of the "
+                      "ring buffer were used. Consider increasing "
+                      "LOGGING_ASYNC_BUFFER_SIZE.\n",
+                      q->nStalls, q->nRecords, (unsigned long)q->maxUsed,
+                      (unsigned long)LOGGING_ASYNC_BUFFER_SIZE);
+    }
+    if (q->nDroppedSteps > 0) {
+        (void)fprintf(stderr,
+                      "*** Warning: the logging thread fell behind and the "
+                      "data of %lu of %lu time steps was not logged. Consider "
+                      "increasing LOGGING_ASYNC_BUFFER_SIZE or not defining "
+                      "LOGGING_ASYNC_DROP.\n",
+                      q->nDroppedSteps, q->nSteps);
+    }
+
+} /* end rt_LogAsyncStop */
+
+#endif /* LOGGING_ASYNC_BUFFER_SIZE > 0 */
+
+
 const char_T *rt_UpdateLogVarWithDiscontiguousData(LogVar                 *var,
                                              int8_T**               data,
                                              const int_T            *segmentLengths,
@@ -2544,6 +3953,32 @@ const char_T *rt_UpdateLogVarWithDiscontiguousData(LogVar                 *var,
                                              const int_T            *segmentLengths,
                                              int_T                  nSegments,
                                              RTWPreprocessingFcnPtr *preprocessingPtrs)
+{
+#if LOGGING_ASYNC_BUFFER_SIZE > 0
+    if (var->async != NULL && var->async->task != NULL) {
+        return(rt_LogAsyncUpdateLogVarWithDiscontiguousData(var, data,
+                                                            segmentLengths,
+                                                            nSegments,
+                                                            preprocessingPtrs));
+    }
+#endif
+    return(rt_UpdateLogVarWithDiscontiguousDataImpl(var, data, segmentLengths,
+                                                    nSegments,
+                                                    preprocessingPtrs));
+
+} /* end rt_UpdateLogVarWithDiscontiguousData */
+
+
+/* Function: rt_UpdateLogVarWithDiscontiguousDataImpl ==========================
+ * Abstract:
+ *      Log one row of the LogVar with data that is not contiguous.
+ */
+static const char_T *rt_UpdateLogVarWithDiscontiguousDataImpl(
+    LogVar                 *var,
+    int8_T**               data,
+    const int_T            *segmentLengths,
+    int_T                  nSegments,
+    RTWPreprocessingFcnPtr *preprocessingPtrs)
 {
     size_t elSize = 0;
     size_t offset = 0;
@@ -2553,16 +3988,10 @@ const char_T *rt_UpdateLogVarWithDiscontiguousData(LogVar                 *var,
     var->numHits = 0;
 
     /*
-     * Reallocate or wrap the LogVar
+     * Flush, reallocate or wrap the LogVar
      */
     if (var->rowIdx == var->data.nRows) {
-        if (var->okayToRealloc == 1) {
-            rt_ReallocLogVar(var, false);
-        } else {
-            /* Circular buffer */
-            var->rowIdx = 0;
-            ++(var->wrapped); /* increment the wrap around counter */
-        }
+        rt_MakeRoomInLogVar(var, false);
     }
 
     /* This function is only used to log states, there's no var-dims issue. */
@@ -2636,7 +4065,7 @@ const char_T *rt_UpdateLogVarWithDiscontiguousData(LogVar                 *var,
     ++var->rowIdx;
     return(NULL);
 
-} /* end rt_UpdateLogVarWithDiscontinuousData */
+} /* end rt_UpdateLogVarWithDiscontiguousDataImpl */
 
 
 /*==================*
@@ -2694,6 +4123,7 @@ LogVar *rt_CreateLogVarWithConvert(
     int_T          frameSize;
     int_T          nRows;
     int_T          nColumns;
+    boolean_T      streamed;
 
     /*===================================================================*
      * Determine the frame size if the data is frame based               *
@@ -2822,6 +4252,17 @@ LogVar *rt_CreateLogVarWithConvert(
         }
     }
 
+    /*
+     * Growing fixed-size logs are spilled to disk in chunks when streaming
+     * is enabled, so never hold more than one chunk of rows in memory.
+     */
+    streamed = (LOGGING_STREAM_BUFFER_SIZE > 0 && okayToRealloc &&
+                logValDimsStat != LOGVALDIMS_VARDIMS &&
+                li != NULL && rtliGetLogInfo(li) != NULL);
+    if (streamed && nRows > LOGGING_STREAM_BUFFER_SIZE) {
+        nRows = LOGGING_STREAM_BUFFER_SIZE;
+    }
+
     /* Allocate memory for the log variable */
     if ( (var = calloc(1, sizeof(LogVar))) == NULL ) {
         (void)fprintf(stderr, "*** Error allocating memory for logging %s\n",
@@ -2901,6 +4342,16 @@ LogVar *rt_CreateLogVarWithConvert(
     var->data.frameData       = frameData;
     var->data.frameSize       = (frameData) ? frameSize : 1;
 
+    if (streamed) {
+        boolean_T transposed = (var->data.nDims < 2 && nColumns > 1);
+
+        var->data.stream = rt_CreateLogStream(
+            &(((LogInfo*) rtliGetLogInfo(li))->spill),
+            LOGGING_STREAM_BUFFER_SIZE,
+            transposed);
+        if (var->data.stream == NULL) goto ERROR_EXIT;
+    }
+
     /* fill up valDims field */
     if(logValDimsStat == NO_LOGVALDIMS){
         /* All signals are fixed-size, no need to log valueDimensions field */
@@ -2989,6 +4440,33 @@ LogVar *rt_CreateLogVarWithConvert(
     var->decimation           = decimation;
     var->numHits              = -1;  /* so first point gets logged */
 
+    /* Growing log variables get new segments from the logging arena */
+#if LOG_CONCURRENT_RATES
+    var->arena = NULL;
+#else
+    if (okayToRealloc && !streamed && li != NULL &&
+        rtliGetLogInfo(li) != NULL) {
+        var->arena = &(((LogInfo*) rtliGetLogInfo(li))->arena);
+    } else {
+        var->arena = NULL;
+    }
+#endif
+#if LOGGING_ASYNC_BUFFER_SIZE > 0
+    /* Queued for the logging thread once it has been started */
+    if (li != NULL && rtliGetLogInfo(li) != NULL) {
+        var->async = &(((LogInfo*) rtliGetLogInfo(li))->async);
+    } else {
+        var->async = NULL;
+    }
+#else
+    var->async = NULL;
+#endif
+    var->segments     = NULL;
+    var->lastSegment  = NULL;
+    var->nSegmentRows = 0;
+
+    if (rt_InitLogVarCopyPlan(var, logValDimsStat)) goto ERROR_EXIT;
+
     /* Add this log var to list in log info, if necessary */
     if (appendToLogVarsList) {
         LogInfo *logInfo = (LogInfo*) rtliGetLogInfo(li);
@@ -3271,6 +4749,13 @@ const char_T *rt_StartDataLoggingWithStartTime(RTWLogInfo   *li,
                                               stepSize,errStatus);
     if (*errStatus != NULL)  goto ERROR_EXIT;
 
+#if LOGGING_ASYNC_BUFFER_SIZE > 0
+    if (rt_LogAsyncStart(&logInfo->async) != 0) {
+        *errStatus = rtMemAllocError;
+        goto ERROR_EXIT;
+    }
+#endif
+
     return(NULL); /* NORMAL_EXIT */
 
  ERROR_EXIT:
@@ -3283,6 +4768,8 @@ const char_T *rt_StartDataLoggingWithStartTime(RTWLogInfo   *li,
         logInfo->logVarsList = NULL;
         rt_DestroyStructLogVar(logInfo->structLogVarsList);
         logInfo->structLogVarsList = NULL;
+        rt_DestroyLogArena(&logInfo->arena);
+        rt_DestroyLogSpill(&logInfo->spill);
         FREE(logInfo);
         rtliSetLogInfo(li,NULL);
     }
@@ -3331,11 +4818,17 @@ extern "C" {
 #endif
 
  
-/* Function: rt_UpdateLogVar ===================================================
+/* Function: rt_UpdateLogVarGeneric ============================================
  * Abstract:
- *	Called to log data for a log variable.
+ *	Log data for a log variable element by element.  Used for the data
+ *	that rt_UpdateLogVarWithCopyPlan does not handle.  The current
+ *	dimensions of a variable-size signal are read from currDims, or from
+ *	the signal itself if currDims is NULL.
  */
-void rt_UpdateLogVar(LogVar *var, const void *data, boolean_T isVarDims)
+static void rt_UpdateLogVarGeneric(LogVar          *var,
+                                   const void      *data,
+                                   boolean_T       isVarDims,
+                                   const int32_T   *currDims)
 {
     size_t        elSize    = var->data.elSize;
     const  char_T *cData    = data;
@@ -3372,13 +4865,7 @@ void rt_UpdateLogVar(LogVar *var, const void *data, boolean_T isVarDims)
         var->numHits = 0;
 
         if (var->rowIdx == var->data.nRows) {
-            if (var->okayToRealloc == 1) {
-                rt_ReallocLogVar(var, isVarDims);
-            } else {
-                /* Circular buffer */
-                var->rowIdx = 0;
-                ++(var->wrapped); /* increment the wrap around counter */
-            }
+            rt_MakeRoomInLogVar(var, isVarDims);
         }
 
         if(isVarDims){
@@ -3391,18 +4878,8 @@ void rt_UpdateLogVar(LogVar *var, const void *data, boolean_T isVarDims)
             var->currStrides[0] = 1;
 
             for (k = 1; k < nDims; k++){
-                int32_T currDimsVal=0;
-                switch (currDimsSizePtr[k-1]) {
-                  case 1:
-                    currDimsVal = (**(((const uint8_T * const *) currDimsPtr)+(k-1)));
-                    break;
-                  case 2:
-                    currDimsVal = (**(((const uint16_T * const *) currDimsPtr)+(k-1)));
-                    break;
-                  case 4:
-                    currDimsVal = (**(((const uint32_T * const *) currDimsPtr)+(k-1)));
-                    break;
-                }
+                int32_T currDimsVal = currDims ? currDims[k-1] :
+                    rt_GetCurrDimsValue(currDimsPtr, currDimsSizePtr, k-1);
                 var->strides[k] = var->strides[k-1] * dims[k-1];
                 var->currStrides[k] = var->currStrides[k-1] * currDimsVal;
             }
@@ -3430,18 +4907,8 @@ void rt_UpdateLogVar(LogVar *var, const void *data, boolean_T isVarDims)
                 int rem = j;
                 idx = 0;
                 for(k = nDims-1; k>=0; k--){
-                    int32_T currDimsVal=0;
-                    switch (currDimsSizePtr[k]) {
-                      case 1:
-                        currDimsVal = (**(((const uint8_T * const *) currDimsPtr)+k));
-                        break;
-                      case 2:
-                        currDimsVal = (**(((const uint16_T * const *) currDimsPtr)+k));
-                        break;
-                      case 4:
-                        currDimsVal = (**(((const uint32_T * const *) currDimsPtr)+k));
-                        break;
-                    }
+                    int32_T currDimsVal = currDims ? currDims[k] :
+                        rt_GetCurrDimsValue(currDimsPtr, currDimsSizePtr, k);
                     var->coords[k] = rem / var->strides[k];
                     if( var->coords[k] >= currDimsVal ){
                         inRange = false;
@@ -3776,18 +5243,8 @@ void rt_UpdateLogVar(LogVar *var, const void *data, boolean_T isVarDims)
 
         if(isVarDims){ /* update "valueDimensions" field */
             for(j = 0; j < logWidth_valDims; j ++){
-                int32_T currDimsVal=0;
-                switch (currDimsSizePtr[j]) {
-                  case 1:
-                    currDimsVal = (**(((const uint8_T * const *) currDimsPtr)+j));
-                    break;
-                  case 2:
-                    currDimsVal = (**(((const uint16_T * const *) currDimsPtr)+j));
-                    break;
-                  case 4:
-                    currDimsVal = (**(((const uint32_T * const *) currDimsPtr)+j));
-                    break;
-                }
+                int32_T currDimsVal = currDims ? currDims[j] :
+                    rt_GetCurrDimsValue(currDimsPtr, currDimsSizePtr, j);
                 offset_valDims  = (size_t)(elSize_valDims *( var->rowIdx + nRows_valDims * j));
                 currValDimsRow  = ((char_T*) (var->valDims->dimsData)) + offset_valDims;
 
@@ -3803,6 +5260,41 @@ void rt_UpdateLogVar(LogVar *var, const void *data, boolean_T isVarDims)
 
     return;
 
+} /* end rt_UpdateLogVarGeneric */
+
+
+/* Function: rt_UpdateLogVarImpl ===============================================
+ * Abstract:
+ *	Log data for a log variable in the calling thread.
+ */
+static void rt_UpdateLogVarImpl(LogVar          *var,
+                                const void      *data,
+                                boolean_T       isVarDims,
+                                const int32_T   *currDims)
+{
+    if (!isVarDims && var->copyPlan != LOG_COPY_GENERIC) {
+        rt_UpdateLogVarWithCopyPlan(var, data);
+    } else {
+        rt_UpdateLogVarGeneric(var, data, isVarDims, currDims);
+    }
+
+} /* end rt_UpdateLogVarImpl */
+
+
+/* Function: rt_UpdateLogVar ===================================================
+ * Abstract:
+ *	Called to log data for a log variable.
+ */
+void rt_UpdateLogVar(LogVar *var, const void *data, boolean_T isVarDims)
+{
+#if LOGGING_ASYNC_BUFFER_SIZE > 0
+    if (var->async != NULL && var->async->task != NULL) {
+        rt_LogAsyncUpdateLogVar(var, data, isVarDims);
+        return;
+    }
+#endif
+    rt_UpdateLogVarImpl(var, data, isVarDims, NULL);
+
 } /* end rt_UpdateLogVar */
 
 
@@ -4105,6 +5597,11 @@ const char_T *rt_UpdateTXXFYLogVars(RTWLogInfo *li, time_T *tPtr, boolean_T upda
             }
         }
     }
+#if LOGGING_ASYNC_BUFFER_SIZE > 0
+    if (logInfo->async.task != NULL) {
+        rt_LogAsyncEndStep(&logInfo->async);
+    }
+#endif
     return(NULL);
 } /* end rt_UpdateTXXFYLogVars */
 
@@ -4139,6 +5636,11 @@ void rt_StopDataLoggingImpl(const char_T *file, RTWLogInfo *li, boolean_T isRacc
     boolean_T     errFlag      = 0;
     const char_T  *msg;
 
+#if LOGGING_ASYNC_BUFFER_SIZE > 0
+    /* finish logging the queued data */
+    rt_LogAsyncStop(&logInfo->async);
+#endif
+
     /*******************************
      * Create MAT file with header *
      *******************************/
@@ -4245,6 +5747,8 @@ void rt_StopDataLoggingImpl(const char_T *file, RTWLogInfo *li, boolean_T isRacc
     logInfo->structLogVarsList = NULL;
     FREE(logInfo->y);
     logInfo->y = NULL;
+    rt_DestroyLogArena(&logInfo->arena);
+    rt_DestroyLogSpill(&logInfo->spill);
     FREE(logInfo);
     rtliSetLogInfo(li,NULL);
 
@@ -38,6 +38,10 @@
 typedef double MatReal;                /* "real" data type used in model.mat  */
 typedef struct LogVar_Tag LogVar;
 typedef struct StructLogVar_Tag StructLogVar;
+typedef struct LogStream_Tag LogStream;
+typedef struct LogArena_Tag LogArena;
+typedef struct LogSegment_Tag LogSegment;
+typedef struct LogAsyncQueue_Tag LogAsyncQueue;
 
 typedef struct MatrixData_Tag {
   char_T         name[mxMAXNAM];     /* Name of the variable                  */
@@ -67,8 +71,30 @@ typedef struct MatrixData_Tag {
   uint32_T       complex;            /* is this a complex matrix?             */
   uint32_T       frameData;          /* is this data frame based?             */
   uint32_T       frameSize;          /* is this data frame based?             */
+
+  LogStream      *stream;            /* spill file holding the rows that have
+                                        already been flushed to disk, NULL if
+                                        all the data is held in re/im        */
 } MatrixData;
 
+/*
+ * How rt_UpdateLogVar copies one row of a log variable. The plan is selected
+ * once, when the log variable is created.
+ */
+typedef enum {
+    LOG_COPY_GENERIC,   /* element by element, handles variable-size signals */
+    LOG_COPY_ROW,       /* the row is one contiguous block of the input      */
+    LOG_COPY_GATHER,    /* strided gather of frame based and/or complex data */
+    LOG_COPY_CONVERT    /* typed conversion kernels, see readFcn/writeFcn    */
+} LogCopyPlan;
+
+typedef void (*LogReadFcn)(double                      *dst,
+                           const char_T                *src,
+                           size_t                      srcStride,
+                           int_T                       n,
+                           const RTWLogDataTypeConvert *convert);
+typedef void (*LogWriteFcn)(void *dst, const double *src, int_T n);
+
 typedef struct ValDimsData_Tag {
   char_T         name[mxMAXNAM];     /* Name of the variable                  */
   int_T          nRows;              /* number of rows                        */
@@ -111,6 +137,26 @@ struct LogVar_Tag {
                                          (the size will be nDims in this case)
                                       */
 
+    LogArena   *arena;                /* arena that new segments of a growing
+                                         log variable are allocated from, NULL
+                                         if the buffers are grown by realloc  */
+    LogSegment *segments;             /* filled segments, oldest first. The
+                                         rows currently being logged are in
+                                         data.re/im. Previously logged rows are
+                                         never moved, the segments are joined
+                                         when the data is written out         */
+    LogSegment *lastSegment;
+    int_T      nSegmentRows;          /* number of rows in all the segments   */
+
+    LogAsyncQueue *async;             /* queue of the logging thread, NULL if
+                                         the variable is logged synchronously */
+
+    LogCopyPlan copyPlan;             /* how a row of input data is logged    */
+    size_t     srcPointSize;          /* bytes per (complex) input element    */
+    LogReadFcn  readFcn;              /* LOG_COPY_CONVERT: input => double    */
+    LogWriteFcn writeFcn;             /* LOG_COPY_CONVERT: double => logged   */
+    double     *convBuf;              /* LOG_COPY_CONVERT: one row of values  */
+
     LogVar    *next;
 };
 
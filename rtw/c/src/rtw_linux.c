@@ -1,8 +1,13 @@
 /* Copyright 2011-2019 The MathWorks, Inc. */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* pthread_setaffinity_np */
+#endif
 #include <pthread.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <semaphore.h>
+#include <sched.h>
+#include <time.h>
 #include "rtw_linux.h"
 
 #ifndef __USE_UNIX98
@@ -27,6 +32,8 @@ void rtw_pthread_mutex_init( void** mutexDW )
 
 typedef struct {
     void      (*func)(void);
+    void      (*funcWithArg)(void*);
+    void      *funcArg;
     sem_t     semaphore;
     sem_t     doneSema;
     pthread_t thread;
@@ -38,7 +45,12 @@ void* rtw_worker_task(void *arg_) {
     pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS,NULL);
     while (1) {
         sem_wait(&(arg->semaphore));
-        arg->func(); /* execute the task body */
+        /* execute the task body */
+        if (arg->func != NULL) {
+            arg->func();
+        } else {
+            arg->funcWithArg(arg->funcArg);
+        }
         sem_post(&(arg->doneSema));
     }
 }
@@ -48,6 +60,20 @@ void* rtw_register_task(void(*f)(void)){
   sem_init(&(arg->semaphore), 0, 0);
   sem_init(&(arg->doneSema), 0, 0);
   arg->func = f;
+  arg->funcWithArg = NULL;
+  arg->funcArg = NULL;
+  arg->isPrioritySet = 0;
+  pthread_create(&(arg->thread), NULL, rtw_worker_task, arg);
+  return arg;
+}
+
+void* rtw_register_task_with_arg(void(*f)(void*), void *funcArg){
+  pthread_task_T *arg = (pthread_task_T*)malloc(sizeof(pthread_task_T));
+  sem_init(&(arg->semaphore), 0, 0);
+  sem_init(&(arg->doneSema), 0, 0);
+  arg->func = NULL;
+  arg->funcWithArg = f;
+  arg->funcArg = funcArg;
   arg->isPrioritySet = 0;
   pthread_create(&(arg->thread), NULL, rtw_worker_task, arg);
   return arg;
@@ -66,10 +92,58 @@ void rtw_trigger_task(void *arg_){
   sem_post(&arg->semaphore);
 }
 
+/* Run the task at the lowest priority of the calling thread's policy, for
+ * background work that must not preempt the thread that triggers it. */
+void rtw_lower_task_priority(void *arg_){
+  pthread_task_T *arg= (pthread_task_T*) arg_;
+  int schedPolicy;
+  struct sched_param schedParam;
+  pthread_getschedparam(pthread_self(), &schedPolicy, &schedParam);
+  schedParam.sched_priority = sched_get_priority_min(schedPolicy);
+  pthread_setschedparam(arg->thread, schedPolicy, &schedParam);
+  arg->isPrioritySet = 1;
+}
+
+/* Set the scheduling policy and priority of a task, or of the calling
+ * thread if arg_ is NULL, and pin it to a CPU unless cpu is negative.
+ * Returns 0 on success, otherwise the error number. */
+int rtw_set_task_sched(void *arg_, int policy, int priority, int cpu){
+  pthread_task_T *arg = (pthread_task_T*) arg_;
+  pthread_t thread = (arg != NULL) ? arg->thread : pthread_self();
+  struct sched_param schedParam;
+  int s;
+  schedParam.sched_priority = priority;
+  s = pthread_setschedparam(thread, policy, &schedParam);
+  if (s == 0 && cpu >= 0) {
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+    s = pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpuSet);
+  }
+  if (s == 0 && arg != NULL) {
+    arg->isPrioritySet = 1;
+  }
+  return s;
+}
+
+/* Suspend the calling thread for nsec nanoseconds (less than a second). */
+void rtw_sleep(long nsec){
+  struct timespec ts;
+  ts.tv_sec  = 0;
+  ts.tv_nsec = nsec;
+  (void)nanosleep(&ts, NULL);
+}
+
 void rtw_waitfor_task(void *arg){
   sem_wait(&(((pthread_task_T *)arg)->doneSema));
 }
 
+/* Returns 1 if the task has completed since it was last waited for, without
+ * blocking. */
+int rtw_poll_task(void *arg){
+  return sem_trywait(&(((pthread_task_T *)arg)->doneSema)) == 0;
+}
+
 void rtw_deregister_task(void *arg_){
   int s;
   pthread_task_T *arg = arg_;
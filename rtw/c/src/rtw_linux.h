@@ -24,9 +24,14 @@ extern "C" {
 
 extern void rtw_pthread_mutex_init( void** mutexDW );        
 extern void* rtw_register_task(void (*)(void));
+extern void* rtw_register_task_with_arg(void (*)(void*), void*);
 extern void rtw_trigger_task(void*);
 extern void rtw_waitfor_task(void*);
+extern int rtw_poll_task(void*);
+extern int rtw_set_task_sched(void*, int, int, int);
 extern void rtw_deregister_task(void*);
+extern void rtw_lower_task_priority(void*);
+extern void rtw_sleep(long);
 
 #ifdef __cplusplus
 }
@@ -118,6 +118,18 @@ typedef struct _ssSolverInfo_tag {
     int_T       maskedZcDiagnostic;
     boolean_T   isOutputMethodComputed;
     int_T       reservedInt;
+
+    /* Optional sparsity pattern of df/dx in compressed columns, read by
+     * ode14x to group the difference Jacobian and use a sparse LU.  Only
+     * used when ode14x.c is compiled with RT_MALLOC; NULL (the default)
+     * keeps the dense solver.  No generated or shipped code sets it yet, so
+     * a target has to call rtsiSetSolverJacobianPatternJc/Ir itself. */
+    int_T*      jacobianPatternIr;
+    int_T*      jacobianPatternJc;
+
+    uint32_T    numJacobianEvaluations; /* implicit fixed-step solver stats */
+    uint32_T    numFactorizations;
+    uint32_T    numNewtonIterations;
 } ssSolverInfo;
 
 /* Support old name RTWSolverInfo */
@@ -219,6 +231,21 @@ typedef ssSolverInfo RTWSolverInfo;
 #define rtsiSetSolverMassMatrixPr(S,pr)  ((S)->massMatrixPr = (pr))
 #define rtsiGetSolverMassMatrixPr(S)  (S)->massMatrixPr
 
+#define rtsiSetSolverJacobianPatternIr(S,ir)  ((S)->jacobianPatternIr = (ir))
+#define rtsiGetSolverJacobianPatternIr(S)  (S)->jacobianPatternIr
+
+#define rtsiSetSolverJacobianPatternJc(S,jc)  ((S)->jacobianPatternJc = (jc))
+#define rtsiGetSolverJacobianPatternJc(S)  (S)->jacobianPatternJc
+
+#define rtsiSetSolverNumJacobianEvaluations(S,n) ((S)->numJacobianEvaluations = (n))
+#define rtsiGetSolverNumJacobianEvaluations(S)   (S)->numJacobianEvaluations
+
+#define rtsiSetSolverNumFactorizations(S,n) ((S)->numFactorizations = (n))
+#define rtsiGetSolverNumFactorizations(S)   (S)->numFactorizations
+
+#define rtsiSetSolverNumNewtonIterations(S,n) ((S)->numNewtonIterations = (n))
+#define rtsiGetSolverNumNewtonIterations(S)   (S)->numNewtonIterations
+
 #define rtsiSetdXPtr(S,dxp) ((S)->dXPtr = (dxp))
 #define rtsiSetdX(S,dx)     (*((S)->dXPtr) = (dx))
 #define rtsiGetdX(S)        *((S)->dXPtr)
@@ -0,0 +1,283 @@
+/* Copyright 2026 The MathWorks, Inc. */
+/*!
+ * @file
+ * Arena PmAllocator for deployed code.
+ *
+ * Allocations are carved from a buffer by bumping a pointer, so that the
+ * many small vectors created while a model is set up are contiguous and
+ * cost no system heap calls.  pm_allocator_free does not release memory;
+ * the arena is instead rewound to a checkpoint or reset as a whole.  The
+ * initial buffer may be supplied by the caller (for example a static array),
+ * further blocks are taken from an optional parent allocator when the arena
+ * runs out of space.
+ *
+ * Once the arena is sealed, typically at the end of model initialization,
+ * the parent allocator is no longer used and allocations that do not fit
+ * in the blocks the arena already owns fail.  With failOnAlloc set, every
+ * allocation after sealing fails.  In both cases the failures are counted
+ * and the allocation returns NULL.
+ *
+ * A separate arena per DAE keeps the outputs of one network together and
+ * lets each be rewound on its own, e.g.
+ *
+ *   static char buffer[65536];
+ *   PmArenaAllocator arena;
+ *   pm_arena_allocator_init(&arena, buffer, sizeof(buffer), NULL);
+ *   output = ne_dae_default_output(dae, id, &arena.mAllocator);
+ *   pm_arena_allocator_seal(&arena, false);
+ */
+
+#ifndef pm_arena_allocator_h
+#define pm_arena_allocator_h
+
+#include "pm_std.h"
+
+/* Size of the blocks requested from the parent allocator */
+#ifndef PM_ARENA_BLOCK_SIZE
+#define PM_ARENA_BLOCK_SIZE 16384
+#endif
+
+/* Every allocation is aligned for the most restrictive of these types */
+typedef union PmArenaAlignTag
+{
+    real_T mReal;
+    size_t mSize;
+    void*  mPtr;
+    long   mLong;
+} PmArenaAlign;
+
+#define PM_ARENA_ROUND_UP(_n) \
+    (((_n) + sizeof(PmArenaAlign) - 1) / sizeof(PmArenaAlign) * sizeof(PmArenaAlign))
+
+typedef struct PmArenaBlockTag PmArenaBlock;
+
+/* Header of a block, followed by mSize bytes of storage */
+struct PmArenaBlockTag
+{
+    PmArenaBlock* mNext;   /* next block in allocation order         */
+    size_t        mSize;   /* bytes of storage                       */
+    boolean_T     mOwned;  /* taken from the parent allocator        */
+};
+
+#define PM_ARENA_BLOCK_HEADER PM_ARENA_ROUND_UP(sizeof(PmArenaBlock))
+
+typedef struct PmArenaStatsTag
+{
+    size_t mCapacity;      /* bytes of storage in all blocks          */
+    size_t mBytesInUse;    /* bytes allocated since the last reset    */
+    size_t mPeakBytes;     /* largest value mBytesInUse has reached   */
+    size_t mNumAllocs;     /* successful allocations                  */
+    size_t mNumFrees;      /* calls to pm_allocator_free              */
+    size_t mNumFailures;   /* allocations that returned NULL          */
+    size_t mNumBlocks;     /* blocks taken from the parent allocator  */
+    size_t mNumLateAllocs; /* allocations attempted after sealing     */
+} PmArenaStats;
+
+typedef struct PmArenaAllocatorTag
+{
+    PmAllocator   mAllocator;   /* must be first                      */
+    PmAllocator*  mParent;      /* source of further blocks, or NULL  */
+    PmArenaBlock* mFirst;
+    PmArenaBlock* mBlock;       /* block allocations are taken from   */
+    size_t        mUsed;        /* bytes used in mBlock               */
+    boolean_T     mSealed;
+    boolean_T     mFailOnAlloc; /* fail every allocation once sealed  */
+    PmArenaStats  mStats;
+} PmArenaAllocator;
+
+typedef struct PmArenaCheckpointTag
+{
+    PmArenaBlock* mBlock;
+    size_t        mUsed;
+    size_t        mBytesInUse;
+} PmArenaCheckpoint;
+
+PMF_DEPLOY_STATIC void* pm_arena_block_data(PmArenaBlock* block)
+{
+    return (char*)block + PM_ARENA_BLOCK_HEADER;
+}
+
+/* Append a block taken from the parent allocator after the current one */
+PMF_DEPLOY_STATIC PmArenaBlock* pm_arena_add_block(PmArenaAllocator* arena,
+                                                   size_t            size)
+{
+    PmArenaBlock* block;
+
+    if (size < PM_ARENA_BLOCK_SIZE) {
+        size = PM_ARENA_BLOCK_SIZE;
+    }
+    block = (PmArenaBlock*)arena->mParent->mCallocFcn(
+        arena->mParent, PM_ARENA_BLOCK_HEADER + size, 1);
+    if (block == NULL) {
+        return NULL;
+    }
+    block->mSize  = size;
+    block->mOwned = true;
+    if (arena->mBlock == NULL) {
+        block->mNext  = arena->mFirst;
+        arena->mFirst = block;
+    } else {
+        block->mNext         = arena->mBlock->mNext;
+        arena->mBlock->mNext = block;
+    }
+    arena->mStats.mCapacity += size;
+    arena->mStats.mNumBlocks++;
+    return block;
+}
+
+PMF_DEPLOY_STATIC void*
+pm_arena_allocator_calloc(PmAllocator* allocator, size_t m, size_t n)
+{
+    PmArenaAllocator* arena = (PmArenaAllocator*)allocator;
+    PmArenaBlock*     block = arena->mBlock;
+    size_t            used  = arena->mUsed;
+    size_t            size;
+    void*             ptr;
+
+    if (arena->mSealed) {
+        arena->mStats.mNumLateAllocs++;
+    }
+    if ((n != 0 && m > ((size_t)-1 - sizeof(PmArenaAlign)) / n) ||
+        (arena->mSealed && arena->mFailOnAlloc)) {
+        arena->mStats.mNumFailures++;
+        return NULL;
+    }
+    size = PM_ARENA_ROUND_UP(m * n);
+
+    /* Move on to the next block the arena owns until one has room */
+    if (block == NULL) {
+        block = arena->mFirst;
+        used  = 0;
+    }
+    while (block != NULL && block->mSize - used < size) {
+        block = block->mNext;
+        used  = 0;
+    }
+    if (block == NULL) {
+        if (arena->mParent == NULL || arena->mSealed) {
+            arena->mStats.mNumFailures++;
+            return NULL;
+        }
+        block = pm_arena_add_block(arena, size);
+        if (block == NULL) {
+            arena->mStats.mNumFailures++;
+            return NULL;
+        }
+        used = 0;
+    }
+
+    arena->mBlock = block;
+    arena->mUsed  = used + size;
+    ptr           = (char*)pm_arena_block_data(block) + used;
+    memset(ptr, 0, size);
+
+    arena->mStats.mNumAllocs++;
+    arena->mStats.mBytesInUse += size;
+    if (arena->mStats.mBytesInUse > arena->mStats.mPeakBytes) {
+        arena->mStats.mPeakBytes = arena->mStats.mBytesInUse;
+    }
+    return ptr;
+}
+
+/* Memory is only released by pm_arena_allocator_rewind */
+PMF_DEPLOY_STATIC void pm_arena_allocator_free(PmAllocator* allocator, void* ptr)
+{
+    PmArenaAllocator* arena = (PmArenaAllocator*)allocator;
+
+    (void)ptr;
+    arena->mStats.mNumFrees++;
+}
+
+/*
+  Initialize an arena on the given buffer, which may be NULL.  parent, if
+  not NULL, provides further blocks until the arena is sealed.
+ */
+PMF_DEPLOY_STATIC void pm_arena_allocator_init(PmArenaAllocator* arena,
+                                               void*             buffer,
+                                               size_t            size,
+                                               PmAllocator*      parent)
+{
+    memset(arena, 0, sizeof(*arena));
+    arena->mAllocator.mCallocFcn = &pm_arena_allocator_calloc;
+    arena->mAllocator.mFreeFcn   = &pm_arena_allocator_free;
+    arena->mParent               = parent;
+
+    /* The buffer must hold the block header and be aligned for it */
+    if (buffer != NULL) {
+        size_t skip =
+            (sizeof(PmArenaAlign) - (size_t)buffer % sizeof(PmArenaAlign)) %
+            sizeof(PmArenaAlign);
+        if (size > skip + PM_ARENA_BLOCK_HEADER) {
+            PmArenaBlock* block = (PmArenaBlock*)((char*)buffer + skip);
+            block->mNext        = NULL;
+            block->mSize        = (size - skip - PM_ARENA_BLOCK_HEADER) /
+                           sizeof(PmArenaAlign) * sizeof(PmArenaAlign);
+            block->mOwned           = false;
+            arena->mFirst           = block;
+            arena->mStats.mCapacity = block->mSize;
+        }
+    }
+}
+
+/* Stop taking blocks from the parent allocator */
+PMF_DEPLOY_STATIC void pm_arena_allocator_seal(PmArenaAllocator* arena,
+                                               boolean_T         failOnAlloc)
+{
+    arena->mSealed      = true;
+    arena->mFailOnAlloc = failOnAlloc;
+}
+
+PMF_DEPLOY_STATIC PmArenaCheckpoint
+pm_arena_allocator_checkpoint(const PmArenaAllocator* arena)
+{
+    PmArenaCheckpoint checkpoint;
+
+    checkpoint.mBlock      = arena->mBlock;
+    checkpoint.mUsed       = arena->mUsed;
+    checkpoint.mBytesInUse = arena->mStats.mBytesInUse;
+    return checkpoint;
+}
+
+/* Release everything allocated since the checkpoint.  The blocks are kept
+ * for later allocations. */
+PMF_DEPLOY_STATIC void pm_arena_allocator_rewind(PmArenaAllocator*        arena,
+                                                 const PmArenaCheckpoint* checkpoint)
+{
+    arena->mBlock             = checkpoint->mBlock;
+    arena->mUsed              = checkpoint->mUsed;
+    arena->mStats.mBytesInUse = checkpoint->mBytesInUse;
+}
+
+/* Release everything allocated */
+PMF_DEPLOY_STATIC void pm_arena_allocator_reset(PmArenaAllocator* arena)
+{
+    arena->mBlock             = NULL;
+    arena->mUsed              = 0;
+    arena->mStats.mBytesInUse = 0;
+}
+
+PMF_DEPLOY_STATIC void pm_arena_allocator_get_stats(const PmArenaAllocator* arena,
+                                                    PmArenaStats*           stats)
+{
+    *stats = arena->mStats;
+}
+
+/* Return the blocks taken from the parent allocator */
+PMF_DEPLOY_STATIC void pm_arena_allocator_destroy(PmArenaAllocator* arena)
+{
+    PmArenaBlock* block = arena->mFirst;
+    PmArenaBlock* next;
+
+    while (block != NULL) {
+        next = block->mNext;
+        if (block->mOwned) {
+            arena->mParent->mFreeFcn(arena->mParent, block);
+        }
+        block = next;
+    }
+    memset(arena, 0, sizeof(*arena));
+}
+
+#endif /* include guard */
+
+/* [EOF] pm_arena_allocator.h */
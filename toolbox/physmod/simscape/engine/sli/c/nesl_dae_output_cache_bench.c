@@ -0,0 +1,160 @@
+/* Copyright 2026 The MathWorks, Inc. */
+/*!
+ * @file
+ * Benchmark of the DAE method output cache of nesl_dae_output_cache.h.
+ *
+ * A mock DAE whose F method writes an N element residual is evaluated
+ * NESL_BENCH_CALLS times, first with ne_dae_method_output and
+ * ne_dae_default_output_free around every call, then through a
+ * NeDaeOutputCache with the modes toggled every NESL_BENCH_MODE_PERIOD
+ * calls.  Both loops use a heap allocator that counts its calls.
+ *
+ * Build against the headers of one platform and the rtwtypes.h of a
+ * generated model (in $B), e.g. on glnxa64 with P set to toolbox/physmod:
+ *
+ *   cc -O2 -DN=200 -Iglnxa64 -I$P/simscape/compiler/core/c/glnxa64 \
+ *      -I$P/network_engine/c/glnxa64 -I$B \
+ *      -I$P/common/foundation/core/c/glnxa64 \
+ *      -I$P/common/math/core/c/glnxa64 \
+ *      -Isimulink/include -Iextern/include \
+ *      nesl_dae_output_cache_bench.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "nesl_dae_output_cache.h"
+
+#ifndef N
+#define N 200 /* residual length */
+#endif
+
+#ifndef NESL_BENCH_CALLS
+#define NESL_BENCH_CALLS 2000000L
+#endif
+
+#ifndef NESL_BENCH_MODE_PERIOD
+#define NESL_BENCH_MODE_PERIOD 100000L
+#endif
+
+static size_t sNumAllocs;
+
+static void* bench_calloc(PmAllocator* allocator, size_t m, size_t n)
+{
+    (void)allocator;
+    ++sNumAllocs;
+    return calloc(m, n);
+}
+
+static void bench_free(PmAllocator* allocator, void* ptr)
+{
+    (void)allocator;
+    free(ptr);
+}
+
+static PmAllocator sHeap = {bench_calloc, bench_free};
+
+static NeDaeMethodOutput* bench_make_f(const NeDae* dae, PmAllocator* allocator)
+{
+    NeDaeMethodOutput* output =
+        (NeDaeMethodOutput*)pm_allocator_alloc(allocator, sizeof(NeDaeMethodOutput), 1);
+    (void)dae;
+    output->mF.mN = N;
+    output->mF.mX = (real_T*)pm_allocator_alloc(allocator, sizeof(real_T), N);
+    return output;
+}
+
+static void bench_free_f(NeDaeMethodOutput* output, PmAllocator* allocator)
+{
+    pm_allocator_free(allocator, output->mF.mX);
+    pm_allocator_free(allocator, output);
+}
+
+/* Accumulates into the output, so stale values would show in the result */
+static PmfMessageId bench_f(const NeDae*          dae,
+                            const NeSystemInput*  input,
+                            NeDaeMethodOutput*    output,
+                            NeuDiagnosticManager* mgr)
+{
+    size_t i;
+    (void)dae;
+    (void)mgr;
+    for (i = 0; i < N; i++) {
+        output->mF.mX[i] +=
+            input->mX.mX[i % input->mX.mN] + (input->mM.mX[0] ? 1.0 : 0.0);
+    }
+    return NULL;
+}
+
+static double bench_rate(clock_t start)
+{
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    return (double)NESL_BENCH_CALLS / seconds / 1e6;
+}
+
+int main(void)
+{
+    static NeDae       dae;
+    NeSystemInput      input;
+    NeDaeOutputCache   cache;
+    NeDaeMethodId      ids[1];
+    NeDaeMethodOutput* output;
+    real_T             x[N];
+    int32_T            q[1] = {0};
+    int32_T            m[1] = {0};
+    double             sum  = 0.0;
+    clock_t            start;
+    long               it;
+    int                i;
+
+    for (i = 0; i < N; i++) {
+        x[i] = i;
+    }
+    memset(&input, 0, sizeof(input));
+    input.mX.mN = N;
+    input.mX.mX = x;
+    input.mQ.mN = 1;
+    input.mQ.mX = q;
+    input.mM.mN = 1;
+    input.mM.mX = m;
+
+    dae.mNumModes                    = 1;
+    dae.mNumMajorModes               = 1;
+    dae.mMethods[NE_DAE_METHOD_F]    = bench_f;
+    dae.mMakeOutput[NE_DAE_METHOD_F] = bench_make_f;
+    dae.mFreeOutput[NE_DAE_METHOD_F] = bench_free_f;
+
+    /* a new output for every call */
+    start = clock();
+    for (it = 0; it < NESL_BENCH_CALLS; it++) {
+        output = ne_dae_method_output(&dae, NE_DAE_METHOD_F, &input, NULL, &sHeap);
+        sum += output->mF.mX[7];
+        ne_dae_default_output_free(&dae, output, NE_DAE_METHOD_F, &sHeap);
+    }
+    printf("make/free: %.2f Mcalls/s, %lu allocations (sum %g)\n",
+           bench_rate(start), (unsigned long)sNumAllocs, sum);
+
+    /* one cached output, cleared on mode changes */
+    sNumAllocs = 0;
+    sum        = 0.0;
+    ids[0]     = NE_DAE_METHOD_F;
+    ne_dae_output_cache_create(&cache, &dae, &sHeap, ids, 1);
+    start = clock();
+    for (it = 0; it < NESL_BENCH_CALLS; it++) {
+        if (it % NESL_BENCH_MODE_PERIOD == 0) {
+            m[0] = !m[0];
+        }
+        output = ne_dae_cached_method_output(&cache, NE_DAE_METHOD_F, &input, NULL);
+        sum += output->mF.mX[7];
+        output->mF.mX[7] = 0.0;
+    }
+    printf("cached:    %.2f Mcalls/s, %lu allocations, %lu makes, %lu reuses, "
+           "%lu clears (sum %g)\n",
+           bench_rate(start), (unsigned long)sNumAllocs,
+           (unsigned long)cache.mNumMakes, (unsigned long)cache.mNumReuses,
+           (unsigned long)cache.mNumClears, sum);
+    ne_dae_output_cache_destroy(&cache);
+
+    return 0;
+}
@@ -0,0 +1,251 @@
+/* Copyright 2026 The MathWorks, Inc. */
+/*!
+ * @file
+ * Reusable DAE method outputs for deployed code.
+ *
+ * ne_dae_method_output makes a new NeDaeMethodOutput for every evaluation,
+ * which the caller frees again.  A NeDaeOutputCache keeps one output per
+ * method of a DAE for its lifetime instead, so that evaluating F, DXF, Y,
+ * etc. in the solver loop makes no allocator calls.  The outputs are made
+ * with the DAE's own mMakeOutput functions, so they have the size the DAE
+ * declares, either up front in ne_dae_output_cache_create or on first use.
+ *
+ * The outputs depend on the modes of the system input.  When
+ * ne_dae_cached_method_output sees modes that differ from the previous
+ * call, the values of all cached outputs are cleared before the method is
+ * evaluated, as they would be in a newly made output.
+ */
+
+#ifndef nesl_dae_output_cache_h
+#define nesl_dae_output_cache_h
+
+#include "ne_dae.h"
+
+#ifndef pm_allocator_alloc
+#define pm_allocator_alloc(_allocator, _m, _n) \
+    ((_allocator)->mCallocFcn((_allocator), (_m), (_n)))
+#endif
+
+#ifndef pm_allocator_free
+#define pm_allocator_free(_allocator, _ptr)                          \
+    {                                                                \
+        void* __allocator_pointer = (_ptr);                          \
+        if (__allocator_pointer != 0) {                              \
+            (_allocator)->mFreeFcn(_allocator, __allocator_pointer); \
+        }                                                            \
+    }
+#endif
+
+typedef struct NeDaeOutputCacheTag
+{
+    const NeDae*       mDae;
+    PmAllocator*       mAllocator;
+    NeDaeMethodOutput* mOutputs[NE_NUM_DAE_METHODS];
+    PmIntVector        mQ;         /* modes the outputs were computed for */
+    PmIntVector        mM;
+    boolean_T          mHaveModes;
+    size_t             mNumMakes;  /* outputs made                        */
+    size_t             mNumReuses; /* evaluations into an existing output */
+    size_t             mNumClears; /* mode changes clearing the outputs   */
+} NeDaeOutputCache;
+
+/* Member of NeDaeMethodOutput written by each method */
+typedef enum NeDaeOutputKindTag
+{
+    NE_DAE_OUTPUT_PATTERN,
+    NE_DAE_OUTPUT_REAL,
+    NE_DAE_OUTPUT_INT,
+    NE_DAE_OUTPUT_BOOL
+} NeDaeOutputKind;
+
+PMF_DEPLOY_STATIC NeDaeOutputKind ne_dae_output_kind(NeDaeMethodId id)
+{
+    static const NeDaeOutputKind kinds[NE_NUM_DAE_METHODS] = {
+        NE_DAE_OUTPUT_PATTERN, /* M_P          */
+        NE_DAE_OUTPUT_REAL,    /* M            */
+        NE_DAE_OUTPUT_PATTERN, /* DXM_P        */
+        NE_DAE_OUTPUT_REAL,    /* DXM          */
+        NE_DAE_OUTPUT_PATTERN, /* DUM_P        */
+        NE_DAE_OUTPUT_REAL,    /* DUM          */
+        NE_DAE_OUTPUT_REAL,    /* F            */
+        NE_DAE_OUTPUT_PATTERN, /* DXF_P        */
+        NE_DAE_OUTPUT_REAL,    /* DXF          */
+        NE_DAE_OUTPUT_PATTERN, /* DUF_P        */
+        NE_DAE_OUTPUT_REAL,    /* DUF          */
+        NE_DAE_OUTPUT_PATTERN, /* DTF_P        */
+        NE_DAE_OUTPUT_REAL,    /* DTF          */
+        NE_DAE_OUTPUT_REAL,    /* Y            */
+        NE_DAE_OUTPUT_PATTERN, /* DXY_P        */
+        NE_DAE_OUTPUT_REAL,    /* DXY          */
+        NE_DAE_OUTPUT_PATTERN, /* DUY_P        */
+        NE_DAE_OUTPUT_PATTERN, /* TDUY_P       */
+        NE_DAE_OUTPUT_REAL,    /* DUY          */
+        NE_DAE_OUTPUT_REAL,    /* XP0          */
+        NE_DAE_OUTPUT_REAL,    /* ZC           */
+        NE_DAE_OUTPUT_INT,     /* ASSERT       */
+        NE_DAE_OUTPUT_INT,     /* PASSERT      */
+        NE_DAE_OUTPUT_INT,     /* IASSERT      */
+        NE_DAE_OUTPUT_REAL,    /* SO           */
+        NE_DAE_OUTPUT_REAL,    /* SP           */
+        NE_DAE_OUTPUT_INT,     /* MODE         */
+        NE_DAE_OUTPUT_INT,     /* UDOT_REQ     */
+        NE_DAE_OUTPUT_REAL,    /* DELAYS       */
+        NE_DAE_OUTPUT_BOOL,    /* DXF_V_X      */
+        NE_DAE_OUTPUT_BOOL,    /* DUF_V_X      */
+        NE_DAE_OUTPUT_REAL,    /* OBS_EXP      */
+        NE_DAE_OUTPUT_REAL,    /* OBS_ACT      */
+        NE_DAE_OUTPUT_REAL,    /* EQ_TOL       */
+        NE_DAE_OUTPUT_INT,     /* STIFF        */
+        NE_DAE_OUTPUT_REAL,    /* NUMJAC_DX_LO */
+        NE_DAE_OUTPUT_REAL,    /* NUMJAC_DX_HI */
+        NE_DAE_OUTPUT_REAL     /* STIFF_IND    */
+    };
+    return kinds[id];
+}
+
+/* Output of method id, made on first use */
+PMF_DEPLOY_STATIC NeDaeMethodOutput*
+ne_dae_cached_output(NeDaeOutputCache* cache, NeDaeMethodId id)
+{
+    if (cache->mOutputs[id] == NULL) {
+        cache->mOutputs[id] =
+            ne_dae_default_output(cache->mDae, id, cache->mAllocator);
+        cache->mNumMakes++;
+    }
+    return cache->mOutputs[id];
+}
+
+/*
+  Make the cache of a DAE and the outputs of the numIds methods in ids, so
+  that these need no allocation later.  ids may be NULL.
+ */
+PMF_DEPLOY_STATIC void ne_dae_output_cache_create(NeDaeOutputCache*    cache,
+                                                  const NeDae*         dae,
+                                                  PmAllocator*         allocator,
+                                                  const NeDaeMethodId* ids,
+                                                  size_t               numIds)
+{
+    size_t i;
+
+    memset(cache, 0, sizeof(*cache));
+    cache->mDae       = dae;
+    cache->mAllocator = allocator;
+    cache->mQ.mN      = dae->mNumMajorModes;
+    cache->mQ.mX      = (int32_T*)pm_allocator_alloc(
+        allocator, sizeof(int32_T), dae->mNumMajorModes);
+    cache->mM.mN = dae->mNumModes;
+    cache->mM.mX =
+        (int32_T*)pm_allocator_alloc(allocator, sizeof(int32_T), dae->mNumModes);
+
+    for (i = 0; i < numIds; i++) {
+        ne_dae_cached_output(cache, ids[i]);
+    }
+}
+
+/* Clear the values of all outputs, keeping their storage */
+PMF_DEPLOY_STATIC void ne_dae_output_cache_clear(NeDaeOutputCache* cache)
+{
+    int32_T            id;
+    NeDaeMethodOutput* output;
+
+    for (id = 0; id < NE_NUM_DAE_METHODS; id++) {
+        output = cache->mOutputs[id];
+        if (output == NULL) {
+            continue;
+        }
+        /* Patterns are evaluated completely by their methods */
+        switch (ne_dae_output_kind((NeDaeMethodId)id)) {
+          case NE_DAE_OUTPUT_REAL:
+            memset(output->mM.mX, 0, output->mM.mN * sizeof(real_T));
+            break;
+          case NE_DAE_OUTPUT_INT:
+            memset(output->mASSERT.mX, 0, output->mASSERT.mN * sizeof(int32_T));
+            break;
+          case NE_DAE_OUTPUT_BOOL:
+            memset(output->mDXF_V_X.mX,
+                   0,
+                   output->mDXF_V_X.mN * sizeof(boolean_T));
+            break;
+          default:
+            break;
+        }
+    }
+    cache->mNumClears++;
+}
+
+/* Remember the modes of input, returns whether they differ from the modes
+ * of the previous call */
+PMF_DEPLOY_STATIC boolean_T
+ne_dae_output_cache_update_modes(NeDaeOutputCache* cache, const NeSystemInput* input)
+{
+    boolean_T first   = !cache->mHaveModes;
+    boolean_T changed = first;
+
+    if (!changed && cache->mQ.mN > 0) {
+        changed = (boolean_T)(memcmp(cache->mQ.mX,
+                                     input->mQ.mX,
+                                     cache->mQ.mN * sizeof(int32_T)) != 0);
+    }
+    if (!changed && cache->mM.mN > 0) {
+        changed = (boolean_T)(memcmp(cache->mM.mX,
+                                     input->mM.mX,
+                                     cache->mM.mN * sizeof(int32_T)) != 0);
+    }
+    if (changed) {
+        if (cache->mQ.mN > 0) {
+            memcpy(cache->mQ.mX, input->mQ.mX, cache->mQ.mN * sizeof(int32_T));
+        }
+        if (cache->mM.mN > 0) {
+            memcpy(cache->mM.mX, input->mM.mX, cache->mM.mN * sizeof(int32_T));
+        }
+        cache->mHaveModes = true;
+    }
+    return (boolean_T)(changed && !first);
+}
+
+/*
+  Evaluate method id into its cached output, the replacement for
+  ne_dae_method_output.  The output remains owned by the cache and is
+  overwritten by the next evaluation of the same method.
+ */
+PMF_DEPLOY_STATIC NeDaeMethodOutput*
+ne_dae_cached_method_output(NeDaeOutputCache*     cache,
+                            NeDaeMethodId         id,
+                            const NeSystemInput*  input,
+                            NeuDiagnosticManager* mgr)
+{
+    NeDaeMethodOutput* daeOutput;
+
+    if (ne_dae_output_cache_update_modes(cache, input)) {
+        ne_dae_output_cache_clear(cache);
+    }
+    if (cache->mOutputs[id] != NULL) {
+        cache->mNumReuses++;
+    }
+    daeOutput = ne_dae_cached_output(cache, id);
+    ne_dae_call_method(cache->mDae, id, input, daeOutput, mgr);
+    return daeOutput;
+}
+
+PMF_DEPLOY_STATIC void ne_dae_output_cache_destroy(NeDaeOutputCache* cache)
+{
+    int32_T id;
+
+    for (id = 0; id < NE_NUM_DAE_METHODS; id++) {
+        if (cache->mOutputs[id] != NULL) {
+            ne_dae_default_output_free(cache->mDae,
+                                       cache->mOutputs[id],
+                                       (NeDaeMethodId)id,
+                                       cache->mAllocator);
+            cache->mOutputs[id] = NULL;
+        }
+    }
+    pm_allocator_free(cache->mAllocator, cache->mQ.mX);
+    pm_allocator_free(cache->mAllocator, cache->mM.mX);
+    cache->mQ.mX = NULL;
+    cache->mM.mX = NULL;
+}
+
+#endif /* include guard */
+
+/* [EOF] nesl_dae_output_cache.h */
@@ -23,6 +23,12 @@
         }                                                            \
     }
 #endif
+
+/* Allocator used by default, a target may route it to an arena, see
+ * pm_arena_allocator.h */
+#ifndef NESL_DEFAULT_ALLOCATOR
+#define NESL_DEFAULT_ALLOCATOR() pm_default_allocator()
+#endif
 /*
  * UNUSED_PARAMETER(x)
  *   Used to specify that a function parameter (argument) is required but not
@@ -40,6 +46,66 @@
 #endif
 #endif
 
+/*
+ * Instrumentation
+ *
+ * With NESL_LA_PROFILE defined, every linear algebra instance created by
+ * get_rtw_linear_algebra counts its factorizations and solves, accumulates
+ * the time spent in them and tracks its allocations through a counting
+ * PmAllocator.  The statistics are available through rtw_linalg_get_stats
+ * and are printed when the instance is destroyed, unless
+ * NESL_LA_PROFILE_DISABLEPRINTF is defined.  Instances of other factories,
+ * such as the CSparse instances get_auto_linear_algebra creates for
+ * patterns it does not factor densely, are not profiled.  NESL_LA_PROFILE_TIME() may be
+ * defined to use a target specific timer, it returns seconds.
+ */
+#ifdef NESL_LA_PROFILE
+#include <stdio.h>
+#include <time.h>
+
+#ifndef NESL_LA_PROFILE_TIME
+#define NESL_LA_PROFILE_TIME() ((real_T)clock() / (real_T)CLOCKS_PER_SEC)
+#endif
+
+typedef struct NeslLaStatsTag
+{
+    uint32_T mNumFactor;    /* calls to mFactor                          */
+    uint32_T mNumRefactor;  /* sparse factorizations reusing the pivots  */
+    uint32_T mNumRepivot;   /* sparse factorizations that pivoted again  */
+    uint32_T mNumSingular;  /* factorizations returning MC_LA_ERROR      */
+    uint32_T mNumSolve;     /* calls to mSolve                           */
+    real_T   mFactorTime;   /* seconds spent in mFactor                  */
+    real_T   mSolveTime;    /* seconds spent in mSolve                   */
+    size_t   mBytesInUse;   /* bytes allocated, excluding bookkeeping    */
+    size_t   mPeakBytes;    /* largest value mBytesInUse has reached     */
+    uint32_T mNumAllocs;    /* allocations through the instance          */
+} NeslLaStats;
+
+typedef struct NeslLaProfileTag
+{
+    PmAllocator  mAllocator; /* counting allocator, must be first */
+    PmAllocator* mParent;
+    McLinearAlgebraStatus (*mFactor)(McLinearAlgebra*, const real_T*);
+    McLinearAlgebraStatus (*mSolve)(McLinearAlgebra*,
+                                    const real_T*,
+                                    real_T*,
+                                    const real_T*);
+    boolean_T   mSparse;
+    NeslLaStats mStats;
+} NeslLaProfile;
+
+#define NESL_LA_PROFILE_COUNT(_ne_la_data, _counter)                    \
+    do {                                                               \
+        PmAllocator* profileAllocator_ = (_ne_la_data)->mAllocatorPtr; \
+        if (profileAllocator_->mCallocFcn ==                           \
+            &rtw_linalg_profile_calloc) {                              \
+            ((NeslLaProfile*)profileAllocator_)->mStats._counter++;    \
+        }                                                              \
+    } while (0)
+#else
+#define NESL_LA_PROFILE_COUNT(_ne_la_data, _counter) /* do nothing */
+#endif
+
 struct McLinearAlgebraDataTag
 {
     int32_T                  mNumRow;
@@ -49,6 +115,21 @@ struct McLinearAlgebraDataTag
     int32_T*                 mPivotIndices;
     PmAllocator*             mAllocatorPtr;
     const PmSparsityPattern* mSparsityPatternPtr;
+
+    /* Sparse LU only, see rtw_linalg_sparse_create_data */
+    int32_T*  mColPerm;    /* column of A factored at step k        */
+    int32_T*  mDiagRow;    /* row matched to column j               */
+    int32_T*  mRowPermInv; /* step at which row i became pivotal    */
+    int32_T*  mIntWork;    /* 3*n: reach result, DFS stack, marks   */
+    int32_T*  mLp;
+    int32_T*  mLi;
+    real_T*   mLx;
+    int32_T   mLCapacity;
+    int32_T*  mUp;
+    int32_T*  mUi;
+    real_T*   mUx;
+    int32_T   mUCapacity;
+    boolean_T mHaveFactor; /* patterns of L and U can be reused     */
 };
 
 /* Populate full column major matrix from sparsity pattern. Memory is NOT
@@ -186,11 +267,154 @@ size_t rtw_linalg_memusage(const McLinearAlgebra* ne_la)
         ((numrow < numcol) ? numrow : numcol) * sizeof(int32_T);
 }
 
+#ifdef NESL_LA_PROFILE
+/* Every allocation of the counting allocator starts with its size */
+typedef union NeslLaProfileHeaderTag
+{
+    size_t mSize;
+    real_T mAlign;
+} NeslLaProfileHeader;
+
+PMF_DEPLOY_STATIC void*
+rtw_linalg_profile_calloc(PmAllocator* allocator, size_t m, size_t n)
+{
+    NeslLaProfile*       prof = (NeslLaProfile*)allocator;
+    NeslLaProfileHeader* hdr;
+
+    if (n != 0 && m > ((size_t)-1 - sizeof(NeslLaProfileHeader)) / n) {
+        return NULL;
+    }
+    hdr = (NeslLaProfileHeader*)pm_allocator_alloc(
+        prof->mParent, sizeof(NeslLaProfileHeader) + m * n, 1);
+    if (hdr == NULL) {
+        return NULL;
+    }
+    hdr->mSize = m * n;
+    prof->mStats.mNumAllocs++;
+    prof->mStats.mBytesInUse += hdr->mSize;
+    if (prof->mStats.mBytesInUse > prof->mStats.mPeakBytes) {
+        prof->mStats.mPeakBytes = prof->mStats.mBytesInUse;
+    }
+    return hdr + 1;
+}
+
+PMF_DEPLOY_STATIC void rtw_linalg_profile_free(PmAllocator* allocator, void* ptr)
+{
+    NeslLaProfile*       prof = (NeslLaProfile*)allocator;
+    NeslLaProfileHeader* hdr  = (NeslLaProfileHeader*)ptr - 1;
+
+    prof->mStats.mBytesInUse -= hdr->mSize;
+    pm_allocator_free(prof->mParent, hdr);
+}
+
+/* Create the counting allocator of a new instance */
+PMF_DEPLOY_STATIC NeslLaProfile* rtw_linalg_profile_create(PmAllocator* parent)
+{
+    NeslLaProfile* prof =
+        (NeslLaProfile*)pm_allocator_alloc(parent, sizeof(NeslLaProfile), 1);
+
+    prof->mAllocator.mCallocFcn = &rtw_linalg_profile_calloc;
+    prof->mAllocator.mFreeFcn   = &rtw_linalg_profile_free;
+    prof->mParent               = parent;
+    return prof;
+}
+
+PMF_DEPLOY_STATIC McLinearAlgebraStatus
+rtw_linalg_profile_factor(McLinearAlgebra* ne_la, const real_T* Ax)
+{
+    NeslLaProfile*        prof =
+        (NeslLaProfile*)ne_la->mPrivateData->mAllocatorPtr;
+    real_T                start  = NESL_LA_PROFILE_TIME();
+    McLinearAlgebraStatus result = prof->mFactor(ne_la, Ax);
+
+    prof->mStats.mFactorTime += NESL_LA_PROFILE_TIME() - start;
+    prof->mStats.mNumFactor++;
+    if (result != MC_LA_OK) {
+        prof->mStats.mNumSingular++;
+    }
+    return result;
+}
+
+PMF_DEPLOY_STATIC McLinearAlgebraStatus
+rtw_linalg_profile_solve(McLinearAlgebra* ne_la,
+                         const real_T*    Ax,
+                         real_T*          dy,
+                         const real_T*    B)
+{
+    NeslLaProfile*        prof =
+        (NeslLaProfile*)ne_la->mPrivateData->mAllocatorPtr;
+    real_T                start  = NESL_LA_PROFILE_TIME();
+    McLinearAlgebraStatus result = prof->mSolve(ne_la, Ax, dy, B);
+
+    prof->mStats.mSolveTime += NESL_LA_PROFILE_TIME() - start;
+    prof->mStats.mNumSolve++;
+    return result;
+}
+
+/* Statistics of an instance created by get_rtw_linear_algebra.  Returns
+ * false with zeroed statistics for any other instance, whose private data
+ * need not even be a McLinearAlgebraData. */
+PMF_DEPLOY_STATIC boolean_T rtw_linalg_get_stats(const McLinearAlgebra* ne_la,
+                                                 NeslLaStats*           stats)
+{
+    if (ne_la->mFactor != &rtw_linalg_profile_factor) {
+        memset(stats, 0, sizeof(NeslLaStats));
+        return false;
+    }
+    *stats = ((const NeslLaProfile*)ne_la->mPrivateData->mAllocatorPtr)->mStats;
+    return true;
+}
+
+/* Print the statistics of an instance about to be destroyed */
+PMF_DEPLOY_STATIC void rtw_linalg_report(const McLinearAlgebra* ne_la)
+{
+#ifndef NESL_LA_PROFILE_DISABLEPRINTF
+    const McLinearAlgebraData* ne_la_data = ne_la->mPrivateData;
+    const NeslLaProfile*       prof =
+        (const NeslLaProfile*)ne_la_data->mAllocatorPtr;
+    const NeslLaStats*         stats = &prof->mStats;
+
+    printf("\nSimscape linear algebra (%s, %ld equations, %ld nonzeros):\n",
+           prof->mSparse ? "sparse LU" : "dense LU",
+           (long)ne_la_data->mNumCol,
+           (long)ne_la_data->mSparsityPatternPtr
+               ->mJc[ne_la_data->mSparsityPatternPtr->mNumCol]);
+    printf("  %lu factorizations, %lu singular, %g s.\n",
+           (unsigned long)stats->mNumFactor,
+           (unsigned long)stats->mNumSingular,
+           stats->mFactorTime);
+    if (prof->mSparse) {
+        printf("  %lu reused the pivot sequence, %lu pivoted again.\n",
+               (unsigned long)stats->mNumRefactor,
+               (unsigned long)stats->mNumRepivot);
+    }
+    printf("  %lu solves, %g s.\n",
+           (unsigned long)stats->mNumSolve,
+           stats->mSolveTime);
+    printf("  memory usage %lu bytes, peak allocated %lu bytes in %lu "
+           "allocations.\n",
+           (unsigned long)ne_la->mMemusage(ne_la),
+           (unsigned long)stats->mPeakBytes,
+           (unsigned long)stats->mNumAllocs);
+#else
+    UNUSED_PARAMETER(ne_la);
+#endif
+}
+
+PMF_DEPLOY_STATIC void rtw_linalg_profile_destroy(NeslLaProfile* prof)
+{
+    pm_allocator_free(prof->mParent, prof);
+}
+#endif
+
 PMF_DEPLOY_STATIC void rtw_linalg_destroy(McLinearAlgebra* ne_la)
 {
     McLinearAlgebraData* ne_la_data = ne_la->mPrivateData;
     PmAllocator*         alloc      = ne_la_data->mAllocatorPtr;
 
+#ifdef NESL_LA_PROFILE
+    rtw_linalg_report(ne_la);
+#endif
     pm_allocator_free(alloc, ne_la_data->mLU);
     ne_la_data->mLU = NULL;
     pm_allocator_free(alloc, ne_la_data->mLinvB);
@@ -199,9 +423,702 @@ PMF_DEPLOY_STATIC void rtw_linalg_destroy(McLinearAlgebra* ne_la)
     pm_allocator_free(alloc, ne_la_data->mPivotIndices);
     ne_la_data->mPivotIndices = NULL;
 
+    pm_allocator_free(alloc, ne_la_data->mColPerm);
+    pm_allocator_free(alloc, ne_la_data->mDiagRow);
+    pm_allocator_free(alloc, ne_la_data->mRowPermInv);
+    pm_allocator_free(alloc, ne_la_data->mIntWork);
+    pm_allocator_free(alloc, ne_la_data->mLp);
+    pm_allocator_free(alloc, ne_la_data->mLi);
+    pm_allocator_free(alloc, ne_la_data->mLx);
+    pm_allocator_free(alloc, ne_la_data->mUp);
+    pm_allocator_free(alloc, ne_la_data->mUi);
+    pm_allocator_free(alloc, ne_la_data->mUx);
+
     ne_la_data->mSparsityPatternPtr = NULL;
     pm_allocator_free(alloc, ne_la_data);
     pm_allocator_free(alloc, ne_la);
+#ifdef NESL_LA_PROFILE
+    rtw_linalg_profile_destroy((NeslLaProfile*)alloc);
+#endif
+}
+
+/*
+ * Sparse LU factorization
+ *
+ * Large Jacobians with few nonzeros per column are factored as
+ * P*A*Q = L*U with L (unit lower triangular) and U stored by columns.  When
+ * the linear algebra is created, a maximum transversal matches every column
+ * to a row with a structural nonzero, which serves as the diagonal, and Q is
+ * a minimum degree ordering of the pattern of A+A' with rows renamed by that
+ * matching.  The first factorization chooses the row pivots with threshold
+ * partial pivoting, preferring the matched row, and thereby fixes the
+ * patterns of L and U.  Later factorizations recompute the
+ * values on these patterns and only pivot again when a pivot has become too
+ * small.
+ */
+
+/* Systems with fewer unknowns always use the dense factorization */
+#ifndef NESL_LA_SPARSE_MIN_SIZE
+#define NESL_LA_SPARSE_MIN_SIZE 100
+#endif
+
+/* A pivot must be at least this fraction of the largest candidate.  Smaller
+ * values keep more matched rows as pivots and so less fill-in, at the cost of
+ * element growth in unsymmetric systems with zero diagonals. */
+#ifndef NESL_LA_SPARSE_PIVOT_TOL
+#define NESL_LA_SPARSE_PIVOT_TOL 0.1
+#endif
+
+/* Reallocate one of the factors to hold at least need entries, keeping the
+ * first used entries. */
+PMF_DEPLOY_STATIC boolean_T rtw_linalg_sparse_grow(PmAllocator* alloc,
+                                                   int32_T**    idx,
+                                                   real_T**     val,
+                                                   int32_T*     capacity,
+                                                   int32_T      used,
+                                                   int32_T      need)
+{
+    int32_T  newCapacity = (need > 2 * (*capacity)) ? need : 2 * (*capacity);
+    int32_T* newIdx =
+        (int32_T*)pm_allocator_alloc(alloc, sizeof(int32_T), newCapacity);
+    real_T* newVal =
+        (real_T*)pm_allocator_alloc(alloc, sizeof(real_T), newCapacity);
+
+    if (newIdx == NULL || newVal == NULL) {
+        pm_allocator_free(alloc, newIdx);
+        pm_allocator_free(alloc, newVal);
+        return false;
+    }
+    memcpy(newIdx, *idx, (size_t)used * sizeof(int32_T));
+    memcpy(newVal, *val, (size_t)used * sizeof(real_T));
+    pm_allocator_free(alloc, *idx);
+    pm_allocator_free(alloc, *val);
+    *idx      = newIdx;
+    *val      = newVal;
+    *capacity = newCapacity;
+    return true;
+}
+
+/* Maximum transversal: match the columns of A to distinct rows holding a
+ * structural nonzero by augmenting paths.  rowCol[i] receives the column
+ * matched to row i.  Rows left unmatched in a structurally singular matrix
+ * are assigned to the unmatched columns in order. */
+PMF_DEPLOY_STATIC void rtw_linalg_sparse_match(PmAllocator*             alloc,
+                                               const PmSparsityPattern* pattern,
+                                               int32_T*                 rowCol)
+{
+    int32_T        n     = (int32_T)pattern->mNumCol;
+    const int32_T* Jc    = pattern->mJc;
+    const int32_T* Ir    = pattern->mIr;
+    int32_T*       iw    = (int32_T*)pm_allocator_alloc(alloc, sizeof(int32_T), 5 * n);
+    int32_T*       cheap = iw;         /* next entry to try for a free row */
+    int32_T*       visit = iw + n;     /* path on which a column was seen  */
+    int32_T*       js    = iw + 2 * n; /* columns on the search path       */
+    int32_T*       is    = iw + 3 * n; /* rows on the search path          */
+    int32_T*       ps    = iw + 4 * n; /* next entry to search per column  */
+    int32_T        head, i, j, k, p;
+    boolean_T      found;
+
+    for (j = 0; j < n; j++) {
+        cheap[j]  = Jc[j];
+        visit[j]  = -1;
+        rowCol[j] = -1;
+    }
+
+    for (k = 0; k < n; k++) {
+        found = false;
+        i     = -1;
+        head  = 0;
+        js[0] = k;
+        while (head >= 0) {
+            j = js[head];
+            if (visit[j] != k) {
+                visit[j] = k;
+                for (p = cheap[j]; p < Jc[j + 1] && !found; p++) {
+                    i     = Ir[p];
+                    found = (boolean_T)(rowCol[i] == -1);
+                }
+                cheap[j] = p;
+                if (found) {
+                    is[head] = i;
+                    break;
+                }
+                ps[head] = Jc[j];
+            }
+            for (p = ps[head]; p < Jc[j + 1]; p++) {
+                i = Ir[p];
+                if (visit[rowCol[i]] == k) {
+                    continue;
+                }
+                ps[head]   = p + 1;
+                is[head]   = i;
+                js[++head] = rowCol[i];
+                break;
+            }
+            if (p == Jc[j + 1]) {
+                head--;
+            }
+        }
+        if (found) {
+            for (p = head; p >= 0; p--) {
+                rowCol[is[p]] = js[p];
+            }
+        }
+    }
+
+    /* Complete the matching if A is structurally singular */
+    for (j = 0; j < n; j++) {
+        visit[j] = 0;
+    }
+    for (i = 0; i < n; i++) {
+        if (rowCol[i] >= 0) {
+            visit[rowCol[i]] = 1;
+        }
+    }
+    for (i = 0, j = 0; i < n; i++) {
+        if (rowCol[i] < 0) {
+            while (visit[j]) {
+                j++;
+            }
+            rowCol[i] = j++;
+        }
+    }
+
+    pm_allocator_free(alloc, iw);
+}
+
+/* Minimum degree ordering of the pattern of A+A' (diagonal ignored).  The
+ * elimination graph is kept explicitly: eliminating a node connects all of
+ * its neighbours.  Row i of A is taken as row rowCol[i], so that matched
+ * entries are on the diagonal.  perm[k] receives the node eliminated at step
+ * k.  Returns
+ * the number of off-diagonal nonzeros of the Cholesky factor of the
+ * permuted A+A', an estimate of the size of L and U. */
+PMF_DEPLOY_STATIC int32_T rtw_linalg_sparse_order(
+    PmAllocator*             alloc,
+    const PmSparsityPattern* pattern,
+    const int32_T*           rowCol,
+    int32_T*                 perm)
+{
+    int32_T        n    = (int32_T)pattern->mNumCol;
+    const int32_T* Jc   = pattern->mJc;
+    const int32_T* Ir   = pattern->mIr;
+    int32_T**      adj  = (int32_T**)pm_allocator_alloc(alloc, sizeof(int32_T*), n);
+    int32_T*       iw   = (int32_T*)pm_allocator_alloc(alloc, sizeof(int32_T), 6 * n);
+    int32_T*       len  = iw;         /* neighbours of each node          */
+    int32_T*       cap  = iw + n;     /* allocated length of adj[i]       */
+    int32_T*       head = iw + 2 * n; /* first node of each degree bucket */
+    int32_T*       next = iw + 3 * n;
+    int32_T*       prev = iw + 4 * n;
+    int32_T*       seen = iw + 5 * n;
+    int32_T        nz   = 0;
+    int32_T        tag  = n;
+    int32_T        minDeg = 0;
+    int32_T        i, j, k, p, q, r, m, u, v, x;
+
+    /* Adjacency lists of A+A' */
+    for (j = 0; j < n; j++) {
+        for (p = Jc[j]; p < Jc[j + 1]; p++) {
+            if (rowCol[Ir[p]] != j) {
+                cap[rowCol[Ir[p]]]++;
+                cap[j]++;
+            }
+        }
+    }
+    for (i = 0; i < n; i++) {
+        cap[i] = (cap[i] > 0) ? cap[i] : 1;
+        adj[i] = (int32_T*)pm_allocator_alloc(alloc, sizeof(int32_T), cap[i]);
+        head[i] = -1;
+        seen[i] = -1;
+    }
+    for (j = 0; j < n; j++) {
+        for (p = Jc[j]; p < Jc[j + 1]; p++) {
+            i = rowCol[Ir[p]];
+            if (i != j) {
+                adj[j][len[j]++] = i;
+                adj[i][len[i]++] = j;
+            }
+        }
+    }
+
+    /* Remove duplicates and sort the nodes into degree buckets */
+    for (i = 0; i < n; i++) {
+        m = 0;
+        for (q = 0; q < len[i]; q++) {
+            x = adj[i][q];
+            if (seen[x] != i) {
+                seen[x]     = i;
+                adj[i][m++] = x;
+            }
+        }
+        len[i]  = m;
+        prev[i] = -1;
+        next[i] = head[m];
+        if (next[i] >= 0) {
+            prev[next[i]] = i;
+        }
+        head[m] = i;
+    }
+
+    for (k = 0; k < n; k++) {
+        while (head[minDeg] < 0) {
+            minDeg++;
+        }
+
+        /* Eliminate a node of minimum degree */
+        v          = head[minDeg];
+        head[minDeg] = next[v];
+        if (next[v] >= 0) {
+            prev[next[v]] = -1;
+        }
+        perm[k] = v;
+        nz      = (nz < MAX_int32_T - len[v]) ? nz + len[v] : MAX_int32_T;
+
+        for (q = 0; q < len[v]; q++) {
+            u = adj[v][q];
+            tag++;
+
+            /* Drop v from the neighbours of u ... */
+            m = 0;
+            for (r = 0; r < len[u]; r++) {
+                x = adj[u][r];
+                if (x != v) {
+                    adj[u][m++] = x;
+                    seen[x]     = tag;
+                }
+            }
+            seen[u] = tag;
+
+            /* ... and connect u to the other neighbours of v */
+            if (m + len[v] > cap[u]) {
+                int32_T  newCap = (m + len[v] > 2 * cap[u]) ? m + len[v] : 2 * cap[u];
+                int32_T* newAdj =
+                    (int32_T*)pm_allocator_alloc(alloc, sizeof(int32_T), newCap);
+                memcpy(newAdj, adj[u], (size_t)m * sizeof(int32_T));
+                pm_allocator_free(alloc, adj[u]);
+                adj[u] = newAdj;
+                cap[u] = newCap;
+            }
+            for (r = 0; r < len[v]; r++) {
+                x = adj[v][r];
+                if (seen[x] != tag) {
+                    adj[u][m++] = x;
+                    seen[x]     = tag;
+                }
+            }
+
+            /* Move u to the bucket of its new degree */
+            if (prev[u] >= 0) {
+                next[prev[u]] = next[u];
+            } else {
+                head[len[u]] = next[u];
+            }
+            if (next[u] >= 0) {
+                prev[next[u]] = prev[u];
+            }
+            len[u]  = m;
+            prev[u] = -1;
+            next[u] = head[m];
+            if (next[u] >= 0) {
+                prev[next[u]] = u;
+            }
+            head[m] = u;
+            minDeg  = (m < minDeg) ? m : minDeg;
+        }
+        pm_allocator_free(alloc, adj[v]);
+        adj[v] = NULL;
+    }
+
+    pm_allocator_free(alloc, iw);
+    pm_allocator_free(alloc, adj);
+    return nz;
+}
+
+/* Find the pattern of x = L\A(:,col) during the factorization: the rows
+ * reachable from the rows of A(:,col) in the graph of L, stored in
+ * topological order in xi[top..n-1].  Returns top. */
+PMF_DEPLOY_STATIC int32_T rtw_linalg_sparse_reach(McLinearAlgebraData* ne_la_data,
+                                                  int32_T              col,
+                                                  int32_T              stamp)
+{
+    int32_T        n      = ne_la_data->mNumCol;
+    const int32_T* Jc     = ne_la_data->mSparsityPatternPtr->mJc;
+    const int32_T* Ir     = ne_la_data->mSparsityPatternPtr->mIr;
+    const int32_T* pinv   = ne_la_data->mRowPermInv;
+    const int32_T* Lp     = ne_la_data->mLp;
+    const int32_T* Li     = ne_la_data->mLi;
+    int32_T*       xi     = ne_la_data->mIntWork;
+    int32_T*       pstack = xi + n;
+    int32_T*       mark   = xi + 2 * n;
+    int32_T        top    = n;
+    int32_T        head, i, j, J, p, pEnd;
+    boolean_T      done;
+
+    for (p = Jc[col]; p < Jc[col + 1]; p++) {
+        if (mark[Ir[p]] == stamp) {
+            continue;
+        }
+
+        /* Depth-first search from row Ir[p]; the stack shares xi with the
+         * result since together they never hold more than n rows */
+        head  = 0;
+        xi[0] = Ir[p];
+        while (head >= 0) {
+            j = xi[head];
+            J = pinv[j];
+            if (mark[j] != stamp) {
+                mark[j]      = stamp;
+                pstack[head] = (J < 0) ? 0 : Lp[J] + 1;
+            }
+            done = true;
+            pEnd = (J < 0) ? 0 : Lp[J + 1];
+            for (i = pstack[head]; i < pEnd; i++) {
+                if (mark[Li[i]] != stamp) {
+                    pstack[head] = i + 1;
+                    xi[++head]   = Li[i];
+                    done         = false;
+                    break;
+                }
+            }
+            if (done) {
+                head--;
+                xi[--top] = j;
+            }
+        }
+    }
+    return top;
+}
+
+/* Factor A(:,Q) with threshold partial pivoting, choosing the row
+ * permutation and the patterns of L and U. */
+PMF_DEPLOY_STATIC McLinearAlgebraStatus
+rtw_linalg_sparse_factor(McLinearAlgebraData* ne_la_data, const real_T* Ax)
+{
+    int32_T        n    = ne_la_data->mNumCol;
+    const int32_T* Jc   = ne_la_data->mSparsityPatternPtr->mJc;
+    const int32_T* Ir   = ne_la_data->mSparsityPatternPtr->mIr;
+    const int32_T* Q    = ne_la_data->mColPerm;
+    int32_T*       pinv = ne_la_data->mRowPermInv;
+    int32_T*       Lp   = ne_la_data->mLp;
+    int32_T*       Up   = ne_la_data->mUp;
+    int32_T*       xi   = ne_la_data->mIntWork;
+    int32_T*       mark = xi + 2 * n;
+    real_T*        x    = ne_la_data->mLinvB;
+    int32_T        lnz  = 0;
+    int32_T        unz  = 0;
+    int32_T        i, k, p, q, col, diag, top, ipiv, nL, nU;
+    real_T         a, t, pivot, xj;
+
+    ne_la_data->mHaveFactor = false;
+    for (i = 0; i < n; i++) {
+        pinv[i] = -1;
+        mark[i] = -1;
+        x[i]    = 0.0;
+    }
+
+    for (k = 0; k < n; k++) {
+        col   = Q[k];
+        Lp[k] = lnz;
+        Up[k] = unz;
+        top   = rtw_linalg_sparse_reach(ne_la_data, col, k);
+
+        /* Rows already pivotal go to U, the others and the pivot to L */
+        nU = 1;
+        for (p = top; p < n; p++) {
+            nU += (pinv[xi[p]] >= 0);
+        }
+        nL = n - top - nU + 1;
+        if ((lnz + nL > ne_la_data->mLCapacity &&
+             !rtw_linalg_sparse_grow(ne_la_data->mAllocatorPtr,
+                                     &ne_la_data->mLi,
+                                     &ne_la_data->mLx,
+                                     &ne_la_data->mLCapacity,
+                                     lnz,
+                                     lnz + nL)) ||
+            (unz + nU > ne_la_data->mUCapacity &&
+             !rtw_linalg_sparse_grow(ne_la_data->mAllocatorPtr,
+                                     &ne_la_data->mUi,
+                                     &ne_la_data->mUx,
+                                     &ne_la_data->mUCapacity,
+                                     unz,
+                                     unz + nU))) {
+            return MC_LA_ERROR; /* out of memory */
+        }
+
+        /* x = L\A(:,col) */
+        for (p = Jc[col]; p < Jc[col + 1]; p++) {
+            x[Ir[p]] = Ax[p];
+        }
+        for (p = top; p < n; p++) {
+            if (pinv[xi[p]] >= 0) {
+                xj = x[xi[p]];
+                for (q = Lp[pinv[xi[p]]] + 1; q < Lp[pinv[xi[p]] + 1]; q++) {
+                    x[ne_la_data->mLi[q]] -= ne_la_data->mLx[q] * xj;
+                }
+            }
+        }
+
+        /* The largest entry in a row not yet pivotal is the pivot, unless
+         * the matched row is large enough */
+        ipiv = -1;
+        a    = -1.0;
+        for (p = top; p < n; p++) {
+            i = xi[p];
+            if (pinv[i] < 0) {
+                t = fabs(x[i]);
+                if (t > a) {
+                    a    = t;
+                    ipiv = i;
+                }
+            } else {
+                ne_la_data->mUi[unz]   = pinv[i];
+                ne_la_data->mUx[unz++] = x[i];
+            }
+        }
+        if (ipiv == -1 || a <= 0.0) {
+            return MC_LA_ERROR; /* matrix singular */
+        }
+        diag = ne_la_data->mDiagRow[col];
+        if (pinv[diag] < 0 && fabs(x[diag]) >= a * NESL_LA_SPARSE_PIVOT_TOL) {
+            ipiv = diag;
+        }
+
+        pivot                  = x[ipiv];
+        ne_la_data->mUi[unz]   = k;
+        ne_la_data->mUx[unz++] = pivot;
+        pinv[ipiv]             = k;
+        ne_la_data->mLi[lnz]   = ipiv;
+        ne_la_data->mLx[lnz++] = 1.0;
+        for (p = top; p < n; p++) {
+            i = xi[p];
+            if (pinv[i] < 0) {
+                ne_la_data->mLi[lnz]   = i;
+                ne_la_data->mLx[lnz++] = x[i] / pivot;
+            }
+            x[i] = 0.0;
+        }
+    }
+    Lp[n] = lnz;
+    Up[n] = unz;
+
+    /* Number the rows of L by pivot step, as the rows of U */
+    for (p = 0; p < lnz; p++) {
+        ne_la_data->mLi[p] = pinv[ne_la_data->mLi[p]];
+    }
+    ne_la_data->mHaveFactor = true;
+    return MC_LA_OK;
+}
+
+/* Recompute L and U on the patterns and with the pivots of the previous
+ * factorization.  Returns false if a pivot became too small. */
+PMF_DEPLOY_STATIC boolean_T rtw_linalg_sparse_refactor(McLinearAlgebraData* ne_la_data,
+                                                       const real_T*        Ax)
+{
+    int32_T        n    = ne_la_data->mNumCol;
+    const int32_T* Jc   = ne_la_data->mSparsityPatternPtr->mJc;
+    const int32_T* Ir   = ne_la_data->mSparsityPatternPtr->mIr;
+    const int32_T* Q    = ne_la_data->mColPerm;
+    const int32_T* pinv = ne_la_data->mRowPermInv;
+    const int32_T* Lp   = ne_la_data->mLp;
+    const int32_T* Li   = ne_la_data->mLi;
+    real_T*        Lx   = ne_la_data->mLx;
+    const int32_T* Up   = ne_la_data->mUp;
+    const int32_T* Ui   = ne_la_data->mUi;
+    real_T*        Ux   = ne_la_data->mUx;
+    real_T*        x    = ne_la_data->mLinvB;
+    int32_T        i, j, k, p, q, col;
+    real_T         a, pivot, xj;
+
+    for (i = 0; i < n; i++) {
+        x[i] = 0.0;
+    }
+
+    for (k = 0; k < n; k++) {
+        col = Q[k];
+        for (p = Jc[col]; p < Jc[col + 1]; p++) {
+            x[pinv[Ir[p]]] = Ax[p];
+        }
+
+        /* U(:,k) in the topological order of the first factorization */
+        for (p = Up[k]; p < Up[k + 1] - 1; p++) {
+            j     = Ui[p];
+            xj    = x[j];
+            x[j]  = 0.0;
+            Ux[p] = xj;
+            for (q = Lp[j] + 1; q < Lp[j + 1]; q++) {
+                x[Li[q]] -= Lx[q] * xj;
+            }
+        }
+
+        pivot = x[k];
+        x[k]  = 0.0;
+        a     = 0.0;
+        for (q = Lp[k] + 1; q < Lp[k + 1]; q++) {
+            a = (fabs(x[Li[q]]) > a) ? fabs(x[Li[q]]) : a;
+        }
+        if (pivot == 0.0 || fabs(pivot) < a * NESL_LA_SPARSE_PIVOT_TOL) {
+            for (q = Lp[k] + 1; q < Lp[k + 1]; q++) {
+                x[Li[q]] = 0.0;
+            }
+            return false;
+        }
+
+        Ux[Up[k + 1] - 1] = pivot;
+        for (q = Lp[k] + 1; q < Lp[k + 1]; q++) {
+            Lx[q]    = x[Li[q]] / pivot;
+            x[Li[q]] = 0.0;
+        }
+    }
+    return true;
+}
+
+/*
+  Compute the matching and the ordering and allocate the factors with the
+  size estimated by the ordering.  The factors only grow during simulation if pivoting causes
+  more fill-in than estimated.
+ */
+PMF_DEPLOY_STATIC McLinearAlgebraData*
+rtw_linalg_sparse_create_data(PmAllocator*             allocatorPtr,
+                              const PmSparsityPattern* jacobian_pattern_ptr)
+{
+    McLinearAlgebraData* ne_la_data = (McLinearAlgebraData*)pm_allocator_alloc(
+        allocatorPtr, sizeof(McLinearAlgebraData), 1);
+    int32_T n = (int32_T)jacobian_pattern_ptr->mNumCol;
+    int32_T i, nz;
+
+    ne_la_data->mSparsityPatternPtr = jacobian_pattern_ptr;
+    ne_la_data->mNumRow             = (int32_T)jacobian_pattern_ptr->mNumRow;
+    ne_la_data->mNumCol             = n;
+    ne_la_data->mAllocatorPtr       = allocatorPtr;
+    ne_la_data->mLinvB =
+        (real_T*)pm_allocator_alloc(allocatorPtr, sizeof(real_T), n);
+    ne_la_data->mColPerm =
+        (int32_T*)pm_allocator_alloc(allocatorPtr, sizeof(int32_T), n);
+    ne_la_data->mDiagRow =
+        (int32_T*)pm_allocator_alloc(allocatorPtr, sizeof(int32_T), n);
+    ne_la_data->mRowPermInv =
+        (int32_T*)pm_allocator_alloc(allocatorPtr, sizeof(int32_T), n);
+    ne_la_data->mIntWork =
+        (int32_T*)pm_allocator_alloc(allocatorPtr, sizeof(int32_T), 3 * n);
+    ne_la_data->mLp =
+        (int32_T*)pm_allocator_alloc(allocatorPtr, sizeof(int32_T), n + 1);
+    ne_la_data->mUp =
+        (int32_T*)pm_allocator_alloc(allocatorPtr, sizeof(int32_T), n + 1);
+
+    /* Match the rows, using mRowPermInv as row-to-column map, then order */
+    rtw_linalg_sparse_match(
+        allocatorPtr, jacobian_pattern_ptr, ne_la_data->mRowPermInv);
+    for (i = 0; i < n; i++) {
+        ne_la_data->mDiagRow[ne_la_data->mRowPermInv[i]] = i;
+    }
+    nz = rtw_linalg_sparse_order(allocatorPtr,
+                                 jacobian_pattern_ptr,
+                                 ne_la_data->mRowPermInv,
+                                 ne_la_data->mColPerm);
+    nz = (nz < MAX_int32_T - n) ? nz + n : MAX_int32_T;
+
+    ne_la_data->mLCapacity = nz;
+    ne_la_data->mLi =
+        (int32_T*)pm_allocator_alloc(allocatorPtr, sizeof(int32_T), nz);
+    ne_la_data->mLx = (real_T*)pm_allocator_alloc(allocatorPtr, sizeof(real_T), nz);
+    ne_la_data->mUCapacity = nz;
+    ne_la_data->mUi =
+        (int32_T*)pm_allocator_alloc(allocatorPtr, sizeof(int32_T), nz);
+    ne_la_data->mUx = (real_T*)pm_allocator_alloc(allocatorPtr, sizeof(real_T), nz);
+    ne_la_data->mHaveFactor = false;
+    return ne_la_data;
+}
+
+/* Perform the sparse LU factorization */
+PMF_DEPLOY_STATIC McLinearAlgebraStatus
+rtw_linalg_sparse_numeric(McLinearAlgebra* ne_la, const real_T* Ax)
+{
+    McLinearAlgebraData* ne_la_data = ne_la->mPrivateData;
+
+    if (ne_la_data->mHaveFactor) {
+        if (rtw_linalg_sparse_refactor(ne_la_data, Ax)) {
+            NESL_LA_PROFILE_COUNT(ne_la_data, mNumRefactor);
+            return MC_LA_OK;
+        }
+        NESL_LA_PROFILE_COUNT(ne_la_data, mNumRepivot);
+    }
+    return rtw_linalg_sparse_factor(ne_la_data, Ax);
+}
+
+/* solve: sparse forward & back substitution */
+PMF_DEPLOY_STATIC McLinearAlgebraStatus
+rtw_linalg_sparse_solve(McLinearAlgebra* ne_la,
+                        const real_T*    Ax /*not used*/,
+                        real_T*          dy,
+                        const real_T*    B)
+{
+    McLinearAlgebraData* ne_la_data = ne_la->mPrivateData;
+    int32_T              n          = ne_la_data->mNumCol;
+    const int32_T*       Lp         = ne_la_data->mLp;
+    const int32_T*       Li         = ne_la_data->mLi;
+    const real_T*        Lx         = ne_la_data->mLx;
+    const int32_T*       Up         = ne_la_data->mUp;
+    const int32_T*       Ui         = ne_la_data->mUi;
+    const real_T*        Ux         = ne_la_data->mUx;
+    real_T*              y          = ne_la_data->mLinvB;
+    int32_T              i, j, p;
+    real_T               yj;
+
+    for (i = 0; i < n; i++) {
+        y[ne_la_data->mRowPermInv[i]] = B[i];
+    }
+    for (j = 0; j < n; j++) {
+        yj = y[j];
+        if (yj != 0.0) {
+            for (p = Lp[j] + 1; p < Lp[j + 1]; p++) {
+                y[Li[p]] -= Lx[p] * yj;
+            }
+        }
+    }
+    for (j = n - 1; j >= 0; j--) {
+        y[j] /= Ux[Up[j + 1] - 1];
+        yj = y[j];
+        if (yj != 0.0) {
+            for (p = Up[j]; p < Up[j + 1] - 1; p++) {
+                y[Ui[p]] -= Ux[p] * yj;
+            }
+        }
+    }
+    for (j = 0; j < n; j++) {
+        dy[ne_la_data->mColPerm[j]] = y[j];
+    }
+    UNUSED_PARAMETER(Ax);
+    return MC_LA_OK;
+}
+
+PMF_DEPLOY_STATIC
+size_t rtw_linalg_sparse_memusage(const McLinearAlgebra* ne_la)
+{
+    const McLinearAlgebraData* ne_la_data = ne_la->mPrivateData;
+    const size_t               n          = (size_t)ne_la_data->mNumCol;
+
+    return sizeof(*ne_la) + sizeof(*ne_la_data) + n * sizeof(real_T) +
+           (8 * n + 2) * sizeof(int32_T) +
+           ((size_t)ne_la_data->mLCapacity + (size_t)ne_la_data->mUCapacity) *
+               (sizeof(int32_T) + sizeof(real_T));
+}
+
+/* Use the sparse factorization for large Jacobians that are sparse enough,
+ * see create_auto_linear_algebra_complete */
+PMF_DEPLOY_STATIC boolean_T rtw_linalg_prefer_full(const PmSparsityPattern* pattern)
+{
+    real_T N   = (real_T)pattern->mNumCol;
+    real_T nnz = (real_T)pattern->mJc[pattern->mNumCol];
+
+    return (N <= 20.0 || (N <= 100.0 && nnz / N > 0.1125 * N - 1.25) ||
+            (N > 100 && nnz / N > 0.277 * N - 17.7));
+}
+
+PMF_DEPLOY_STATIC boolean_T rtw_linalg_use_sparse(const PmSparsityPattern* pattern)
+{
+    return pattern->mNumRow == pattern->mNumCol &&
+           pattern->mNumCol >= NESL_LA_SPARSE_MIN_SIZE &&
+           !rtw_linalg_prefer_full(pattern);
 }
 
 PMF_DEPLOY_STATIC McLinearAlgebraStatus
@@ -210,19 +1127,38 @@ create_rtw_linear_algebra_complete(const McLinearAlgebraFactory* factory,
                                    const PmSparsityPattern*      pattern,
                                    size_t                        nPerm)
 {
-    PmAllocator*     alloc = pm_default_allocator();
+#ifdef NESL_LA_PROFILE
+    NeslLaProfile*   prof  = rtw_linalg_profile_create(NESL_DEFAULT_ALLOCATOR());
+    PmAllocator*     alloc = &prof->mAllocator;
+#else
+    PmAllocator*     alloc = NESL_DEFAULT_ALLOCATOR();
+#endif
     McLinearAlgebra* la =
         (McLinearAlgebra*)pm_allocator_alloc(alloc, sizeof(McLinearAlgebra), 1);
 
     (void)factory;
     (void)nPerm;
 
-    la->mPrivateData = rtw_linalg_create_data(alloc, pattern);
-    la->mFactor      = &rtw_linalg_numeric;
-    la->mSolve       = &rtw_linalg_solve;
-    la->mCondest     = NULL;
-    la->mMemusage    = &rtw_linalg_memusage;
-    la->mDestructor  = &rtw_linalg_destroy;
+    if (rtw_linalg_use_sparse(pattern)) {
+        la->mPrivateData = rtw_linalg_sparse_create_data(alloc, pattern);
+        la->mFactor      = &rtw_linalg_sparse_numeric;
+        la->mSolve       = &rtw_linalg_sparse_solve;
+        la->mMemusage    = &rtw_linalg_sparse_memusage;
+    } else {
+        la->mPrivateData = rtw_linalg_create_data(alloc, pattern);
+        la->mFactor      = &rtw_linalg_numeric;
+        la->mSolve       = &rtw_linalg_solve;
+        la->mMemusage    = &rtw_linalg_memusage;
+    }
+    la->mCondest    = NULL;
+    la->mDestructor = &rtw_linalg_destroy;
+#ifdef NESL_LA_PROFILE
+    prof->mSparse = rtw_linalg_use_sparse(pattern);
+    prof->mFactor = la->mFactor;
+    prof->mSolve  = la->mSolve;
+    la->mFactor   = &rtw_linalg_profile_factor;
+    la->mSolve    = &rtw_linalg_profile_solve;
+#endif
 
     *linAlg = la;
 
@@ -261,13 +1197,10 @@ create_auto_linear_algebra_complete(const McLinearAlgebraFactory* factory,
     const McLinearAlgebraFactory* sparse_la = mc_get_csparse_linear_algebra();
     const McLinearAlgebraFactory* full_la   = get_rtw_linear_algebra();
     McLinearAlgebraStatus         result;
-    real_T                        N   = (real_T)pattern->mNumCol;
-    real_T                        nnz = (real_T)pattern->mJc[pattern->mNumCol];
 
     (void)factory;
 
-    if (N <= 20.0 || (N <= 100.0 && nnz / N > 0.1125 * N - 1.25) ||
-        (N > 100 && nnz / N > 0.277 * N - 17.7)) {
+    if (rtw_linalg_prefer_full(pattern)) {
         result = full_la->mCreateLinearAlgebraComplete(
             full_la, linAlg, pattern, nPerm);
     } else {
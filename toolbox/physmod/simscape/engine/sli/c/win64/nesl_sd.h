@@ -24,6 +24,12 @@
     }
 #endif
 
+/* Allocator used by default, a target may route it to an arena, see
+ * pm_arena_allocator.h */
+#ifndef NESL_DEFAULT_ALLOCATOR
+#define NESL_DEFAULT_ALLOCATOR() pm_default_allocator()
+#endif
+
 #define LOCAL_SIM_DATA_FUNCTION(_name, _type)        \
     PMF_DEPLOY_STATIC _type* local_sim_data_##_name( \
         const NeslSimulationData* sd)                \
@@ -37,7 +43,7 @@ NESL_SIM_DATA_PATTERN_MACRO(LOCAL_SIM_DATA_FUNCTION)
 
 PMF_DEPLOY_STATIC void local_sim_data_destroy(NeslSimulationData* sd)
 {
-    PmAllocator* a = pm_default_allocator();
+    PmAllocator* a = NESL_DEFAULT_ALLOCATOR();
     pm_allocator_free(a, sd->mData);
     pm_allocator_free(a, sd);
 }
@@ -47,7 +53,7 @@ PMF_DEPLOY_STATIC void local_sim_data_destroy(NeslSimulationData* sd)
 
 PMF_DEPLOY_STATIC NeslSimulationData* nesl_create_simulation_data(void)
 {
-    PmAllocator*        a        = pm_default_allocator();
+    PmAllocator*        a        = NESL_DEFAULT_ALLOCATOR();
     NeslSimulationData* sim_data = (NeslSimulationData*)pm_allocator_alloc(
         a, sizeof(NeslSimulationData), 1);
     NeslSimulationDataData* data = (NeslSimulationDataData*)pm_allocator_alloc(